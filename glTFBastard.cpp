@@ -14,8 +14,27 @@ LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRA
 IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
 #include <memory>
+#include <mutex>
 #include <sstream>
+#include <thread>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #include "json-parser/json.h"
 #include "glTFBastard.h"
 
@@ -423,6 +442,7 @@ namespace glTFBastard {
 			{ 5121, Accessor::COMPONENT_TYPE_UNSIGNED_BYTE },
 			{ 5122, Accessor::COMPONENT_TYPE_SHORT },
 			{ 5123, Accessor::COMPONENT_TYPE_UNSIGNED_SHORT },
+			{ 5125, Accessor::COMPONENT_TYPE_UNSIGNED_INT },
 			{ 5126, Accessor::COMPONENT_TYPE_FLOAT }
 		};
 
@@ -1113,8 +1133,103 @@ namespace glTFBastard {
 		return true;
 	}
 
-	// Parses an entire glTF json document.
-	std::unique_ptr<const glTF> Parse(const char* jsonString, size_t size, std::string& outErr) {
+	// How the buffers of a document that is loaded from disk are read.
+	struct BufferLoadContext {
+		std::string baseDirectory;
+
+		// The body of a binary container is already in memory and is not read again.
+		bool binaryContainer;
+
+		std::shared_ptr<BufferSource> source;
+	};
+
+	static void StartBufferLoads(const BufferLoadContext& context, glTF* doc);
+
+	// Parses the sections of a glTF json document into the specified document.
+	// If a load context is specified buffers start loading as soon as their section has been converted.
+	static bool ParseDocument(const json_value& rootElement, const BufferLoadContext* loadContext, glTF* result, std::string& outErr) {
+		if (!ParseOptionalElement(rootElement["cameras"], "glTF.cameras", &result->cameras, outErr)) {
+			return false;
+		}
+
+		if (!ParseOptionalElement(rootElement["buffers"], "glTF.buffers", &result->buffers, outErr)) {
+			return false;
+		}
+
+		if (loadContext) {
+			StartBufferLoads(*loadContext, result);
+		}
+
+		if (!ParseOptionalElement(rootElement["bufferViews"], "glTF.bufferViews", &result->bufferViews, outErr)) {
+			return false;
+		}
+
+		if (!ParseOptionalElement(rootElement["accessors"], "glTF.accessors", &result->accessors, outErr)) {
+			return false;
+		}
+
+		if (!ParseOptionalElement(rootElement["meshes"], "glTF.meshes", &result->meshes, outErr)) {
+			return false;
+		}
+
+		if (!ParseOptionalElement(rootElement["shaders"], "glTF.shaders", &result->shaders, outErr)) {
+			return false;
+		}
+
+		if (!ParseOptionalElement(rootElement["programs"], "glTF.programs", &result->programs, outErr)) {
+			return false;
+		}
+
+		if (!ParseOptionalElement(rootElement["materials"], "glTF.materials", &result->materials, outErr)) {
+			return false;
+		}
+
+		if (!ParseOptionalElement(rootElement["techniques"], "glTF.techniques", &result->techniques, outErr)) {
+			return false;
+		}
+
+		if (!ParseOptionalElement(rootElement["samplers"], "glTF.samplers", &result->samplers, outErr)) {
+			return false;
+		}
+
+		if (!ParseOptionalElement(rootElement["images"], "glTF.images", &result->images, outErr)) {
+			return false;
+		}
+
+		if (!ParseOptionalElement(rootElement["textures"], "glTF.textures", &result->textures, outErr)) {
+			return false;
+		}
+
+		if (!ParseOptionalElement(rootElement["animations"], "glTF.animations", &result->animations, outErr)) {
+			return false;
+		}
+
+		if (!ParseOptionalElement(rootElement["skins"], "glTF.skins", &result->skins, outErr)) {
+			return false;
+		}
+
+		if (!ParseOptionalElement(rootElement["nodes"], "glTF.nodes", &result->nodes, outErr)) {
+			return false;
+		}
+
+		if (!ParseOptionalElement(rootElement["scenes"], "glTF.scenes", &result->scenes, outErr)) {
+			return false;
+		}
+
+		if (!ParseOptionalElement(rootElement["scene"], "glTF.scene", &result->scene, outErr)) {
+			return false;
+		}
+
+		return true;
+	}
+
+	// Parses a glTF json string into a new document.
+	static std::unique_ptr<glTF> ParseJson(
+		const char* jsonString,
+		size_t size,
+		const BufferLoadContext* loadContext,
+		std::string& outErr) {
+
 		// Parse the json string.
 		json_value* rootElement;
 		{
@@ -1133,74 +1248,593 @@ namespace glTFBastard {
 		}
 
 		std::unique_ptr<glTF> result(new glTF());
-		if (!ParseOptionalElement((*rootElement)["cameras"], "glTF.cameras", &result->cameras, outErr)) {
+		bool succeeded = ParseDocument(*rootElement, loadContext, result.get(), outErr);
+		json_value_free(rootElement);
+
+		if (!succeeded) {
 			return nullptr;
 		}
 
-		if (!ParseOptionalElement((*rootElement)["buffers"], "glTF.buffers", &result->buffers, outErr)) {
+		return result;
+	}
+
+	// Parses an entire glTF json document.
+	std::unique_ptr<glTF> Parse(const char* jsonString, size_t size, std::string& outErr) {
+		return ParseJson(jsonString, size, nullptr, outErr);
+	}
+
+	const char* const BINARY_GLTF_BUFFER_ID = "binary_glTF";
+
+	// Layout of the header at the start of a binary glTF container.
+	static const size_t BINARY_HEADER_SIZE = 20;
+	static const uint32_t BINARY_MAGIC = 0x46546C67; // 'glTF'
+	static const uint32_t BINARY_VERSION = 1;
+	static const uint32_t BINARY_CONTENT_FORMAT_JSON = 0;
+
+	// Reads a little endian 32 bit unsigned integer.
+	static uint32_t ReadUInt32(const unsigned char* data) {
+		return static_cast<uint32_t>(data[0])
+			| (static_cast<uint32_t>(data[1]) << 8)
+			| (static_cast<uint32_t>(data[2]) << 16)
+			| (static_cast<uint32_t>(data[3]) << 24);
+	}
+
+	// Returns true if the data starts with the binary glTF magic.
+	static bool IsBinaryContainer(const unsigned char* data, size_t size) {
+		return size >= 4 && ReadUInt32(data) == BINARY_MAGIC;
+	}
+
+	// Parses a binary glTF container whose memory is kept alive by the specified storage.
+	static std::unique_ptr<glTF> ParseBinaryContainer(
+		const std::shared_ptr<const unsigned char>& storage,
+		size_t size,
+		const BufferLoadContext* loadContext,
+		std::string& outErr) {
+
+		const unsigned char* data = storage.get();
+		if (size < BINARY_HEADER_SIZE || !IsBinaryContainer(data, size)) {
+			outErr = "The data is not a binary glTF container.";
 			return nullptr;
 		}
 
-		if (!ParseOptionalElement((*rootElement)["bufferViews"], "glTF.bufferViews", &result->bufferViews, outErr)) {
+		uint32_t version = ReadUInt32(data + 4);
+		uint32_t length = ReadUInt32(data + 8);
+		uint32_t contentLength = ReadUInt32(data + 12);
+		uint32_t contentFormat = ReadUInt32(data + 16);
+
+		if (version != BINARY_VERSION) {
+			std::stringstream ss;
+			ss << "Unsupported binary glTF version '" << version << "'.";
+			outErr = ss.str();
 			return nullptr;
 		}
 
-		if (!ParseOptionalElement((*rootElement)["accessors"], "glTF.accessors", &result->accessors, outErr)) {
+		if (contentFormat != BINARY_CONTENT_FORMAT_JSON) {
+			std::stringstream ss;
+			ss << "Unsupported binary glTF content format '" << contentFormat << "'.";
+			outErr = ss.str();
 			return nullptr;
 		}
 
-		if (!ParseOptionalElement((*rootElement)["meshes"], "glTF.meshes", &result->meshes, outErr)) {
+		if (length < BINARY_HEADER_SIZE || length > size || contentLength > length - BINARY_HEADER_SIZE) {
+			outErr = "The binary glTF container is truncated.";
 			return nullptr;
 		}
 
-		if (!ParseOptionalElement((*rootElement)["shaders"], "glTF.shaders", &result->shaders, outErr)) {
+		std::unique_ptr<glTF> result = ParseJson(
+			reinterpret_cast<const char*>(data + BINARY_HEADER_SIZE), contentLength, loadContext, outErr);
+
+		if (!result) {
 			return nullptr;
 		}
 
-		if (!ParseOptionalElement((*rootElement)["programs"], "glTF.programs", &result->programs, outErr)) {
-			return nullptr;
+		// The body is everything that follows the content. Alias the storage so that the
+		// buffer references the body in place while keeping the whole container alive.
+		// The header check above guarantees that the body offset does not exceed the length.
+		size_t bodyOffset = BINARY_HEADER_SIZE + contentLength;
+		long long bodyLength = static_cast<long long>(length) - static_cast<long long>(bodyOffset);
+
+		std::unique_ptr<Buffer>& body = result->buffers[BINARY_GLTF_BUFFER_ID];
+		if (!body) {
+			body.reset(new Buffer());
+			body->byteLength = bodyLength;
 		}
 
-		if (!ParseOptionalElement((*rootElement)["materials"], "glTF.materials", &result->materials, outErr)) {
+		if (body->byteLength > bodyLength) {
+			std::stringstream ss;
+			ss << "The binary glTF body is " << bodyLength << " bytes but '"
+				<< BINARY_GLTF_BUFFER_ID << "' declares " << body->byteLength << " bytes.";
+			outErr = ss.str();
 			return nullptr;
 		}
 
-		if (!ParseOptionalElement((*rootElement)["techniques"], "glTF.techniques", &result->techniques, outErr)) {
+		if (body->byteLength == 0) {
+			body->byteLength = bodyLength;
+		}
+
+		body->data = std::shared_ptr<const unsigned char>(storage, data + bodyOffset);
+		return result;
+	}
+
+	// Parses a binary glTF container that is owned by the caller.
+	std::unique_ptr<glTF> ParseBinary(const void* data, size_t size, std::string& outErr) {
+		std::shared_ptr<const unsigned char> storage(
+			static_cast<const unsigned char*>(data), [](const unsigned char*) {});
+
+		return ParseBinaryContainer(storage, size, nullptr, outErr);
+	}
+
+	// Memory maps an entire file for reading. The file is unmapped once the returned pointer and all of its copies are destroyed.
+	static std::shared_ptr<const unsigned char> MapFile(const std::string& path, size_t* outSize, std::string& outErr) {
+		static const unsigned char emptyFile[1] = { 0 };
+
+#ifdef _WIN32
+		HANDLE file = CreateFileA(
+			path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+		if (file == INVALID_HANDLE_VALUE) {
+			outErr = "Could not open file '" + path + "'.";
 			return nullptr;
 		}
 
-		if (!ParseOptionalElement((*rootElement)["samplers"], "glTF.samplers", &result->samplers, outErr)) {
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(file, &fileSize)) {
+			CloseHandle(file);
+			outErr = "Could not get the size of file '" + path + "'.";
 			return nullptr;
 		}
 
-		if (!ParseOptionalElement((*rootElement)["images"], "glTF.images", &result->images, outErr)) {
+		*outSize = static_cast<size_t>(fileSize.QuadPart);
+		if (*outSize == 0) {
+			CloseHandle(file);
+			return std::shared_ptr<const unsigned char>(&emptyFile[0], [](const unsigned char*) {});
+		}
+
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		CloseHandle(file);
+
+		if (!mapping) {
+			outErr = "Could not map file '" + path + "'.";
 			return nullptr;
 		}
 
-		if (!ParseOptionalElement((*rootElement)["textures"], "glTF.textures", &result->textures, outErr)) {
+		void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		CloseHandle(mapping);
+
+		if (!view) {
+			outErr = "Could not map file '" + path + "'.";
 			return nullptr;
 		}
 
-		if (!ParseOptionalElement((*rootElement)["animations"], "glTF.animations", &result->animations, outErr)) {
+		return std::shared_ptr<const unsigned char>(
+			static_cast<const unsigned char*>(view),
+			[](const unsigned char* p) { UnmapViewOfFile(p); });
+#else
+		int file = open(path.c_str(), O_RDONLY);
+		if (file < 0) {
+			outErr = "Could not open file '" + path + "'.";
 			return nullptr;
 		}
 
-		if (!ParseOptionalElement((*rootElement)["skins"], "glTF.skins", &result->skins, outErr)) {
+		struct stat fileStat;
+		if (fstat(file, &fileStat) != 0) {
+			close(file);
+			outErr = "Could not get the size of file '" + path + "'.";
 			return nullptr;
 		}
 
-		if (!ParseOptionalElement((*rootElement)["nodes"], "glTF.nodes", &result->nodes, outErr)) {
+		size_t size = static_cast<size_t>(fileStat.st_size);
+		*outSize = size;
+		if (size == 0) {
+			close(file);
+			return std::shared_ptr<const unsigned char>(&emptyFile[0], [](const unsigned char*) {});
+		}
+
+		void* view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+		close(file);
+
+		if (view == MAP_FAILED) {
+			outErr = "Could not map file '" + path + "'.";
 			return nullptr;
 		}
 
-		if (!ParseOptionalElement((*rootElement)["scenes"], "glTF.scenes", &result->scenes, outErr)) {
+		// Buffers are typically consumed front to back right after loading.
+		madvise(view, size, MADV_WILLNEED);
+
+		return std::shared_ptr<const unsigned char>(
+			static_cast<const unsigned char*>(view),
+			[size](const unsigned char* p) { munmap(const_cast<unsigned char*>(p), size); });
+#endif
+	}
+
+	// Memory maps an entire file for reading.
+	BufferContents MapBufferFile(const std::string& path) {
+		BufferContents result;
+		result.data = MapFile(path, &result.size, result.error);
+		return result;
+	}
+
+	static std::mutex bufferSourceMutex;
+	static std::shared_ptr<BufferSource> bufferSource;
+
+	// Sets the buffer source used by subsequent loads.
+	void SetBufferSource(const std::shared_ptr<BufferSource>& source) {
+		std::lock_guard<std::mutex> lock(bufferSourceMutex);
+		bufferSource = source;
+	}
+
+	static std::shared_ptr<BufferSource> GetBufferSource() {
+		std::lock_guard<std::mutex> lock(bufferSourceMutex);
+		return bufferSource;
+	}
+
+	// Decodes a base64 string; returns false if it contains invalid characters.
+	static bool DecodeBase64(const char* encoded, size_t length, std::vector<unsigned char>* out) {
+		static const signed char* decodeTable = [] {
+			static signed char table[256];
+			memset(table, -1, sizeof(table));
+
+			const char* alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+			for (int i = 0; i < 64; ++i) {
+				table[static_cast<unsigned char>(alphabet[i])] = static_cast<signed char>(i);
+			}
+
+			return table;
+		}();
+
+		out->clear();
+		out->reserve(length / 4 * 3);
+
+		uint32_t accumulator = 0;
+		int bits = 0;
+		for (size_t i = 0; i < length; ++i) {
+			unsigned char c = static_cast<unsigned char>(encoded[i]);
+			if (c == '=') {
+				break;
+			}
+
+			signed char value = decodeTable[c];
+			if (value < 0) {
+				return false;
+			}
+
+			accumulator = (accumulator << 6) | static_cast<uint32_t>(value);
+			bits += 6;
+			if (bits >= 8) {
+				bits -= 8;
+				out->push_back(static_cast<unsigned char>(accumulator >> bits));
+			}
+		}
+
+		return true;
+	}
+
+	// Returns the directory portion of a path including the trailing separator.
+	static std::string GetDirectory(const std::string& path) {
+		size_t separator = path.find_last_of("/\\");
+		return separator == std::string::npos ? std::string() : path.substr(0, separator + 1);
+	}
+
+	// Touches every page of a memory mapped range so that it is read from disk now rather than on first use.
+	static void PrefetchPages(const unsigned char* data, size_t size) {
+		static const size_t PREFETCH_STRIDE = 4096;
+
+		volatile unsigned char sink = 0;
+		for (size_t offset = 0; offset < size; offset += PREFETCH_STRIDE) {
+			sink ^= data[offset];
+		}
+
+		(void)sink;
+	}
+
+	// Decodes the payload of a data uri; on failure returns false with the reason in outReason.
+	static bool DecodeDataUri(const std::string& uri, BufferContents* out, std::string& outReason) {
+		size_t comma = uri.find(',');
+		if (comma == std::string::npos) {
+			outReason = "is malformed";
+			return false;
+		}
+
+		std::shared_ptr<std::vector<unsigned char>> decoded(new std::vector<unsigned char>());
+		const char* payload = uri.c_str() + comma + 1;
+		size_t payloadLength = uri.size() - comma - 1;
+
+		if (uri.rfind(";base64", comma) != std::string::npos) {
+			if (!DecodeBase64(payload, payloadLength, decoded.get())) {
+				outReason = "is not valid base64";
+				return false;
+			}
+		}
+		else {
+			decoded->assign(payload, payload + payloadLength);
+		}
+
+		// Keep the data pointer non-null even for empty contents so that they count as loaded.
+		decoded->reserve(1);
+		out->size = decoded->size();
+		out->data = std::shared_ptr<const unsigned char>(decoded, decoded->data());
+		return true;
+	}
+
+	// Reads the contents that a uri refers to.
+	BufferContents ReadUriContents(const std::string& baseDirectory, const std::string& uri) {
+		if (uri.compare(0, 5, "data:") != 0) {
+			return MapBufferFile(baseDirectory + uri);
+		}
+
+		BufferContents result;
+		std::string reason;
+		if (!DecodeDataUri(uri, &result, reason)) {
+			result.error = "The data uri " + reason + ".";
+		}
+
+		return result;
+	}
+
+	// Reads the contents of a buffer from its uri, which is either a data uri or a path relative to the document.
+	// The contents are read and shared through the buffer source if there is one.
+	static BufferContents ReadBufferContents(
+		BufferSource* source,
+		const std::string& baseDirectory,
+		const std::string& bufferName,
+		const std::string& uri,
+		long long byteLength) {
+
+		BufferContents result;
+		if (uri.compare(0, 5, "data:") == 0) {
+			std::string reason;
+			if (!DecodeDataUri(uri, &result, reason)) {
+				result.error = "The data uri of buffer '" + bufferName + "' " + reason + ".";
+				return result;
+			}
+
+			if (source) {
+				result = source->Share(result);
+			}
+		}
+		else {
+			result = source ? source->ReadFile(baseDirectory + uri) : MapBufferFile(baseDirectory + uri);
+			if (!result.data) {
+				return result;
+			}
+
+			PrefetchPages(result.data.get(), result.size);
+		}
+
+		if (static_cast<long long>(result.size) < byteLength) {
+			std::stringstream ss;
+			ss << "Buffer '" << bufferName << "' declares " << byteLength
+				<< " bytes but only " << result.size << " bytes were loaded.";
+			result.error = ss.str();
+			result.data.reset();
+		}
+
+		return result;
+	}
+
+	// A buffer of a document that is waiting to be read by the background loader.
+	struct BufferLoadTask {
+		std::string baseDirectory;
+		std::shared_ptr<BufferSource> source;
+		std::string name;
+		std::string uri;
+		long long byteLength;
+		std::promise<BufferContents> promise;
+	};
+
+	// Buffers are read by a few threads so that several files can be in flight at once.
+	static const size_t MAX_BUFFER_LOAD_THREADS = 4;
+
+	// A process wide queue of buffer reads served by a fixed number of threads, however many documents are loading.
+	// The tasks own everything they need, so documents may be destroyed while their reads are still in flight.
+	class BufferLoader {
+	public:
+		BufferLoader() :
+			shuttingDown(false) {
+
+			for (size_t i = 0; i < MAX_BUFFER_LOAD_THREADS; ++i) {
+				threads.push_back(std::thread(&BufferLoader::ThreadMain, this));
+			}
+		}
+
+		~BufferLoader() {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				shuttingDown = true;
+			}
+
+			wakeThreads.notify_all();
+			for (auto& thread : threads) {
+				thread.join();
+			}
+		}
+
+		void Enqueue(std::vector<std::unique_ptr<BufferLoadTask>>& newTasks) {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				for (auto& task : newTasks) {
+					tasks.push_back(std::move(task));
+				}
+			}
+
+			wakeThreads.notify_all();
+		}
+
+	private:
+		void ThreadMain() {
+			for (;;) {
+				std::unique_ptr<BufferLoadTask> task;
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					wakeThreads.wait(lock, [this] { return shuttingDown || !tasks.empty(); });
+					if (shuttingDown) {
+						return;
+					}
+
+					task = std::move(tasks.front());
+					tasks.pop_front();
+				}
+
+				task->promise.set_value(ReadBufferContents(
+					task->source.get(), task->baseDirectory, task->name, task->uri, task->byteLength));
+			}
+		}
+
+		std::vector<std::thread> threads;
+		std::deque<std::unique_ptr<BufferLoadTask>> tasks;
+		std::mutex mutex;
+		std::condition_variable wakeThreads;
+		bool shuttingDown;
+	};
+
+	// Returns the process wide buffer loader; it is created on first use.
+	static BufferLoader& GetBufferLoader() {
+		static BufferLoader loader;
+		return loader;
+	}
+
+	// Starts reading every buffer of the document that has not been loaded in the background.
+	static void StartBufferLoads(const BufferLoadContext& context, glTF* doc) {
+		std::vector<std::unique_ptr<BufferLoadTask>> tasks;
+		for (auto& entry : doc->buffers) {
+			Buffer& buffer = *entry.second;
+			if (buffer.data || buffer.pendingData.valid() || (context.binaryContainer && entry.first == BINARY_GLTF_BUFFER_ID)) {
+				continue;
+			}
+
+			std::unique_ptr<BufferLoadTask> task(new BufferLoadTask());
+			task->baseDirectory = context.baseDirectory;
+			task->source = context.source;
+			task->name = entry.first;
+			task->uri = buffer.uri;
+			task->byteLength = buffer.byteLength;
+			buffer.pendingData = task->promise.get_future().share();
+			tasks.push_back(std::move(task));
+		}
+
+		if (!tasks.empty()) {
+			GetBufferLoader().Enqueue(tasks);
+		}
+	}
+
+	// Loads a document from disk and starts loading its buffers in the background.
+	std::unique_ptr<glTF> LoadAsync(const std::string& path, std::string& outErr) {
+		size_t size = 0;
+		std::shared_ptr<const unsigned char> file = MapFile(path, &size, outErr);
+		if (!file) {
 			return nullptr;
 		}
 
-		if (!ParseOptionalElement((*rootElement)["scene"], "glTF.scene", &result->scene, outErr)) {
+		BufferLoadContext context;
+		context.baseDirectory = GetDirectory(path);
+		context.binaryContainer = IsBinaryContainer(file.get(), size);
+		context.source = GetBufferSource();
+
+		if (!context.binaryContainer) {
+			return ParseJson(reinterpret_cast<const char*>(file.get()), size, &context, outErr);
+		}
+
+		std::unique_ptr<glTF> result = ParseBinaryContainer(file, size, &context, outErr);
+		if (result && context.source) {
+			Buffer& body = *result->buffers[BINARY_GLTF_BUFFER_ID];
+			BufferContents contents;
+			contents.data = body.data;
+			contents.size = static_cast<size_t>(body.byteLength);
+			body.data = context.source->Share(contents).data;
+		}
+
+		return result;
+	}
+
+	// Loads an entire document from disk along with the contents of all of its buffers.
+	std::unique_ptr<glTF> Load(const std::string& path, std::string& outErr) {
+		std::unique_ptr<glTF> result = LoadAsync(path, outErr);
+		if (!result || !WaitForBuffers(result.get(), outErr)) {
 			return nullptr;
 		}
 
-		return std::move(result);
+		return result;
+	}
+
+	// Blocks until a buffer that is loading in the background is ready.
+	bool WaitForBuffer(glTF* doc, const std::string& bufferId, std::string& outErr) {
+		auto itr = doc->buffers.find(bufferId);
+		if (itr == doc->buffers.end()) {
+			outErr = "The buffer '" + bufferId + "' does not exist.";
+			return false;
+		}
+
+		Buffer& buffer = *itr->second;
+		if (buffer.data || !buffer.pendingData.valid()) {
+			return true;
+		}
+
+		const BufferContents& contents = buffer.pendingData.get();
+		if (!contents.error.empty()) {
+			outErr = contents.error;
+			return false;
+		}
+
+		buffer.data = contents.data;
+		if (buffer.byteLength == 0) {
+			buffer.byteLength = static_cast<long long>(contents.size);
+		}
+
+		buffer.pendingData = std::shared_future<BufferContents>();
+		return true;
+	}
+
+	// Waits for every buffer of the document.
+	bool WaitForBuffers(glTF* doc, std::string& outErr) {
+		for (auto& entry : doc->buffers) {
+			if (!WaitForBuffer(doc, entry.first, outErr)) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	// Gets the bytes of a loaded buffer that a buffer view refers to.
+	bool GetBufferViewData(const glTF& doc, const BufferView& bufferView, ByteSpan* out, std::string& outErr) {
+		auto itr = doc.buffers.find(bufferView.buffer);
+		if (itr == doc.buffers.end()) {
+			outErr = "The buffer '" + bufferView.buffer + "' does not exist.";
+			return false;
+		}
+
+		const Buffer& buffer = *itr->second;
+		const unsigned char* data = buffer.data.get();
+		long long bufferLength = buffer.byteLength;
+
+		// Buffers that are still loading in the background are waited for but left for WaitForBuffer to resolve,
+		// so that a const document can be read from several threads.
+		if (!data && buffer.pendingData.valid()) {
+			const BufferContents& contents = buffer.pendingData.get();
+			if (!contents.error.empty()) {
+				outErr = contents.error;
+				return false;
+			}
+
+			data = contents.data.get();
+			if (bufferLength == 0) {
+				bufferLength = static_cast<long long>(contents.size);
+			}
+		}
+
+		if (!data) {
+			outErr = "The buffer '" + bufferView.buffer + "' has not been loaded.";
+			return false;
+		}
+
+		// A byteLength of zero is treated as the remainder of the buffer.
+		long long byteLength = bufferView.byteLength ? bufferView.byteLength : bufferLength - bufferView.byteOffset;
+		if (bufferView.byteOffset < 0 || byteLength < 0 || bufferView.byteOffset + byteLength > bufferLength) {
+			outErr = "A buffer view is out of the range of buffer '" + bufferView.buffer + "'.";
+			return false;
+		}
+
+		*out = ByteSpan(data + bufferView.byteOffset, static_cast<size_t>(byteLength));
+		return true;
 	}
 }
\ No newline at end of file
@@ -17,6 +17,9 @@ IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #ifndef GLTF_BASTARD_H
 #define GLTF_BASTARD_H
 
+#include <cstring>
+#include <future>
+#include <memory>
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -57,6 +60,33 @@ namespace glTFBastard {
 		}
 	};
 
+	// A read-only view of a contiguous range of bytes.
+	struct ByteSpan {
+		const unsigned char* data;
+		size_t size;
+
+		ByteSpan() :
+			data(nullptr),
+			size(0) {
+		}
+
+		ByteSpan(const unsigned char* data, size_t size) :
+			data(data),
+			size(size) {
+		}
+	};
+
+	// The result of reading the contents of a buffer in the background.
+	struct BufferContents {
+		std::shared_ptr<const unsigned char> data;
+		size_t size;
+		std::string error;
+
+		BufferContents() :
+			size(0) {
+		}
+	};
+
 	struct Buffer {
 		enum Type {
 			TYPE_ARRAY_BUFFER,
@@ -67,6 +97,14 @@ namespace glTFBastard {
 		Type type;
 		std::string uri;
 
+		// The contents of the buffer; null until the buffer has been loaded.
+		// This may point directly into a memory mapped file which stays mapped for as long as this pointer is alive.
+		std::shared_ptr<const unsigned char> data;
+
+		// Set by LoadAsync while the contents are still being read in the background.
+		// GetBufferViewData blocks on it when data is null and WaitForBuffer moves the result into data.
+		std::shared_future<BufferContents> pendingData;
+
 		Buffer() :
 			type(TYPE_ARRAY_BUFFER),
 			byteLength(0) {
@@ -98,6 +136,7 @@ namespace glTFBastard {
 			COMPONENT_TYPE_UNSIGNED_BYTE = 5121,
 			COMPONENT_TYPE_SHORT = 5122,
 			COMPONENT_TYPE_UNSIGNED_SHORT = 5123,
+			COMPONENT_TYPE_UNSIGNED_INT = 5125, // Indices only; OES_element_index_uint.
 			COMPONENT_TYPE_FLOAT = 5126
 		};
 
@@ -403,7 +442,62 @@ namespace glTFBastard {
 		std::string scene;
 	};
 
-	std::unique_ptr<const glTF> Parse(const char* jsonString, size_t size, std::string& outErr);
+	// The id of the buffer that refers to the body of a binary glTF container.
+	extern const char* const BINARY_GLTF_BUFFER_ID;
+
+	// Parses a glTF json document. Buffer contents are not loaded.
+	std::unique_ptr<glTF> Parse(const char* jsonString, size_t size, std::string& outErr);
+
+	// Parses a binary glTF container (KHR_binary_glTF).
+	// The body is exposed as the 'binary_glTF' buffer without being copied; the caller must keep
+	// the source memory alive for as long as the document is in use.
+	std::unique_ptr<glTF> ParseBinary(const void* data, size_t size, std::string& outErr);
+
+	// Memory maps an entire file for reading; the file stays mapped for as long as the returned data is alive.
+	BufferContents MapBufferFile(const std::string& path);
+
+	// Reads the contents that a uri refers to: the decoded payload of a data uri, or the memory mapped file at the
+	// uri relative to the base directory, which should end in a separator.
+	BufferContents ReadUriContents(const std::string& baseDirectory, const std::string& uri);
+
+	// Lets Load and LoadAsync share buffer contents between documents, for example through a cache.
+	// Implementations are called from the background loader threads and must be thread-safe.
+	class BufferSource {
+	public:
+		virtual ~BufferSource() {}
+
+		// Reads an external buffer file, typically with MapBufferFile.
+		virtual BufferContents ReadFile(const std::string& path) = 0;
+
+		// Returns contents equal to those of an embedded buffer (a data uri or binary glTF body) that the
+		// document should use instead, which may be the contents passed in.
+		virtual BufferContents Share(const BufferContents& contents) = 0;
+	};
+
+	// Sets the buffer source used by subsequent loads; null goes back to every document reading its own buffers.
+	void SetBufferSource(const std::shared_ptr<BufferSource>& source);
+
+	// Loads a .gltf or .glb document from disk and loads the contents of all of its buffers.
+	// Binary containers and external buffer files are memory mapped rather than read.
+	std::unique_ptr<glTF> Load(const std::string& path, std::string& outErr);
+
+	// Loads a .gltf or .glb document from disk like Load, but returns as soon as the json has been parsed.
+	// The whole json text is tokenized before any section is converted; external buffers start loading in the
+	// background as soon as the buffers section has been converted, so only the conversion of the remaining sections
+	// overlaps the reads. Consumers only block on the buffers they use. The reads of every document are served by
+	// a few process wide loader threads.
+	std::unique_ptr<glTF> LoadAsync(const std::string& path, std::string& outErr);
+
+	// Blocks until a buffer that is loading in the background is ready and moves its contents into Buffer::data.
+	// Returns false if the buffer does not exist or could not be loaded.
+	bool WaitForBuffer(glTF* doc, const std::string& bufferId, std::string& outErr);
+
+	// Waits for every buffer of the document; see above.
+	bool WaitForBuffers(glTF* doc, std::string& outErr);
+
+	// Gets the bytes of a loaded buffer that a buffer view refers to.
+	// Blocks if the buffer is still loading in the background.
+	bool GetBufferViewData(const glTF& doc, const BufferView& bufferView, ByteSpan* out, std::string& outErr);
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,150 @@
+/*
+Copyright (c) 2016 Ruben Cashie
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation 
+files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, 
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software 
+is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES 
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE 
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <sstream>
+#include "glTFBastardAccessor.h"
+
+namespace glTFBastard {
+
+	// Resolves the buffer view and buffer of an accessor and validates that all of its elements are in range.
+	bool GetAccessorData(const glTF& doc, const Accessor& accessor, AccessorData* out, std::string& outErr) {
+		auto viewItr = doc.bufferViews.find(accessor.bufferView);
+		if (viewItr == doc.bufferViews.end()) {
+			outErr = "The buffer view '" + accessor.bufferView + "' does not exist.";
+			return false;
+		}
+
+		ByteSpan viewData;
+		if (!GetBufferViewData(doc, *viewItr->second, &viewData, outErr)) {
+			return false;
+		}
+
+		size_t componentCount = GetComponentCount(accessor.type);
+		size_t componentSize = GetComponentSize(accessor.componentType);
+		size_t elementSize = componentCount * componentSize;
+		if (!elementSize) {
+			outErr = "An accessor of buffer view '" + accessor.bufferView + "' has an unsupported type.";
+			return false;
+		}
+
+		if (accessor.byteOffset < 0 || accessor.count < 0 || accessor.byteStride < 0) {
+			outErr = "An accessor of buffer view '" + accessor.bufferView + "' has a negative offset, stride or count.";
+			return false;
+		}
+
+		size_t byteStride = accessor.byteStride ? static_cast<size_t>(accessor.byteStride) : elementSize;
+		if (byteStride < elementSize) {
+			std::stringstream ss;
+			ss << "An accessor of buffer view '" << accessor.bufferView << "' has a byteStride of " << byteStride
+				<< " which is smaller than its element size of " << elementSize << ".";
+			outErr = ss.str();
+			return false;
+		}
+
+		size_t byteOffset = static_cast<size_t>(accessor.byteOffset);
+		size_t count = static_cast<size_t>(accessor.count);
+		if (count && (byteOffset + elementSize > viewData.size
+			|| count - 1 > (viewData.size - byteOffset - elementSize) / byteStride)) {
+			outErr = "An accessor is out of the range of buffer view '" + accessor.bufferView + "'.";
+			return false;
+		}
+
+		out->data = viewData.data + byteOffset;
+		out->byteStride = byteStride;
+		out->count = count;
+		out->componentType = accessor.componentType;
+		out->type = accessor.type;
+		return true;
+	}
+
+	// Resolves an accessor by id.
+	bool GetAccessorData(const glTF& doc, const std::string& accessorId, AccessorData* out, std::string& outErr) {
+		auto itr = doc.accessors.find(accessorId);
+		if (itr == doc.accessors.end()) {
+			outErr = "The accessor '" + accessorId + "' does not exist.";
+			return false;
+		}
+
+		return GetAccessorData(doc, *itr->second, out, outErr);
+	}
+
+	const char* const ACCESSOR_DECODE_SUFFIX = "_decode";
+
+	// Looks up the decode transform of an accessor.
+	bool GetAccessorDecode(
+		const glTF& doc,
+		const std::string& accessorId,
+		std::vector<float>* outOffset,
+		std::vector<float>* outScale,
+		std::string& outErr) {
+
+		outOffset->clear();
+		outScale->clear();
+
+		// Float accessors are never quantized, whatever else the document happens to contain.
+		auto itr = doc.accessors.find(accessorId);
+		if (itr == doc.accessors.end() || itr->second->componentType == Accessor::COMPONENT_TYPE_FLOAT) {
+			return true;
+		}
+
+		std::string decodeId = accessorId + ACCESSOR_DECODE_SUFFIX;
+		if (!doc.accessors.count(decodeId)) {
+			return true;
+		}
+
+		AccessorData decode;
+		if (!GetAccessorData(doc, decodeId, &decode, outErr)) {
+			return false;
+		}
+
+		size_t componentCount = GetComponentCount(itr->second->type);
+		if (decode.componentType != Accessor::COMPONENT_TYPE_FLOAT || decode.type != itr->second->type || decode.count != 2) {
+			outErr = "The accessor '" + decodeId + "' does not hold an offset and a scale.";
+			return false;
+		}
+
+		outOffset->resize(componentCount);
+		outScale->resize(componentCount);
+		memcpy(outOffset->data(), decode.data, componentCount * sizeof(float));
+		memcpy(outScale->data(), decode.data + decode.byteStride, componentCount * sizeof(float));
+		return true;
+	}
+
+	// Decodes components in place.
+	void DecodeComponents(
+		const std::vector<float>& offset,
+		const std::vector<float>& scale,
+		size_t count,
+		float* const* components) {
+
+		for (size_t c = 0; c < offset.size(); ++c) {
+			float* component = components[c];
+			for (size_t i = 0; i < count; ++i) {
+				component[i] = offset[c] + component[i] * scale[c];
+			}
+		}
+	}
+
+	// Gives a new copy of an accessor the decode accessor of its original.
+	void CopyAccessorDecode(glTF* doc, const std::string& sourceId, const std::string& copyId) {
+		auto decode = doc->accessors.find(sourceId + ACCESSOR_DECODE_SUFFIX);
+		std::string copyDecodeId = copyId + ACCESSOR_DECODE_SUFFIX;
+		if (decode != doc->accessors.end() && !doc->accessors.count(copyDecodeId)) {
+			std::unique_ptr<Accessor> copy(new Accessor(*decode->second));
+			doc->accessors[copyDecodeId] = std::move(copy);
+		}
+	}
+}
@@ -0,0 +1,284 @@
+/*
+Copyright (c) 2016 Ruben Cashie
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation 
+files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, 
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software 
+is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES 
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE 
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef GLTF_BASTARD_ACCESSOR_H
+#define GLTF_BASTARD_ACCESSOR_H
+
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include "glTFBastard.h"
+
+namespace glTFBastard {
+
+	// The resolved memory layout of an accessor within a loaded buffer.
+	struct AccessorData {
+		const unsigned char* data;
+		size_t byteStride;
+		size_t count;
+		Accessor::ComponentType componentType;
+		Accessor::Type type;
+
+		AccessorData() :
+			data(nullptr),
+			byteStride(0),
+			count(0),
+			componentType(Accessor::COMPONENT_TYPE_BYTE),
+			type(Accessor::TYPE_SCALAR) {
+		}
+	};
+
+	// Returns the number of components in an element of the specified type.
+	inline size_t GetComponentCount(Accessor::Type type) {
+		switch (type) {
+			case Accessor::TYPE_SCALAR: return 1;
+			case Accessor::TYPE_VEC2: return 2;
+			case Accessor::TYPE_VEC3: return 3;
+			case Accessor::TYPE_VEC4: return 4;
+			case Accessor::TYPE_MAT2: return 4;
+			case Accessor::TYPE_MAT3: return 9;
+			case Accessor::TYPE_MAT4: return 16;
+		}
+
+		return 0;
+	}
+
+	// Returns the size in bytes of a single component of the specified type.
+	inline size_t GetComponentSize(Accessor::ComponentType componentType) {
+		switch (componentType) {
+			case Accessor::COMPONENT_TYPE_BYTE:
+			case Accessor::COMPONENT_TYPE_UNSIGNED_BYTE: return 1;
+			case Accessor::COMPONENT_TYPE_SHORT:
+			case Accessor::COMPONENT_TYPE_UNSIGNED_SHORT: return 2;
+			case Accessor::COMPONENT_TYPE_UNSIGNED_INT:
+			case Accessor::COMPONENT_TYPE_FLOAT: return 4;
+		}
+
+		return 0;
+	}
+
+	// Resolves the buffer view and buffer of an accessor and validates that all of its elements are in range.
+	// The buffer that the accessor refers to must have been loaded.
+	bool GetAccessorData(const glTF& doc, const Accessor& accessor, AccessorData* out, std::string& outErr);
+
+	// Resolves an accessor by id; see above.
+	bool GetAccessorData(const glTF& doc, const std::string& accessorId, AccessorData* out, std::string& outErr);
+
+	// Integer accessors that were quantized have a decode accessor with the id "<accessor id>_decode": a FLOAT accessor
+	// of the same type with two elements, the offset and then the scale. Each component decodes as offset + value * scale.
+	extern const char* const ACCESSOR_DECODE_SUFFIX;
+
+	// Looks up the decode transform of an accessor. The offset and scale are left empty if it has none.
+	bool GetAccessorDecode(
+		const glTF& doc,
+		const std::string& accessorId,
+		std::vector<float>* outOffset,
+		std::vector<float>* outScale,
+		std::string& outErr);
+
+	// Decodes components converted with ConvertAccessorToSoA in place; does nothing for an empty transform.
+	void DecodeComponents(
+		const std::vector<float>& offset,
+		const std::vector<float>& scale,
+		size_t count,
+		float* const* components);
+
+	// Gives a new copy of an accessor the decode accessor of its original, if it has one.
+	void CopyAccessorDecode(glTF* doc, const std::string& sourceId, const std::string& copyId);
+
+	// Maps a C++ component type to its Accessor::ComponentType.
+	template<typename T> struct ComponentTraits;
+
+	template<> struct ComponentTraits<int8_t> {
+		static const Accessor::ComponentType componentType = Accessor::COMPONENT_TYPE_BYTE;
+	};
+
+	template<> struct ComponentTraits<uint8_t> {
+		static const Accessor::ComponentType componentType = Accessor::COMPONENT_TYPE_UNSIGNED_BYTE;
+	};
+
+	template<> struct ComponentTraits<int16_t> {
+		static const Accessor::ComponentType componentType = Accessor::COMPONENT_TYPE_SHORT;
+	};
+
+	template<> struct ComponentTraits<uint16_t> {
+		static const Accessor::ComponentType componentType = Accessor::COMPONENT_TYPE_UNSIGNED_SHORT;
+	};
+
+	template<> struct ComponentTraits<uint32_t> {
+		static const Accessor::ComponentType componentType = Accessor::COMPONENT_TYPE_UNSIGNED_INT;
+	};
+
+	template<> struct ComponentTraits<float> {
+		static const Accessor::ComponentType componentType = Accessor::COMPONENT_TYPE_FLOAT;
+	};
+
+	// A single element of an accessor, copied out of the buffer.
+	template<typename T, size_t N> struct AccessorElement {
+		T components[N];
+
+		T& operator[](size_t index) {
+			return components[index];
+		}
+
+		const T& operator[](size_t index) const {
+			return components[index];
+		}
+	};
+
+	// A typed, read-only view of the elements of an accessor.
+	// Elements are loaded with memcpy, so views over unaligned or interleaved data are safe and a
+	// tightly packed view compiles down to plain loads.
+	template<typename T, size_t N> class AccessorView {
+	public:
+		typedef AccessorElement<T, N> Element;
+
+		class Iterator {
+		public:
+			typedef std::forward_iterator_tag iterator_category;
+			typedef Element value_type;
+			typedef ptrdiff_t difference_type;
+			typedef const Element* pointer;
+			typedef Element reference;
+
+			Iterator(const unsigned char* position, size_t byteStride) :
+				position(position),
+				byteStride(byteStride) {
+			}
+
+			Element operator*() const {
+				Element element;
+				memcpy(&element, position, sizeof(element));
+				return element;
+			}
+
+			Iterator& operator++() {
+				position += byteStride;
+				return *this;
+			}
+
+			Iterator operator++(int) {
+				Iterator previous(*this);
+				position += byteStride;
+				return previous;
+			}
+
+			bool operator==(const Iterator& other) const {
+				return position == other.position;
+			}
+
+			bool operator!=(const Iterator& other) const {
+				return position != other.position;
+			}
+
+		private:
+			const unsigned char* position;
+			size_t byteStride;
+		};
+
+		AccessorView() :
+			data(nullptr),
+			byteStride(sizeof(Element)),
+			count(0) {
+		}
+
+		// A byteStride of zero means the elements are tightly packed.
+		AccessorView(const unsigned char* data, size_t byteStride, size_t count) :
+			data(data),
+			byteStride(byteStride ? byteStride : sizeof(Element)),
+			count(count) {
+		}
+
+		explicit AccessorView(const AccessorData& accessorData) :
+			data(accessorData.data),
+			byteStride(accessorData.byteStride ? accessorData.byteStride : sizeof(Element)),
+			count(accessorData.count) {
+		}
+
+		// Returns true if the accessor data is made up of elements of this view's type.
+		static bool IsCompatible(const AccessorData& accessorData) {
+			return accessorData.componentType == ComponentTraits<T>::componentType
+				&& GetComponentCount(accessorData.type) == N;
+		}
+
+		size_t size() const {
+			return count;
+		}
+
+		size_t stride() const {
+			return byteStride;
+		}
+
+		Element operator[](size_t index) const {
+			Element element;
+			memcpy(&element, data + index * byteStride, sizeof(element));
+			return element;
+		}
+
+		// Reads a single component of an element.
+		T Get(size_t index, size_t component) const {
+			T value;
+			memcpy(&value, data + index * byteStride + component * sizeof(T), sizeof(T));
+			return value;
+		}
+
+		Iterator begin() const {
+			return Iterator(data, byteStride);
+		}
+
+		Iterator end() const {
+			return Iterator(data + count * byteStride, byteStride);
+		}
+
+	private:
+		const unsigned char* data;
+		size_t byteStride;
+		size_t count;
+	};
+
+	// Invokes the visitor with the AccessorView<T, N> that matches the type of the accessor data.
+	template<typename T, typename Visitor> bool VisitAccessorType(const AccessorData& accessorData, Visitor&& visitor) {
+		switch (accessorData.type) {
+			case Accessor::TYPE_SCALAR: visitor(AccessorView<T, 1>(accessorData)); return true;
+			case Accessor::TYPE_VEC2: visitor(AccessorView<T, 2>(accessorData)); return true;
+			case Accessor::TYPE_VEC3: visitor(AccessorView<T, 3>(accessorData)); return true;
+			case Accessor::TYPE_VEC4: visitor(AccessorView<T, 4>(accessorData)); return true;
+			case Accessor::TYPE_MAT2: visitor(AccessorView<T, 4>(accessorData)); return true;
+			case Accessor::TYPE_MAT3: visitor(AccessorView<T, 9>(accessorData)); return true;
+			case Accessor::TYPE_MAT4: visitor(AccessorView<T, 16>(accessorData)); return true;
+		}
+
+		return false;
+	}
+
+	// Picks the AccessorView<T, N> instantiation that matches the componentType and type of the accessor data
+	// and invokes the visitor with it once; the visitor needs a templated operator() to accept any view.
+	// Returns false if the accessor data has an unsupported componentType or type.
+	template<typename Visitor> bool VisitAccessor(const AccessorData& accessorData, Visitor&& visitor) {
+		switch (accessorData.componentType) {
+			case Accessor::COMPONENT_TYPE_BYTE: return VisitAccessorType<int8_t>(accessorData, visitor);
+			case Accessor::COMPONENT_TYPE_UNSIGNED_BYTE: return VisitAccessorType<uint8_t>(accessorData, visitor);
+			case Accessor::COMPONENT_TYPE_SHORT: return VisitAccessorType<int16_t>(accessorData, visitor);
+			case Accessor::COMPONENT_TYPE_UNSIGNED_SHORT: return VisitAccessorType<uint16_t>(accessorData, visitor);
+			case Accessor::COMPONENT_TYPE_UNSIGNED_INT: return VisitAccessorType<uint32_t>(accessorData, visitor);
+			case Accessor::COMPONENT_TYPE_FLOAT: return VisitAccessorType<float>(accessorData, visitor);
+		}
+
+		return false;
+	}
+}
+
+#endif
\ No newline at end of file
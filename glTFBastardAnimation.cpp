@@ -0,0 +1,714 @@
+/*
+Copyright (c) 2016 Ruben Cashie
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation 
+files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, 
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software 
+is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES 
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE 
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "glTFBastardAnimation.h"
+#include "glTFBastardAnimationCompression.h"
+#include "glTFBastardConvert.h"
+#include "glTFBastardMath.h"
+#include "glTFBastardParallel.h"
+#include "glTFBastardSimd.h"
+
+namespace glTFBastard {
+
+	// Finds the accessor that an animation parameter names.
+	static bool ResolveParameter(
+		const Animation& animation,
+		const std::string& animationId,
+		const std::string& parameter,
+		std::string* outAccessorId,
+		std::string& outErr) {
+
+		auto itr = animation.parameters.find(parameter);
+		if (itr == animation.parameters.end()) {
+			outErr = "The animation '" + animationId + "' has no parameter '" + parameter + "'.";
+			return false;
+		}
+
+		*outAccessorId = itr->second;
+		return true;
+	}
+
+	// Reads an accessor with the specified number of components into interleaved floats.
+	static bool ReadFloats(const glTF& doc, const std::string& accessorId, size_t componentCount, std::vector<float>* out, std::string& outErr) {
+		AccessorData data;
+		if (!GetAccessorData(doc, accessorId, &data, outErr)) {
+			return false;
+		}
+
+		if (GetComponentCount(data.type) != componentCount) {
+			outErr = "The accessor '" + accessorId + "' has " + std::to_string(GetComponentCount(data.type))
+				+ " components where " + std::to_string(componentCount) + " are expected.";
+			return false;
+		}
+
+		std::vector<float> components(data.count * componentCount);
+		float* componentPointers[4];
+		for (size_t c = 0; c < componentCount; ++c) {
+			componentPointers[c] = components.data() + c * data.count;
+		}
+
+		if (!ConvertAccessorToSoA(data, false, componentPointers, outErr)) {
+			return false;
+		}
+
+		out->resize(data.count * componentCount);
+		for (size_t i = 0; i < data.count; ++i) {
+			for (size_t c = 0; c < componentCount; ++c) {
+				(*out)[i * componentCount + c] = componentPointers[c][i];
+			}
+		}
+
+		return true;
+	}
+
+	// Reads the outputs of a sampler, decoding the UNSIGNED_SHORT encodings that CompressAnimations writes.
+	static bool ReadOutputs(
+		const glTF& doc,
+		const Animation& animation,
+		const std::string& animationId,
+		const std::string& parameter,
+		const std::string& accessorId,
+		AnimationTrack::Path path,
+		std::vector<float>* out,
+		std::string& outErr) {
+
+		size_t componentCount = path == AnimationTrack::PATH_ROTATION ? 4 : 3;
+		auto accessor = doc.accessors.find(accessorId);
+		if (accessor == doc.accessors.end() || accessor->second->componentType != Accessor::COMPONENT_TYPE_UNSIGNED_SHORT) {
+			return ReadFloats(doc, accessorId, componentCount, out, outErr);
+		}
+
+		AccessorData data;
+		if (!GetAccessorData(doc, accessorId, &data, outErr)) {
+			return false;
+		}
+
+		if (data.type != Accessor::TYPE_VEC3) {
+			outErr = "The accessor '" + accessorId + "' is not a quantized VEC3.";
+			return false;
+		}
+
+		AccessorView<uint16_t, 3> view(data);
+		out->resize(data.count * componentCount);
+		if (path == AnimationTrack::PATH_ROTATION) {
+			for (size_t i = 0; i < data.count; ++i) {
+				AccessorView<uint16_t, 3>::Element element = view[i];
+				DecodeSmallestThree(element.components, &(*out)[i * 4]);
+			}
+
+			return true;
+		}
+
+		// Translations and scales decode as offset + value * scale, with the offset and scale in another parameter.
+		std::string decodeId;
+		std::vector<float> decode;
+		if (!ResolveParameter(animation, animationId, parameter + "_decode", &decodeId, outErr)
+			|| !ReadFloats(doc, decodeId, 3, &decode, outErr)) {
+			return false;
+		}
+
+		if (decode.size() != 6) {
+			outErr = "The accessor '" + decodeId + "' does not hold an offset and a scale.";
+			return false;
+		}
+
+		for (size_t i = 0; i < data.count; ++i) {
+			AccessorView<uint16_t, 3>::Element element = view[i];
+			for (size_t c = 0; c < 3; ++c) {
+				(*out)[i * 3 + c] = decode[c] + element[c] * decode[3 + c];
+			}
+		}
+
+		return true;
+	}
+
+	bool LoadAnimationClip(const glTF& doc, const std::string& animationId, AnimationClip* out, std::string& outErr) {
+		out->tracks.clear();
+		out->startTime = 0.0f;
+		out->endTime = 0.0f;
+
+		auto animationItr = doc.animations.find(animationId);
+		if (animationItr == doc.animations.end()) {
+			outErr = "The animation '" + animationId + "' does not exist.";
+			return false;
+		}
+
+		const Animation& animation = *animationItr->second;
+		for (const std::unique_ptr<Animation::Channel>& channel : animation.channels) {
+			AnimationTrack track;
+			track.node = channel->target.id;
+
+			if (channel->target.path == "translation") {
+				track.path = AnimationTrack::PATH_TRANSLATION;
+			}
+			else if (channel->target.path == "rotation") {
+				track.path = AnimationTrack::PATH_ROTATION;
+			}
+			else if (channel->target.path == "scale") {
+				track.path = AnimationTrack::PATH_SCALE;
+			}
+			else {
+				outErr = "The animation '" + animationId + "' targets the unknown path '" + channel->target.path + "'.";
+				return false;
+			}
+
+			auto sampler = animation.samplers.find(channel->sampler);
+			if (sampler == animation.samplers.end()) {
+				outErr = "The animation '" + animationId + "' has no sampler '" + channel->sampler + "'.";
+				return false;
+			}
+
+			std::string inputId;
+			std::string outputId;
+			if (!ResolveParameter(animation, animationId, sampler->second->input, &inputId, outErr)
+				|| !ResolveParameter(animation, animationId, sampler->second->output, &outputId, outErr)) {
+				return false;
+			}
+
+			if (!ReadFloats(doc, inputId, 1, &track.times, outErr)
+				|| !ReadOutputs(doc, animation, animationId, sampler->second->output, outputId, track.path, &track.values, outErr)) {
+				return false;
+			}
+
+			if (track.times.empty() || track.values.size() != track.times.size() * track.GetComponentCount()) {
+				outErr = "The sampler '" + channel->sampler + "' of the animation '" + animationId
+					+ "' does not have one output per input.";
+				return false;
+			}
+
+			for (size_t k = 1; k < track.times.size(); ++k) {
+				if (!(track.times[k] >= track.times[k - 1])) {
+					outErr = "The input times of the sampler '" + channel->sampler + "' of the animation '" + animationId
+						+ "' are not in ascending order.";
+					return false;
+				}
+			}
+
+			if (out->tracks.empty() || track.times.front() < out->startTime) {
+				out->startTime = track.times.front();
+			}
+
+			if (out->tracks.empty() || track.times.back() > out->endTime) {
+				out->endTime = track.times.back();
+			}
+
+			out->tracks.push_back(std::move(track));
+		}
+
+		return true;
+	}
+
+	uint32_t FindKey(const float* times, size_t count, float time, uint32_t* inOutCursor) {
+		if (count < 2) {
+			*inOutCursor = 0;
+			return 0;
+		}
+
+		uint32_t lastInterval = static_cast<uint32_t>(count - 2);
+		uint32_t k = std::min(*inOutCursor, lastInterval);
+
+		// Forward playback usually stays within the current interval or moves to one of the next two.
+		if (time >= times[k]) {
+			for (size_t step = 0; step < 2 && k < lastInterval && time >= times[k + 1]; ++step) {
+				++k;
+			}
+
+			if (k == lastInterval || time < times[k + 1]) {
+				*inOutCursor = k;
+				return k;
+			}
+		}
+		else if (k == 0 || time >= times[k - 1]) {
+			// Either before the first key, which clamps to the first interval, or a step backwards.
+			k = k ? k - 1 : 0;
+			*inOutCursor = k;
+			return k;
+		}
+
+		size_t upper = std::upper_bound(times, times + count, time) - times;
+		k = static_cast<uint32_t>(std::min(upper ? upper - 1 : 0, static_cast<size_t>(lastInterval)));
+		*inOutCursor = k;
+		return k;
+	}
+
+	void InterpolateRotation(const float* a, const float* b, float t, RotationInterpolation interpolation, float* out) {
+		float dot = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+		float sign = dot < 0.0f ? -1.0f : 1.0f;
+		dot *= sign;
+
+		float weightA = 1.0f - t;
+		float weightB = t * sign;
+
+		// Nearly equal rotations divide by a sine close to zero with slerp; linear interpolation is exact enough.
+		if (interpolation == ROTATION_INTERPOLATION_SLERP && dot < 0.9995f) {
+			float angle = std::acos(dot);
+			float inverseSine = 1.0f / std::sin(angle);
+			weightA = std::sin((1.0f - t) * angle) * inverseSine;
+			weightB = std::sin(t * angle) * inverseSine * sign;
+		}
+
+		float lengthSquared = 0.0f;
+		for (size_t c = 0; c < 4; ++c) {
+			out[c] = a[c] * weightA + b[c] * weightB;
+			lengthSquared += out[c] * out[c];
+		}
+
+		float inverseLength = lengthSquared > 0.0f ? 1.0f / std::sqrt(lengthSquared) : 0.0f;
+		for (size_t c = 0; c < 4; ++c) {
+			out[c] *= inverseLength;
+		}
+	}
+
+	void SampleTrack(
+		const AnimationTrack& track,
+		float time,
+		RotationInterpolation rotationInterpolation,
+		uint32_t* inOutCursor,
+		float* out) {
+
+		size_t componentCount = track.GetComponentCount();
+		size_t count = track.times.size();
+		uint32_t k = FindKey(track.times.data(), count, time, inOutCursor);
+
+		if (count < 2 || time <= track.times[k]) {
+			memcpy(out, &track.values[k * componentCount], componentCount * sizeof(float));
+			return;
+		}
+
+		if (time >= track.times[k + 1]) {
+			memcpy(out, &track.values[(k + 1) * componentCount], componentCount * sizeof(float));
+			return;
+		}
+
+		float t = (time - track.times[k]) / (track.times[k + 1] - track.times[k]);
+		const float* a = &track.values[k * componentCount];
+		const float* b = &track.values[(k + 1) * componentCount];
+
+		if (track.path == AnimationTrack::PATH_ROTATION) {
+			InterpolateRotation(a, b, t, rotationInterpolation, out);
+		}
+		else {
+			for (size_t c = 0; c < componentCount; ++c) {
+				out[c] = a[c] + (b[c] - a[c]) * t;
+			}
+		}
+	}
+
+	void SampleAnimation(
+		const AnimationClip& clip,
+		float time,
+		RotationInterpolation rotationInterpolation,
+		std::vector<uint32_t>* inOutCursors,
+		float* out) {
+
+		inOutCursors->resize(clip.tracks.size());
+		for (size_t i = 0; i < clip.tracks.size(); ++i) {
+			SampleTrack(clip.tracks[i], time, rotationInterpolation, &(*inOutCursors)[i], out);
+			out += clip.tracks[i].GetComponentCount();
+		}
+	}
+
+	// Instances are handed to tasks in blocks of this many.
+	static const size_t BATCH_BLOCK_SIZE = 256;
+
+#if defined(GLTF_BASTARD_AVX2)
+	typedef __m256 AnimationVector;
+	static const size_t ANIMATION_VECTOR_WIDTH = 8;
+
+	static inline AnimationVector LoadVector(const float* values) {
+		return _mm256_loadu_ps(values);
+	}
+
+	static inline void StoreVector(float* out, AnimationVector value) {
+		_mm256_storeu_ps(out, value);
+	}
+
+	static inline AnimationVector SetVector(float value) {
+		return _mm256_set1_ps(value);
+	}
+
+	static inline AnimationVector Add(AnimationVector a, AnimationVector b) {
+		return _mm256_add_ps(a, b);
+	}
+
+	static inline AnimationVector Subtract(AnimationVector a, AnimationVector b) {
+		return _mm256_sub_ps(a, b);
+	}
+
+	static inline AnimationVector Multiply(AnimationVector a, AnimationVector b) {
+		return _mm256_mul_ps(a, b);
+	}
+
+	static inline AnimationVector Divide(AnimationVector a, AnimationVector b) {
+		return _mm256_div_ps(a, b);
+	}
+
+	static inline AnimationVector SquareRoot(AnimationVector a) {
+		return _mm256_sqrt_ps(a);
+	}
+
+	static inline AnimationVector And(AnimationVector a, AnimationVector b) {
+		return _mm256_and_ps(a, b);
+	}
+
+	static inline AnimationVector Xor(AnimationVector a, AnimationVector b) {
+		return _mm256_xor_ps(a, b);
+	}
+#elif defined(GLTF_BASTARD_SSE2)
+	typedef __m128 AnimationVector;
+	static const size_t ANIMATION_VECTOR_WIDTH = 4;
+
+	static inline AnimationVector LoadVector(const float* values) {
+		return _mm_loadu_ps(values);
+	}
+
+	static inline void StoreVector(float* out, AnimationVector value) {
+		_mm_storeu_ps(out, value);
+	}
+
+	static inline AnimationVector SetVector(float value) {
+		return _mm_set1_ps(value);
+	}
+
+	static inline AnimationVector Add(AnimationVector a, AnimationVector b) {
+		return _mm_add_ps(a, b);
+	}
+
+	static inline AnimationVector Subtract(AnimationVector a, AnimationVector b) {
+		return _mm_sub_ps(a, b);
+	}
+
+	static inline AnimationVector Multiply(AnimationVector a, AnimationVector b) {
+		return _mm_mul_ps(a, b);
+	}
+
+	static inline AnimationVector Divide(AnimationVector a, AnimationVector b) {
+		return _mm_div_ps(a, b);
+	}
+
+	static inline AnimationVector SquareRoot(AnimationVector a) {
+		return _mm_sqrt_ps(a);
+	}
+
+	static inline AnimationVector And(AnimationVector a, AnimationVector b) {
+		return _mm_and_ps(a, b);
+	}
+
+	static inline AnimationVector Xor(AnimationVector a, AnimationVector b) {
+		return _mm_xor_ps(a, b);
+	}
+#else
+	// Without vector instructions the same code runs on plain arrays, which compilers may still vectorize.
+	static const size_t ANIMATION_VECTOR_WIDTH = 4;
+
+	struct AnimationVector {
+		float lanes[ANIMATION_VECTOR_WIDTH];
+	};
+
+	template<typename Operation> static inline AnimationVector Apply(AnimationVector a, AnimationVector b, Operation operation) {
+		AnimationVector result;
+		for (size_t lane = 0; lane < ANIMATION_VECTOR_WIDTH; ++lane) {
+			result.lanes[lane] = operation(a.lanes[lane], b.lanes[lane]);
+		}
+
+		return result;
+	}
+
+	template<typename Operation> static inline AnimationVector ApplyBits(AnimationVector a, AnimationVector b, Operation operation) {
+		AnimationVector result;
+		for (size_t lane = 0; lane < ANIMATION_VECTOR_WIDTH; ++lane) {
+			uint32_t aBits;
+			uint32_t bBits;
+			memcpy(&aBits, &a.lanes[lane], sizeof(aBits));
+			memcpy(&bBits, &b.lanes[lane], sizeof(bBits));
+			uint32_t bits = operation(aBits, bBits);
+			memcpy(&result.lanes[lane], &bits, sizeof(bits));
+		}
+
+		return result;
+	}
+
+	static inline AnimationVector LoadVector(const float* values) {
+		AnimationVector result;
+		memcpy(result.lanes, values, sizeof(result.lanes));
+		return result;
+	}
+
+	static inline void StoreVector(float* out, AnimationVector value) {
+		memcpy(out, value.lanes, sizeof(value.lanes));
+	}
+
+	static inline AnimationVector SetVector(float value) {
+		AnimationVector result;
+		std::fill(result.lanes, result.lanes + ANIMATION_VECTOR_WIDTH, value);
+		return result;
+	}
+
+	static inline AnimationVector Add(AnimationVector a, AnimationVector b) {
+		return Apply(a, b, [](float x, float y) { return x + y; });
+	}
+
+	static inline AnimationVector Subtract(AnimationVector a, AnimationVector b) {
+		return Apply(a, b, [](float x, float y) { return x - y; });
+	}
+
+	static inline AnimationVector Multiply(AnimationVector a, AnimationVector b) {
+		return Apply(a, b, [](float x, float y) { return x * y; });
+	}
+
+	static inline AnimationVector Divide(AnimationVector a, AnimationVector b) {
+		return Apply(a, b, [](float x, float y) { return x / y; });
+	}
+
+	static inline AnimationVector SquareRoot(AnimationVector a) {
+		return Apply(a, a, [](float x, float) { return std::sqrt(x); });
+	}
+
+	static inline AnimationVector And(AnimationVector a, AnimationVector b) {
+		return ApplyBits(a, b, [](uint32_t x, uint32_t y) { return x & y; });
+	}
+
+	static inline AnimationVector Xor(AnimationVector a, AnimationVector b) {
+		return ApplyBits(a, b, [](uint32_t x, uint32_t y) { return x ^ y; });
+	}
+#endif
+
+	// Interpolates a vector of rotations. Slerp is approximated by correcting the interpolation factor of nlerp
+	// with a polynomial in t and the cosine of the angle between the rotations.
+	static inline void InterpolateRotations(
+		const AnimationVector* a,
+		AnimationVector* b,
+		AnimationVector t,
+		RotationInterpolation interpolation,
+		AnimationVector* out) {
+
+		AnimationVector dot = Multiply(a[0], b[0]);
+		for (size_t c = 1; c < 4; ++c) {
+			dot = Add(dot, Multiply(a[c], b[c]));
+		}
+
+		// Flipping the sign of b takes the shorter arc.
+		AnimationVector signBit = SetVector(-0.0f);
+		AnimationVector sign = And(dot, signBit);
+		for (size_t c = 0; c < 4; ++c) {
+			b[c] = Xor(b[c], sign);
+		}
+
+		if (interpolation == ROTATION_INTERPOLATION_SLERP) {
+			AnimationVector d = Xor(dot, sign);
+			AnimationVector A = Add(SetVector(1.0904f), Multiply(d, Add(SetVector(-3.2452f), Multiply(d, Subtract(SetVector(3.55645f), Multiply(d, SetVector(1.43519f)))))));
+			AnimationVector B = Add(SetVector(0.848013f), Multiply(d, Add(SetVector(-1.06021f), Multiply(d, SetVector(0.215638f)))));
+			AnimationVector h = Subtract(t, SetVector(0.5f));
+			AnimationVector k = Add(Multiply(A, Multiply(h, h)), B);
+			t = Add(t, Multiply(Multiply(t, h), Multiply(Subtract(t, SetVector(1.0f)), k)));
+		}
+
+		AnimationVector lengthSquared = SetVector(0.0f);
+		for (size_t c = 0; c < 4; ++c) {
+			out[c] = Add(a[c], Multiply(Subtract(b[c], a[c]), t));
+			lengthSquared = Add(lengthSquared, Multiply(out[c], out[c]));
+		}
+
+		AnimationVector inverseLength = Divide(SetVector(1.0f), SquareRoot(lengthSquared));
+		for (size_t c = 0; c < 4; ++c) {
+			out[c] = Multiply(out[c], inverseLength);
+		}
+	}
+
+	// Finds the keys and interpolation factors of the instances [begin, end) within a set of key times.
+	static void FindKeysBatch(
+		const std::vector<float>& keyTimes,
+		const float* times,
+		size_t begin,
+		size_t end,
+		uint32_t* inOutCursors,
+		uint32_t* outKeys,
+		float* outFactors) {
+
+		size_t keyCount = keyTimes.size();
+		for (size_t i = begin; i < end; ++i) {
+			uint32_t cursor = 0;
+			uint32_t k = FindKey(keyTimes.data(), keyCount, times[i], inOutCursors ? &inOutCursors[i] : &cursor);
+
+			float t = 0.0f;
+			if (keyCount >= 2) {
+				float interval = keyTimes[k + 1] - keyTimes[k];
+				if (interval > 0.0f) {
+					t = std::min(std::max((times[i] - keyTimes[k]) / interval, 0.0f), 1.0f);
+				}
+				else {
+					t = times[i] > keyTimes[k] ? 1.0f : 0.0f;
+				}
+			}
+
+			outKeys[i - begin] = k;
+			outFactors[i - begin] = t;
+		}
+	}
+
+	// Samples one track for a block of instances whose keys and factors have been found. The key values are
+	// gathered into one array per component first, then interpolated a vector of instances at a time.
+	static void SampleTrackBatch(
+		const AnimationTrack& track,
+		const uint32_t* keys,
+		const float* factors,
+		size_t count,
+		RotationInterpolation rotationInterpolation,
+		float* const* outComponents) {
+
+		const size_t width = ANIMATION_VECTOR_WIDTH;
+		size_t componentCount = track.GetComponentCount();
+		size_t step = track.times.size() >= 2 ? componentCount : 0;
+
+		// The last vector is padded by repeating the last instance.
+		size_t paddedCount = (count + width - 1) / width * width;
+		float aComponents[4][BATCH_BLOCK_SIZE];
+		float bComponents[4][BATCH_BLOCK_SIZE];
+		float paddedFactors[BATCH_BLOCK_SIZE];
+		for (size_t i = 0; i < paddedCount; ++i) {
+			size_t instance = std::min(i, count - 1);
+			const float* a = &track.values[keys[instance] * componentCount];
+			for (size_t c = 0; c < componentCount; ++c) {
+				aComponents[c][i] = a[c];
+				bComponents[c][i] = a[step + c];
+			}
+
+			paddedFactors[i] = factors[instance];
+		}
+
+		float resultLanes[width];
+		for (size_t i = 0; i < paddedCount; i += width) {
+			AnimationVector t = LoadVector(&paddedFactors[i]);
+			AnimationVector a[4];
+			AnimationVector b[4];
+			AnimationVector result[4];
+			for (size_t c = 0; c < componentCount; ++c) {
+				a[c] = LoadVector(&aComponents[c][i]);
+				b[c] = LoadVector(&bComponents[c][i]);
+			}
+
+			if (track.path == AnimationTrack::PATH_ROTATION) {
+				InterpolateRotations(a, b, t, rotationInterpolation, result);
+			}
+			else {
+				for (size_t c = 0; c < componentCount; ++c) {
+					result[c] = Add(a[c], Multiply(Subtract(b[c], a[c]), t));
+				}
+			}
+
+			for (size_t c = 0; c < componentCount; ++c) {
+				if (i + width <= count) {
+					StoreVector(outComponents[c] + i, result[c]);
+				}
+				else {
+					StoreVector(resultLanes, result[c]);
+					memcpy(outComponents[c] + i, resultLanes, (count - i) * sizeof(float));
+				}
+			}
+		}
+	}
+
+	void SampleAnimationBatch(
+		const AnimationClip& clip,
+		const float* times,
+		size_t instanceCount,
+		RotationInterpolation rotationInterpolation,
+		uint32_t* inOutCursors,
+		float* out) {
+
+		// Channels usually share their key times, so keys are only searched for once per distinct set of times,
+		// with the cursors of the first track that has them.
+		std::vector<uint32_t> timeSources(clip.tracks.size());
+		std::vector<uint32_t> distinctSources;
+		for (uint32_t track = 0; track < clip.tracks.size(); ++track) {
+			timeSources[track] = track;
+			for (uint32_t source : distinctSources) {
+				if (clip.tracks[source].times == clip.tracks[track].times) {
+					timeSources[track] = source;
+					break;
+				}
+			}
+
+			if (timeSources[track] == track) {
+				distinctSources.push_back(track);
+			}
+		}
+
+		ParallelFor(instanceCount, BATCH_BLOCK_SIZE, [&](size_t begin, size_t end) {
+			std::vector<uint32_t> keys(distinctSources.size() * BATCH_BLOCK_SIZE);
+			std::vector<float> factors(distinctSources.size() * BATCH_BLOCK_SIZE);
+			std::vector<size_t> sourceSlots(clip.tracks.size());
+
+			for (size_t d = 0; d < distinctSources.size(); ++d) {
+				uint32_t source = distinctSources[d];
+				uint32_t* cursors = inOutCursors ? inOutCursors + source * instanceCount : nullptr;
+				FindKeysBatch(clip.tracks[source].times, times, begin, end, cursors, &keys[d * BATCH_BLOCK_SIZE], &factors[d * BATCH_BLOCK_SIZE]);
+				sourceSlots[source] = d * BATCH_BLOCK_SIZE;
+			}
+
+			size_t component = 0;
+			for (size_t track = 0; track < clip.tracks.size(); ++track) {
+				float* outComponents[4];
+				for (size_t c = 0; c < clip.tracks[track].GetComponentCount(); ++c) {
+					outComponents[c] = out + (component + c) * instanceCount + begin;
+				}
+
+				size_t slot = sourceSlots[timeSources[track]];
+				SampleTrackBatch(clip.tracks[track], &keys[slot], &factors[slot], end - begin, rotationInterpolation, outComponents);
+				component += clip.tracks[track].GetComponentCount();
+			}
+		});
+	}
+
+	bool ApplyAnimation(
+		const AnimationClip& clip,
+		float time,
+		RotationInterpolation rotationInterpolation,
+		std::vector<uint32_t>* inOutCursors,
+		glTF* doc,
+		std::string& outErr) {
+
+		inOutCursors->resize(clip.tracks.size());
+		for (size_t i = 0; i < clip.tracks.size(); ++i) {
+			const AnimationTrack& track = clip.tracks[i];
+			auto node = doc->nodes.find(track.node);
+			if (node == doc->nodes.end()) {
+				outErr = "The node '" + track.node + "' does not exist.";
+				return false;
+			}
+
+			Node::Composite& composite = node->second->transform.composite;
+			if (node->second->transformType == Node::TRANSFORM_TYPE_MATRIX) {
+				// The matrix and the composite share storage, so the matrix is copied out first.
+				float matrix[16];
+				memcpy(matrix, node->second->transform.matrix, sizeof(matrix));
+				DecomposeMatrix(matrix, composite.translation, composite.rotation, composite.scale);
+				node->second->transformType = Node::TRANSFORM_TYPE_COMPOSITE;
+			}
+
+			float* out = track.path == AnimationTrack::PATH_TRANSLATION ? composite.translation
+				: track.path == AnimationTrack::PATH_ROTATION ? composite.rotation
+				: composite.scale;
+
+			SampleTrack(track, time, rotationInterpolation, &(*inOutCursors)[i], out);
+		}
+
+		return true;
+	}
+}
\ No newline at end of file
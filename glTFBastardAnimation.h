@@ -0,0 +1,142 @@
+/*
+Copyright (c) 2016 Ruben Cashie
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation 
+files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, 
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software 
+is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES 
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE 
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef GLTF_BASTARD_ANIMATION_H
+#define GLTF_BASTARD_ANIMATION_H
+
+#include <cstdint>
+#include "glTFBastard.h"
+
+namespace glTFBastard {
+
+	// A channel of an animation with its keyframes decoded to floats.
+	struct AnimationTrack {
+		enum Path {
+			PATH_TRANSLATION,
+			PATH_ROTATION,
+			PATH_SCALE
+		};
+
+		std::string node;
+		Path path;
+
+		// Key times in ascending order, and the values of each key one after another: three floats per key, or
+		// four for rotations.
+		std::vector<float> times;
+		std::vector<float> values;
+
+		AnimationTrack() :
+			path(PATH_TRANSLATION) {
+		}
+
+		size_t GetComponentCount() const {
+			return path == PATH_ROTATION ? 4 : 3;
+		}
+	};
+
+	// The decoded tracks of an animation. Clips are read-only once loaded, so any number of playing instances can
+	// share one; each instance only keeps a cursor per track.
+	struct AnimationClip {
+		std::vector<AnimationTrack> tracks;
+
+		// The earliest and latest key time of any track.
+		float startTime;
+		float endTime;
+
+		AnimationClip() :
+			startTime(0.0f),
+			endTime(0.0f) {
+		}
+
+		// The number of floats that a sample of every track takes.
+		size_t GetValueCount() const {
+			size_t count = 0;
+			for (const AnimationTrack& track : tracks) {
+				count += track.GetComponentCount();
+			}
+
+			return count;
+		}
+	};
+
+	enum RotationInterpolation {
+		// Spherical interpolation, at constant angular speed.
+		ROTATION_INTERPOLATION_SLERP,
+
+		// Normalized linear interpolation; cheaper, and close to slerp for the small angles between keys.
+		ROTATION_INTERPOLATION_NLERP
+	};
+
+	// Decodes the channels of an animation. Sampler inputs and outputs name animation parameters, which name the
+	// accessors. Outputs may be FLOAT, or UNSIGNED_SHORT as written by CompressAnimations.
+	// The buffers of those accessors must have been loaded.
+	bool LoadAnimationClip(const glTF& doc, const std::string& animationId, AnimationClip* out, std::string& outErr);
+
+	// Returns the key k with times[k] <= time < times[k + 1], clamped to the first and last interval.
+	// inOutCursor holds the key found by the previous call. Playback that moves a key or so per call is found by
+	// stepping from it; other times, such as seeks, fall back to a binary search.
+	uint32_t FindKey(const float* times, size_t count, float time, uint32_t* inOutCursor);
+
+	// Interpolates along the shorter arc between two unit quaternions.
+	void InterpolateRotation(const float* a, const float* b, float t, RotationInterpolation interpolation, float* out);
+
+	// Samples a track; out receives GetComponentCount() floats. Times before the first key and after the last one
+	// are clamped.
+	void SampleTrack(
+		const AnimationTrack& track,
+		float time,
+		RotationInterpolation rotationInterpolation,
+		uint32_t* inOutCursor,
+		float* out);
+
+	// Samples every track of a clip into out, which must have room for GetValueCount() floats: as many per track as
+	// it has components, one track after another. inOutCursors holds one cursor per track and is resized if it does not.
+	void SampleAnimation(
+		const AnimationClip& clip,
+		float time,
+		RotationInterpolation rotationInterpolation,
+		std::vector<uint32_t>* inOutCursors,
+		float* out);
+
+	// Samples every track of a clip for many instances at once, each at its own time. Results are written as
+	// structure of arrays: component c of the value of instance i is out[c * instanceCount + i], where components
+	// are numbered across all tracks as in SampleAnimation, so out must have room for GetValueCount() *
+	// instanceCount floats.
+	// inOutCursors holds a cursor per track and instance, at track * instanceCount + instance; when it is null keys
+	// are found by binary search. Tracks with the same key times only search for keys once, using the cursors of
+	// the first of them. Interpolation runs on several instances at a time with SSE2 or AVX2, and instances are
+	// spread across threads. Slerp is approximated by nlerp with a corrected interpolation factor,
+	// which stays within about 0.001 radians of it.
+	void SampleAnimationBatch(
+		const AnimationClip& clip,
+		const float* times,
+		size_t instanceCount,
+		RotationInterpolation rotationInterpolation,
+		uint32_t* inOutCursors,
+		float* out);
+
+	// Samples every track of a clip and writes the results into the translation, rotation and scale of the target
+	// nodes. Nodes given as a matrix are decomposed into TRS first. Fails if a target node does not exist.
+	bool ApplyAnimation(
+		const AnimationClip& clip,
+		float time,
+		RotationInterpolation rotationInterpolation,
+		std::vector<uint32_t>* inOutCursors,
+		glTF* doc,
+		std::string& outErr);
+}
+
+#endif
\ No newline at end of file
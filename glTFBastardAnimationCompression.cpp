@@ -0,0 +1,532 @@
+/*
+Copyright (c) 2016 Ruben Cashie
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation 
+files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, 
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software 
+is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES 
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE 
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <sstream>
+#include "glTFBastardAnimationCompression.h"
+#include "glTFBastardBounds.h"
+#include "glTFBastardBuilder.h"
+#include "glTFBastardMath.h"
+#include "glTFBastardParallel.h"
+#include "glTFBastardSceneGraph.h"
+
+namespace glTFBastard {
+
+	// The magnitude of the three smallest components of a unit quaternion is at most the square root of one half.
+	static const float SMALLEST_THREE_RANGE = 0.70710678f;
+	static const float SMALLEST_THREE_LEVELS = 32767.0f;
+
+	void EncodeSmallestThree(const float* rotation, uint16_t* outEncoded) {
+		uint16_t largest = 0;
+		float lengthSquared = 0.0f;
+		for (uint16_t c = 0; c < 4; ++c) {
+			if (std::fabs(rotation[c]) > std::fabs(rotation[largest])) {
+				largest = c;
+			}
+
+			lengthSquared += rotation[c] * rotation[c];
+		}
+
+		if (lengthSquared == 0.0f) {
+			const float identity[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+			EncodeSmallestThree(identity, outEncoded);
+			return;
+		}
+
+		// q and -q are the same rotation, so flip the sign to make the largest component positive.
+		float scale = (rotation[largest] < 0.0f ? -1.0f : 1.0f) / std::sqrt(lengthSquared);
+		size_t slot = 0;
+		for (uint16_t c = 0; c < 4; ++c) {
+			if (c != largest) {
+				float value = rotation[c] * scale / (2.0f * SMALLEST_THREE_RANGE) + 0.5f;
+				float level = std::floor(value * SMALLEST_THREE_LEVELS + 0.5f);
+				outEncoded[slot++] = static_cast<uint16_t>(std::min(std::max(level, 0.0f), SMALLEST_THREE_LEVELS));
+			}
+		}
+
+		outEncoded[0] |= static_cast<uint16_t>((largest >> 1) << 15);
+		outEncoded[1] |= static_cast<uint16_t>((largest & 1) << 15);
+	}
+
+	void DecodeSmallestThree(const uint16_t* encoded, float* outRotation) {
+		size_t largest = ((encoded[0] >> 15) << 1) | (encoded[1] >> 15);
+		float lengthSquared = 0.0f;
+		size_t slot = 0;
+		for (size_t c = 0; c < 4; ++c) {
+			if (c != largest) {
+				float value = (encoded[slot++] & 0x7fff) / SMALLEST_THREE_LEVELS;
+				outRotation[c] = (value - 0.5f) * 2.0f * SMALLEST_THREE_RANGE;
+				lengthSquared += outRotation[c] * outRotation[c];
+			}
+		}
+
+		outRotation[largest] = std::sqrt(std::max(1.0f - lengthSquared, 0.0f));
+
+		// Only invalid encodings have three components whose squares add up to more than one.
+		if (lengthSquared > 1.0f) {
+			float inverseLength = 1.0f / std::sqrt(lengthSquared);
+			for (size_t c = 0; c < 4; ++c) {
+				outRotation[c] *= inverseLength;
+			}
+		}
+	}
+
+	// The error bounds of the tracks that target a node.
+	struct NodeTolerance {
+		float translation;
+		float rotation;
+		float scale;
+	};
+
+	// Derives the tolerance of every node of every scene from its position in the hierarchy and the rest pose.
+	static bool ComputeNodeTolerances(
+		const glTF& doc,
+		const AnimationCompressionOptions& options,
+		std::unordered_map<std::string, NodeTolerance>* out,
+		std::string& outErr) {
+
+		std::vector<std::string> sceneIds;
+		for (auto& scene : doc.scenes) {
+			sceneIds.push_back(scene.first);
+		}
+
+		std::sort(sceneIds.begin(), sceneIds.end());
+
+		for (const std::string& sceneId : sceneIds) {
+			FlatScene scene;
+			if (!FlattenScene(doc, sceneId, &scene, outErr)) {
+				return false;
+			}
+
+			std::vector<float> world;
+			ComputeWorldMatrices(scene, &world);
+
+			// The number of levels below each node; parents come before their children.
+			size_t count = scene.GetCount();
+			std::vector<uint32_t> heights(count, 0);
+			for (size_t i = count; i-- > 0;) {
+				if (scene.parents[i] != FLAT_SCENE_NO_PARENT) {
+					heights[scene.parents[i]] = std::max(heights[scene.parents[i]], heights[i] + 1);
+				}
+			}
+
+			for (size_t i = 0; i < count; ++i) {
+				if (out->count(scene.ids[i])) {
+					continue;
+				}
+
+				const float* origin = &world[i * 16 + 12];
+				float reach = options.shellDistance;
+				for (size_t j = i + 1; j < scene.subtreeEnds[i]; ++j) {
+					const float* descendant = &world[j * 16 + 12];
+					float dx = descendant[0] - origin[0];
+					float dy = descendant[1] - origin[1];
+					float dz = descendant[2] - origin[2];
+					reach = std::max(reach, std::sqrt(dx * dx + dy * dy + dz * dz));
+				}
+
+				// Every node of a chain adds its error to the end of the chain.
+				float budget = options.maxError / static_cast<float>(scene.depths[i] + 1 + heights[i]);
+				float parentScale = scene.parents[i] == FLAT_SCENE_NO_PARENT ? 1.0f : GetMaxScale(&world[scene.parents[i] * 16]);
+				float nodeScale = parentScale > 0.0f ? GetMaxScale(&world[i * 16]) / parentScale : 0.0f;
+
+				NodeTolerance tolerance;
+				tolerance.translation = parentScale > 0.0f ? budget / parentScale : budget;
+				tolerance.rotation = budget / reach;
+				tolerance.scale = (nodeScale > 0.0f ? nodeScale : 1.0f) * budget / reach;
+				(*out)[scene.ids[i]] = tolerance;
+			}
+		}
+
+		return true;
+	}
+
+	// The difference between two values of a path: the distance between translations, the largest difference of
+	// the components of scales, or the angle between rotations.
+	static float GetValueError(AnimationTrack::Path path, const float* a, const float* b) {
+		if (path == AnimationTrack::PATH_ROTATION) {
+			// The angle is computed from the chord between the quaternions, which stays accurate for small angles.
+			float sign = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3] < 0.0f ? -1.0f : 1.0f;
+			float chordSquared = 0.0f;
+			for (size_t c = 0; c < 4; ++c) {
+				float difference = a[c] - b[c] * sign;
+				chordSquared += difference * difference;
+			}
+
+			return 4.0f * std::asin(std::min(std::sqrt(chordSquared) * 0.5f, 1.0f));
+		}
+
+		if (path == AnimationTrack::PATH_TRANSLATION) {
+			float dx = a[0] - b[0];
+			float dy = a[1] - b[1];
+			float dz = a[2] - b[2];
+			return std::sqrt(dx * dx + dy * dy + dz * dz);
+		}
+
+		return std::max(std::max(std::fabs(a[0] - b[0]), std::fabs(a[1] - b[1])), std::fabs(a[2] - b[2]));
+	}
+
+	// Returns true if interpolating between the keys first and last reproduces every key between them.
+	static bool SpanFits(const AnimationTrack& track, size_t first, size_t last, float tolerance) {
+		size_t componentCount = track.GetComponentCount();
+		const float* a = &track.values[first * componentCount];
+		const float* b = &track.values[last * componentCount];
+		float interval = track.times[last] - track.times[first];
+
+		for (size_t k = first + 1; k < last; ++k) {
+			float t = interval > 0.0f ? (track.times[k] - track.times[first]) / interval : 0.0f;
+			float interpolated[4];
+			if (track.path == AnimationTrack::PATH_ROTATION) {
+				InterpolateRotation(a, b, t, ROTATION_INTERPOLATION_SLERP, interpolated);
+			}
+			else {
+				for (size_t c = 0; c < componentCount; ++c) {
+					interpolated[c] = a[c] + (b[c] - a[c]) * t;
+				}
+			}
+
+			if (GetValueError(track.path, interpolated, &track.values[k * componentCount]) > tolerance) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	// Keeps a key only where the span from the previous kept key can not grow any further within the tolerance.
+	// Tracks that interpolation between their first and last key reproduces keep just those two, which keeps the
+	// duration of the clip.
+	static void ReduceKeys(const AnimationTrack& track, float tolerance, AnimationTrack* out) {
+		size_t componentCount = track.GetComponentCount();
+		size_t count = track.times.size();
+
+		std::vector<size_t> kept(1, 0);
+		bool constant = count > 1 && SpanFits(track, 0, count - 1, tolerance);
+		if (constant) {
+			kept.push_back(count - 1);
+		}
+
+		for (size_t anchor = 0; !constant && anchor + 1 < count;) {
+			size_t last = anchor + 1;
+			while (last + 1 < count && SpanFits(track, anchor, last + 1, tolerance)) {
+				++last;
+			}
+
+			kept.push_back(last);
+			anchor = last;
+		}
+
+		out->node = track.node;
+		out->path = track.path;
+		out->times.clear();
+		out->values.clear();
+		for (size_t k : kept) {
+			out->times.push_back(track.times[k]);
+			out->values.insert(out->values.end(), &track.values[k * componentCount], &track.values[(k + 1) * componentCount]);
+		}
+	}
+
+	// Returns the largest error of a compressed track at the times of the keys of the original.
+	static float MeasureError(const AnimationTrack& original, const AnimationTrack& compressed) {
+		size_t componentCount = original.GetComponentCount();
+		uint32_t cursor = 0;
+		float maxError = 0.0f;
+		for (size_t k = 0; k < original.times.size(); ++k) {
+			float sample[4];
+			SampleTrack(compressed, original.times[k], ROTATION_INTERPOLATION_SLERP, &cursor, sample);
+			maxError = std::max(maxError, GetValueError(original.path, sample, &original.values[k * componentCount]));
+		}
+
+		return maxError;
+	}
+
+	// The work and results for a single sampler.
+	struct CompressionJob {
+		Animation* animation;
+		std::string samplerId;
+		AnimationTrack original;
+		AnimationTrack compressed;
+		float tolerance;
+
+		// The quantized outputs and, for translations and scales, their offset and scale.
+		std::vector<uint16_t> quantized;
+		float decode[6];
+
+		AnimationCompressionReport report;
+		std::string error;
+	};
+
+	// Quantizes the values of a reduced track and decodes them back into it.
+	static void QuantizeTrack(CompressionJob* job) {
+		AnimationTrack& track = job->compressed;
+		size_t count = track.times.size();
+		job->quantized.resize(count * 3);
+
+		if (track.path == AnimationTrack::PATH_ROTATION) {
+			for (size_t k = 0; k < count; ++k) {
+				EncodeSmallestThree(&track.values[k * 4], &job->quantized[k * 3]);
+				DecodeSmallestThree(&job->quantized[k * 3], &track.values[k * 4]);
+			}
+
+			return;
+		}
+
+		for (size_t c = 0; c < 3; ++c) {
+			float minimum = track.values[c];
+			float maximum = track.values[c];
+			for (size_t k = 1; k < count; ++k) {
+				minimum = std::min(minimum, track.values[k * 3 + c]);
+				maximum = std::max(maximum, track.values[k * 3 + c]);
+			}
+
+			float scale = (maximum - minimum) / 65535.0f;
+			job->decode[c] = minimum;
+			job->decode[3 + c] = scale;
+			for (size_t k = 0; k < count; ++k) {
+				float& value = track.values[k * 3 + c];
+				float level = scale > 0.0f ? std::floor((value - minimum) / scale + 0.5f) : 0.0f;
+				job->quantized[k * 3 + c] = static_cast<uint16_t>(std::min(std::max(level, 0.0f), 65535.0f));
+				value = minimum + job->quantized[k * 3 + c] * scale;
+			}
+		}
+	}
+
+	// Compresses a single sampler without touching the document.
+	static void RunCompressionJob(const AnimationCompressionOptions& options, CompressionJob* job) {
+		size_t keyCount = job->original.times.size();
+		size_t componentCount = job->original.GetComponentCount();
+
+		// Quantization needs some of the tolerance; fall back to floats if what is left is not enough.
+		if (options.quantize && std::isfinite(job->tolerance)) {
+			ReduceKeys(job->original, job->tolerance * 0.5f, &job->compressed);
+			QuantizeTrack(job);
+			job->report.maxError = MeasureError(job->original, job->compressed);
+			job->report.quantized = job->report.maxError <= job->tolerance;
+		}
+
+		if (!job->report.quantized) {
+			job->quantized.clear();
+			ReduceKeys(job->original, job->tolerance, &job->compressed);
+			job->report.maxError = MeasureError(job->original, job->compressed);
+			if (job->report.maxError > job->tolerance) {
+				std::stringstream ss;
+				ss << "The sampler '" << job->samplerId << "' could not be compressed within its tolerance of "
+					<< job->tolerance << "; the error is " << job->report.maxError << ".";
+				job->error = ss.str();
+				return;
+			}
+		}
+
+		size_t compressedCount = job->compressed.times.size();
+		job->report.path = job->original.path;
+		job->report.tolerance = job->tolerance;
+		job->report.keyCountBefore = keyCount;
+		job->report.keyCountAfter = compressedCount;
+		job->report.byteLengthBefore = keyCount * (1 + componentCount) * sizeof(float);
+		job->report.byteLengthAfter = job->report.quantized
+			? compressedCount * (sizeof(float) + 3 * sizeof(uint16_t)) + (job->original.path == AnimationTrack::PATH_ROTATION ? 0 : 6 * sizeof(float))
+			: compressedCount * (1 + componentCount) * sizeof(float);
+	}
+
+	// Adds an accessor over a new buffer view and computes its min/max.
+	static bool AddCompressedAccessor(
+		glTF* doc,
+		const std::string& idPrefix,
+		Accessor::ComponentType componentType,
+		Accessor::Type type,
+		const std::string& bufferView,
+		size_t count,
+		std::string* outAccessorId,
+		std::string& outErr) {
+
+		Accessor source;
+		source.componentType = componentType;
+		source.type = type;
+		*outAccessorId = AddAccessor(doc, idPrefix, source, bufferView, static_cast<long long>(count));
+
+		Accessor& accessor = *doc->accessors[*outAccessorId];
+		AccessorData data;
+		return GetAccessorData(*doc, accessor, &data, outErr) && ComputeAccessorMinMax(data, &accessor.min, &accessor.max, outErr);
+	}
+
+	bool CompressAnimations(
+		glTF* doc,
+		const AnimationCompressionOptions& options,
+		std::vector<AnimationCompressionReport>* outReport,
+		std::string& outErr) {
+
+		std::unordered_map<std::string, NodeTolerance> nodeTolerances;
+		if (!ComputeNodeTolerances(*doc, options, &nodeTolerances, outErr)) {
+			return false;
+		}
+
+		std::vector<std::string> animationIds;
+		for (auto& animation : doc->animations) {
+			animationIds.push_back(animation.first);
+		}
+
+		std::sort(animationIds.begin(), animationIds.end());
+
+		// One job per sampler, with the smallest tolerance of the channels that use it. Samplers whose outputs are
+		// not floats have been compressed before and are left alone.
+		std::vector<CompressionJob> jobs;
+		for (const std::string& animationId : animationIds) {
+			Animation* animation = doc->animations[animationId].get();
+			AnimationClip clip;
+			if (!LoadAnimationClip(*doc, animationId, &clip, outErr)) {
+				return false;
+			}
+
+			std::map<std::string, size_t> samplerJobs;
+			for (size_t c = 0; c < animation->channels.size(); ++c) {
+				const std::string& samplerId = animation->channels[c]->sampler;
+				const std::string& outputId = animation->parameters[animation->samplers[samplerId]->output];
+				if (doc->accessors[outputId]->componentType != Accessor::COMPONENT_TYPE_FLOAT) {
+					continue;
+				}
+
+				const AnimationTrack& track = clip.tracks[c];
+				NodeTolerance nodeTolerance = {options.maxError, options.maxError / options.shellDistance, options.maxError / options.shellDistance};
+				auto found = nodeTolerances.find(track.node);
+				if (found != nodeTolerances.end()) {
+					nodeTolerance = found->second;
+				}
+
+				float tolerance = track.path == AnimationTrack::PATH_TRANSLATION ? nodeTolerance.translation
+					: track.path == AnimationTrack::PATH_ROTATION ? nodeTolerance.rotation
+					: nodeTolerance.scale;
+
+				auto existing = samplerJobs.find(samplerId);
+				if (existing != samplerJobs.end()) {
+					jobs[existing->second].tolerance = std::min(jobs[existing->second].tolerance, tolerance);
+					continue;
+				}
+
+				samplerJobs[samplerId] = jobs.size();
+				jobs.push_back(CompressionJob());
+				CompressionJob& job = jobs.back();
+				job.animation = animation;
+				job.samplerId = samplerId;
+				job.original = track;
+				job.tolerance = tolerance;
+				job.report.animation = animationId;
+				job.report.sampler = samplerId;
+			}
+		}
+
+		ParallelFor(jobs.size(), 1, [&](size_t begin, size_t end) {
+			for (size_t j = begin; j < end; ++j) {
+				RunCompressionJob(options, &jobs[j]);
+			}
+		});
+
+		for (const CompressionJob& job : jobs) {
+			if (!job.error.empty()) {
+				outErr = job.error;
+				return false;
+			}
+		}
+
+		// Samplers that keep the same key times share their input.
+		BufferBuilder builder;
+		std::map<std::vector<float>, size_t> timeViews;
+		std::vector<size_t> inputViews(jobs.size());
+		std::vector<size_t> outputViews(jobs.size());
+		for (size_t j = 0; j < jobs.size(); ++j) {
+			const AnimationTrack& track = jobs[j].compressed;
+			auto existing = timeViews.find(track.times);
+			if (existing == timeViews.end()) {
+				size_t view = builder.AddView(track.times.data(), track.times.size() * sizeof(float), BufferView::TARGET_OTHER);
+				existing = timeViews.insert(std::make_pair(track.times, view)).first;
+			}
+
+			inputViews[j] = existing->second;
+			if (jobs[j].report.quantized) {
+				outputViews[j] = builder.AddView(jobs[j].quantized.data(), jobs[j].quantized.size() * sizeof(uint16_t), BufferView::TARGET_OTHER);
+				if (track.path != AnimationTrack::PATH_ROTATION) {
+					builder.AddView(jobs[j].decode, sizeof(jobs[j].decode), BufferView::TARGET_OTHER);
+				}
+			}
+			else {
+				outputViews[j] = builder.AddView(track.values.data(), track.values.size() * sizeof(float), BufferView::TARGET_OTHER);
+			}
+		}
+
+		std::vector<std::string> viewIds;
+		if (builder.GetViewCount()) {
+			viewIds = builder.Commit(doc, "compressedAnimation");
+		}
+
+		std::map<size_t, std::string> inputAccessors;
+		outReport->clear();
+		for (size_t j = 0; j < jobs.size(); ++j) {
+			CompressionJob& job = jobs[j];
+			const AnimationTrack& track = job.compressed;
+			Animation& animation = *job.animation;
+			Animation::Sampler& sampler = *animation.samplers[job.samplerId];
+			size_t count = track.times.size();
+
+			std::string& inputId = inputAccessors[inputViews[j]];
+			if (inputId.empty() && !AddCompressedAccessor(
+				doc, job.samplerId + "_input", Accessor::COMPONENT_TYPE_FLOAT, Accessor::TYPE_SCALAR, viewIds[inputViews[j]], count, &inputId, outErr)) {
+				return false;
+			}
+
+			std::string outputId;
+			bool decoded = job.report.quantized && track.path != AnimationTrack::PATH_ROTATION;
+			if (!AddCompressedAccessor(
+				doc,
+				job.samplerId + "_output",
+				job.report.quantized ? Accessor::COMPONENT_TYPE_UNSIGNED_SHORT : Accessor::COMPONENT_TYPE_FLOAT,
+				track.path == AnimationTrack::PATH_ROTATION && !job.report.quantized ? Accessor::TYPE_VEC4 : Accessor::TYPE_VEC3,
+				viewIds[outputViews[j]],
+				count,
+				&outputId,
+				outErr)) {
+				return false;
+			}
+
+			// The decode parameter is named after the output parameter, so both names have to be free.
+			std::string inputParameter = MakeUniqueId(animation.parameters, job.samplerId + "_input");
+			animation.parameters[inputParameter] = inputId;
+
+			std::string outputParameter;
+			for (size_t attempt = 0; outputParameter.empty() || animation.parameters.count(outputParameter + "_decode"); ++attempt) {
+				outputParameter = MakeUniqueId(animation.parameters, job.samplerId + "_output" + (attempt ? std::to_string(attempt) : ""));
+			}
+
+			animation.parameters[outputParameter] = outputId;
+
+			if (decoded) {
+				std::string decodeId;
+				if (!AddCompressedAccessor(
+					doc, job.samplerId + "_decode", Accessor::COMPONENT_TYPE_FLOAT, Accessor::TYPE_VEC3, viewIds[outputViews[j] + 1], 2, &decodeId, outErr)) {
+					return false;
+				}
+
+				animation.parameters[outputParameter + "_decode"] = decodeId;
+			}
+
+			sampler.input = inputParameter;
+			sampler.output = outputParameter;
+			outReport->push_back(job.report);
+		}
+
+		return true;
+	}
+}
\ No newline at end of file
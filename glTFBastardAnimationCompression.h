@@ -0,0 +1,105 @@
+/*
+Copyright (c) 2016 Ruben Cashie
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation 
+files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, 
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software 
+is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES 
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE 
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef GLTF_BASTARD_ANIMATION_COMPRESSION_H
+#define GLTF_BASTARD_ANIMATION_COMPRESSION_H
+
+#include <cstdint>
+#include "glTFBastardAnimation.h"
+
+namespace glTFBastard {
+
+	// Encodes a unit quaternion as its three smallest components in 15 bits each, with the index of the largest
+	// component in the top bits of the first two. The largest component is made positive, which keeps the rotation,
+	// and is recovered from the unit length when decoding.
+	void EncodeSmallestThree(const float* rotation, uint16_t* outEncoded);
+
+	// Decodes three smallest-three components into a unit quaternion.
+	void DecodeSmallestThree(const uint16_t* encoded, float* outRotation);
+
+	struct AnimationCompressionOptions {
+		// The largest distance in world space that a node or a point at shellDistance from it may move by, measured
+		// against the rest pose of the document. The budget is split evenly across the nodes of the longest chain
+		// of the skeleton that a node is part of, since the errors of every ancestor add up at the end of a chain.
+		float maxError;
+
+		// The distance from a node at which its rotation and scale errors are measured when none of its descendants
+		// is further away, such as for the vertices around the last joint of a chain.
+		float shellDistance;
+
+		// Whether to quantize rotations to smallest-three and translations and scales to 16 bits after removing keys.
+		bool quantize;
+
+		AnimationCompressionOptions() :
+			maxError(0.0001f),
+			shellDistance(0.1f),
+			quantize(true) {
+		}
+	};
+
+	// How the keys of one sampler were compressed.
+	struct AnimationCompressionReport {
+		std::string animation;
+		std::string sampler;
+		AnimationTrack::Path path;
+
+		size_t keyCountBefore;
+		size_t keyCountAfter;
+
+		// The size of the tightly packed input and output elements before and after.
+		size_t byteLengthBefore;
+		size_t byteLengthAfter;
+
+		bool quantized;
+
+		// The bound the keys were compressed to and the largest error at any original key, in the units of the
+		// path: distance for translations and scales, radians for rotations.
+		float tolerance;
+		float maxError;
+
+		AnimationCompressionReport() :
+			path(AnimationTrack::PATH_TRANSLATION),
+			keyCountBefore(0),
+			keyCountAfter(0),
+			byteLengthBefore(0),
+			byteLengthAfter(0),
+			quantized(false),
+			tolerance(0.0f),
+			maxError(0.0f) {
+		}
+	};
+
+	// Compresses the samplers of every animation. Keys that linear interpolation between their neighbours
+	// reproduces within the tolerance of the sampler are removed, and tracks that interpolation between their first
+	// and last key reproduces are reduced to those two. The tolerance of a node follows from options.maxError, the
+	// reach of the node over its descendants in the rest pose and the scale of its parent. Fails if a sampler can not
+	// be kept within its tolerance.
+	// When options.quantize is set and the error stays within the tolerance, rotations are stored as UNSIGNED_SHORT
+	// VEC3 smallest-three, and translations and scales as UNSIGNED_SHORT VEC3 that decode as offset + value * scale,
+	// where offset and scale are the two elements of a FLOAT VEC3 accessor named by the animation parameter
+	// "<output parameter>_decode". LoadAnimationClip decodes both.
+	// Samplers get new parameters and accessors in a new buffer; key times are shared by samplers that keep the same
+	// keys, and the original parameters and accessors are left in place. Quantized samplers are skipped when
+	// compressing again; float ones are reduced again, which adds to their error.
+	// Samplers are compressed in parallel. The buffers of every animation must have been loaded.
+	bool CompressAnimations(
+		glTF* doc,
+		const AnimationCompressionOptions& options,
+		std::vector<AnimationCompressionReport>* outReport,
+		std::string& outErr);
+}
+
+#endif
\ No newline at end of file
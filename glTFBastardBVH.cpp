@@ -0,0 +1,526 @@
+/*
+Copyright (c) 2016 Ruben Cashie
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation 
+files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, 
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software 
+is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES 
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE 
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <algorithm>
+#include <numeric>
+#include "glTFBastardBVH.h"
+#include "glTFBastardParallel.h"
+#include "glTFBastardSceneGraph.h"
+
+namespace glTFBastard {
+
+	typedef std::vector<BVHNode, CacheLineAllocator<BVHNode>> BVHNodeArray;
+
+	// The fewest items a subtree that is built by its own task can have.
+	static const size_t MIN_SUBTREE_SIZE = 256;
+
+	// Split costs are only compared with each other, so half of the surface area is enough.
+	static float GetHalfArea(const BoundingBox& box) {
+		if (box.IsEmpty()) {
+			return 0.0f;
+		}
+
+		float x = box.max[0] - box.min[0];
+		float y = box.max[1] - box.min[1];
+		float z = box.max[2] - box.min[2];
+		return x * y + y * z + z * x;
+	}
+
+	static BoundingBox GetNodeBox(const BVHNode& node) {
+		BoundingBox box;
+		for (size_t axis = 0; axis < 3; ++axis) {
+			box.min[axis] = node.min[axis];
+			box.max[axis] = node.max[axis];
+		}
+
+		return box;
+	}
+
+	static void SetNodeBox(const BoundingBox& box, BVHNode* node) {
+		for (size_t axis = 0; axis < 3; ++axis) {
+			node->min[axis] = box.min[axis];
+			node->max[axis] = box.max[axis];
+		}
+	}
+
+	static bool Overlaps(const BoundingBox& a, const BoundingBox& b) {
+		return a.min[0] <= b.max[0] && b.min[0] <= a.max[0]
+			&& a.min[1] <= b.max[1] && b.min[1] <= a.max[1]
+			&& a.min[2] <= b.max[2] && b.min[2] <= a.max[2];
+	}
+
+	// A range of the item order and the node that its subtree starts at.
+	struct BVHRange {
+		uint32_t node;
+		uint32_t begin;
+		uint32_t end;
+	};
+
+	struct BVHBin {
+		BoundingBox box;
+		size_t count;
+	};
+
+	// Splits the range of an allocated node recursively, allocating its descendants at the end of the node array.
+	// When outDeferred is not null, ranges of at most deferSize items are appended to it instead of being split.
+	static void SplitRange(
+		const std::vector<BVHItem>& items,
+		const BVHOptions& options,
+		const BVHRange& root,
+		size_t deferSize,
+		std::vector<uint32_t>& order,
+		BVHNodeArray& nodes,
+		std::vector<BVHRange>* outDeferred) {
+
+		size_t binCount = std::max(options.binCount, static_cast<size_t>(2));
+		std::vector<BVHBin> bins(binCount);
+		std::vector<float> rightCosts(binCount);
+
+		std::vector<BVHRange> stack(1, root);
+		while (!stack.empty()) {
+			BVHRange range = stack.back();
+			stack.pop_back();
+
+			size_t count = range.end - range.begin;
+			if (outDeferred && count <= deferSize) {
+				outDeferred->push_back(range);
+				continue;
+			}
+
+			BoundingBox box;
+			BoundingBox centroids;
+			for (uint32_t i = range.begin; i < range.end; ++i) {
+				const BoundingBox& itemBox = items[order[i]].box;
+				box.Include(itemBox);
+
+				for (size_t axis = 0; axis < 3; ++axis) {
+					float centroid = (itemBox.min[axis] + itemBox.max[axis]) * 0.5f;
+					centroids.min[axis] = std::min(centroids.min[axis], centroid);
+					centroids.max[axis] = std::max(centroids.max[axis], centroid);
+				}
+			}
+
+			SetNodeBox(box, &nodes[range.node]);
+			nodes[range.node].firstChildOrItem = range.begin;
+			nodes[range.node].itemCount = static_cast<uint32_t>(count);
+			if (count <= 1) {
+				continue;
+			}
+
+			// Bin the centroids along each axis and find the boundary between bins with the lowest cost, which is the
+			// half area of each side times its item count.
+			float bestCost = INFINITY;
+			size_t bestAxis = 0;
+			size_t bestBin = 0;
+			for (size_t axis = 0; axis < 3; ++axis) {
+				float extent = centroids.max[axis] - centroids.min[axis];
+				if (!(extent > 0.0f)) {
+					continue;
+				}
+
+				for (BVHBin& bin : bins) {
+					bin.box = BoundingBox();
+					bin.count = 0;
+				}
+
+				float scale = binCount / extent;
+				for (uint32_t i = range.begin; i < range.end; ++i) {
+					const BoundingBox& itemBox = items[order[i]].box;
+					float centroid = (itemBox.min[axis] + itemBox.max[axis]) * 0.5f;
+					size_t b = std::min(static_cast<size_t>((centroid - centroids.min[axis]) * scale), binCount - 1);
+					bins[b].box.Include(itemBox);
+					++bins[b].count;
+				}
+
+				BoundingBox right;
+				size_t rightCount = 0;
+				for (size_t b = binCount - 1; b > 0; --b) {
+					right.Include(bins[b].box);
+					rightCount += bins[b].count;
+					rightCosts[b] = GetHalfArea(right) * rightCount;
+				}
+
+				BoundingBox left;
+				size_t leftCount = 0;
+				for (size_t b = 0; b + 1 < binCount; ++b) {
+					left.Include(bins[b].box);
+					leftCount += bins[b].count;
+					if (!leftCount || leftCount == count) {
+						continue;
+					}
+
+					float cost = GetHalfArea(left) * leftCount + rightCosts[b + 1];
+					if (cost < bestCost) {
+						bestCost = cost;
+						bestAxis = axis;
+						bestBin = b;
+					}
+				}
+			}
+
+			// Small ranges become leaves unless a split is cheaper than testing every item, counting one unit for
+			// the traversal of the node itself.
+			bool canSplit = bestCost < INFINITY;
+			if (count <= options.maxLeafSize) {
+				float area = GetHalfArea(box);
+				if (!canSplit || !(area > 0.0f) || 1.0f + bestCost / area >= count) {
+					continue;
+				}
+			}
+
+			uint32_t middle;
+			if (canSplit) {
+				float minimum = centroids.min[bestAxis];
+				float scale = binCount / (centroids.max[bestAxis] - minimum);
+				auto split = std::partition(order.begin() + range.begin, order.begin() + range.end, [&](uint32_t item) {
+					const BoundingBox& itemBox = items[item].box;
+					float centroid = (itemBox.min[bestAxis] + itemBox.max[bestAxis]) * 0.5f;
+					return std::min(static_cast<size_t>((centroid - minimum) * scale), binCount - 1) <= bestBin;
+				});
+
+				middle = static_cast<uint32_t>(split - order.begin());
+			}
+			else {
+				// Every centroid is in the same place, so any split is as good as another.
+				middle = range.begin + static_cast<uint32_t>(count / 2);
+			}
+
+			uint32_t firstChild = static_cast<uint32_t>(nodes.size());
+			nodes.resize(nodes.size() + 2);
+			nodes[range.node].firstChildOrItem = firstChild;
+			nodes[range.node].itemCount = 0;
+
+			BVHRange left = {firstChild, range.begin, middle};
+			BVHRange right = {firstChild + 1, middle, range.end};
+			stack.push_back(right);
+			stack.push_back(left);
+		}
+	}
+
+	void BVH::Build(std::vector<BVHItem> newItems, const BVHOptions& options) {
+		items = std::move(newItems);
+		nodes.clear();
+		order.resize(items.size());
+		std::iota(order.begin(), order.end(), 0);
+
+		if (items.empty()) {
+			return;
+		}
+
+		// The root is followed by an unused node so that every pair of siblings starts a cache line.
+		nodes.resize(2);
+		memset(&nodes[1], 0, sizeof(BVHNode));
+
+		size_t deferSize = std::max(items.size() / (GetParallelThreadCount() * 8), MIN_SUBTREE_SIZE);
+		std::vector<BVHRange> deferred;
+		BVHRange root = {0, 0, static_cast<uint32_t>(items.size())};
+		SplitRange(items, options, root, deferSize, order, nodes, &deferred);
+
+		// Subtrees cover disjoint ranges of the item order, so they can be built into their own arrays in parallel.
+		std::vector<BVHNodeArray> subtrees(deferred.size());
+		ParallelFor(deferred.size(), 1, [&](size_t begin, size_t end) {
+			for (size_t s = begin; s < end; ++s) {
+				BVHRange range = deferred[s];
+				range.node = 0;
+
+				subtrees[s].resize(2);
+				SplitRange(items, options, range, 0, order, subtrees[s], nullptr);
+			}
+		});
+
+		// Each subtree replaces the node it was deferred from and appends its descendants, without its unused node.
+		for (size_t s = 0; s < subtrees.size(); ++s) {
+			BVHNodeArray& subtree = subtrees[s];
+			uint32_t offset = static_cast<uint32_t>(nodes.size()) - 2;
+
+			for (BVHNode& node : subtree) {
+				if (!node.itemCount) {
+					node.firstChildOrItem += offset;
+				}
+			}
+
+			nodes[deferred[s].node] = subtree[0];
+			nodes.insert(nodes.end(), subtree.begin() + 2, subtree.end());
+		}
+	}
+
+	bool BVH::Build(const glTF& doc, const std::string& newSceneId, const BVHOptions& options, std::string& outErr) {
+		FlatScene scene;
+		if (!FlattenScene(doc, newSceneId, &scene, outErr)) {
+			return false;
+		}
+
+		// Only the meshes that the scene draws are bounded.
+		std::vector<std::string> meshIds;
+		for (const Node* node : scene.nodes) {
+			meshIds.insert(meshIds.end(), node->meshes.begin(), node->meshes.end());
+		}
+
+		std::sort(meshIds.begin(), meshIds.end());
+		meshIds.erase(std::unique(meshIds.begin(), meshIds.end()), meshIds.end());
+
+		std::unordered_map<std::string, MeshBounds> meshBounds;
+		if (!ComputeMeshBounds(doc, meshIds, BoundsOptions(), &meshBounds, outErr)) {
+			return false;
+		}
+
+		std::vector<float> worlds;
+		ComputeWorldMatrices(scene, &worlds);
+
+		std::vector<BVHItem> newItems;
+		for (size_t n = 0; n < scene.GetCount(); ++n) {
+			for (const std::string& meshId : scene.nodes[n]->meshes) {
+				const std::vector<PrimitiveBounds>& primitives = meshBounds.at(meshId).primitives;
+				for (size_t p = 0; p < primitives.size(); ++p) {
+					if (primitives[p].box.IsEmpty()) {
+						continue;
+					}
+
+					BVHItem item;
+					item.node = scene.ids[n];
+					item.mesh = meshId;
+					item.primitive = static_cast<uint32_t>(p);
+					item.localBox = primitives[p].box;
+					item.box = TransformBoundingBox(&worlds[n * 16], item.localBox);
+					newItems.push_back(std::move(item));
+				}
+			}
+		}
+
+		Build(std::move(newItems), options);
+		sceneId = newSceneId;
+		return true;
+	}
+
+	bool BVH::Refit(const glTF& doc, std::string& outErr) {
+		FlatScene scene;
+		if (!FlattenScene(doc, sceneId, &scene, outErr)) {
+			return false;
+		}
+
+		std::vector<float> worlds;
+		ComputeWorldMatrices(scene, &worlds);
+
+		for (BVHItem& item : items) {
+			auto index = scene.indices.find(item.node);
+			if (index == scene.indices.end()) {
+				outErr = "The node '" + item.node + "' is no longer part of the scene '" + sceneId + "'.";
+				return false;
+			}
+
+			item.box = TransformBoundingBox(&worlds[index->second * 16], item.localBox);
+		}
+
+		Refit();
+		return true;
+	}
+
+	void BVH::SetItemBox(uint32_t item, const BoundingBox& box) {
+		items[item].box = box;
+	}
+
+	void BVH::Refit() {
+		// Children always come after their parent, so walking backwards reaches every child first.
+		for (size_t n = nodes.size(); n-- > 0;) {
+			if (n == 1) {
+				continue;
+			}
+
+			BVHNode& node = nodes[n];
+			BoundingBox box;
+			if (node.itemCount) {
+				for (uint32_t i = node.firstChildOrItem; i < node.firstChildOrItem + node.itemCount; ++i) {
+					box.Include(items[order[i]].box);
+				}
+			}
+			else {
+				box = GetNodeBox(nodes[node.firstChildOrItem]);
+				box.Include(GetNodeBox(nodes[node.firstChildOrItem + 1]));
+			}
+
+			SetNodeBox(box, &node);
+		}
+	}
+
+	void BVH::QueryBox(const BoundingBox& box, std::vector<uint32_t>* outItems) const {
+		if (nodes.empty()) {
+			return;
+		}
+
+		std::vector<uint32_t> stack(1, 0);
+		while (!stack.empty()) {
+			const BVHNode& node = nodes[stack.back()];
+			stack.pop_back();
+
+			if (!Overlaps(GetNodeBox(node), box)) {
+				continue;
+			}
+
+			if (!node.itemCount) {
+				stack.push_back(node.firstChildOrItem + 1);
+				stack.push_back(node.firstChildOrItem);
+				continue;
+			}
+
+			for (uint32_t i = node.firstChildOrItem; i < node.firstChildOrItem + node.itemCount; ++i) {
+				if (Overlaps(items[order[i]].box, box)) {
+					outItems->push_back(order[i]);
+				}
+			}
+		}
+	}
+
+	enum FrustumTest {
+		FRUSTUM_OUTSIDE,
+		FRUSTUM_INTERSECTS,
+		FRUSTUM_INSIDE
+	};
+
+	// Tests the corner of the box furthest along each plane normal, then the nearest one.
+	static FrustumTest TestFrustum(const Frustum& frustum, const float* min, const float* max) {
+		FrustumTest result = FRUSTUM_INSIDE;
+		for (size_t p = 0; p < 6; ++p) {
+			const float* plane = frustum.planes[p];
+			float furthest = plane[3];
+			float nearest = plane[3];
+			for (size_t axis = 0; axis < 3; ++axis) {
+				furthest += plane[axis] * (plane[axis] >= 0.0f ? max[axis] : min[axis]);
+				nearest += plane[axis] * (plane[axis] >= 0.0f ? min[axis] : max[axis]);
+			}
+
+			if (furthest < 0.0f) {
+				return FRUSTUM_OUTSIDE;
+			}
+
+			if (nearest < 0.0f) {
+				result = FRUSTUM_INTERSECTS;
+			}
+		}
+
+		return result;
+	}
+
+	void BVH::QueryFrustum(const Frustum& frustum, std::vector<uint32_t>* outItems) const {
+		if (nodes.empty()) {
+			return;
+		}
+
+		// Subtrees that are entirely inside are appended without testing anything below them.
+		std::vector<std::pair<uint32_t, bool>> stack(1, std::make_pair(0u, false));
+		while (!stack.empty()) {
+			const BVHNode& node = nodes[stack.back().first];
+			bool inside = stack.back().second;
+			stack.pop_back();
+
+			if (!inside) {
+				FrustumTest test = TestFrustum(frustum, node.min, node.max);
+				if (test == FRUSTUM_OUTSIDE) {
+					continue;
+				}
+
+				inside = test == FRUSTUM_INSIDE;
+			}
+
+			if (!node.itemCount) {
+				stack.push_back(std::make_pair(node.firstChildOrItem + 1, inside));
+				stack.push_back(std::make_pair(node.firstChildOrItem, inside));
+				continue;
+			}
+
+			for (uint32_t i = node.firstChildOrItem; i < node.firstChildOrItem + node.itemCount; ++i) {
+				const BoundingBox& itemBox = items[order[i]].box;
+				if (inside || TestFrustum(frustum, itemBox.min, itemBox.max) != FRUSTUM_OUTSIDE) {
+					outItems->push_back(order[i]);
+				}
+			}
+		}
+	}
+
+	// Returns the distance at which a ray enters a box, or a negative value if it misses it within maxDistance.
+	static float IntersectRay(const float* origin, const float* inverseDirection, float maxDistance, const float* min, const float* max) {
+		float enter = 0.0f;
+		float exit = maxDistance;
+		for (size_t axis = 0; axis < 3; ++axis) {
+			float t0 = (min[axis] - origin[axis]) * inverseDirection[axis];
+			float t1 = (max[axis] - origin[axis]) * inverseDirection[axis];
+			enter = std::max(enter, std::min(t0, t1));
+			exit = std::min(exit, std::max(t0, t1));
+		}
+
+		return enter <= exit ? enter : -1.0f;
+	}
+
+	void BVH::QueryRay(const float* origin, const float* direction, float maxDistance, std::vector<BVHRayHit>* outHits) const {
+		if (nodes.empty()) {
+			return;
+		}
+
+		float inverseDirection[3];
+		for (size_t axis = 0; axis < 3; ++axis) {
+			inverseDirection[axis] = 1.0f / direction[axis];
+		}
+
+		size_t firstHit = outHits->size();
+		std::vector<uint32_t> stack(1, 0);
+		while (!stack.empty()) {
+			const BVHNode& node = nodes[stack.back()];
+			stack.pop_back();
+
+			if (IntersectRay(origin, inverseDirection, maxDistance, node.min, node.max) < 0.0f) {
+				continue;
+			}
+
+			if (!node.itemCount) {
+				stack.push_back(node.firstChildOrItem + 1);
+				stack.push_back(node.firstChildOrItem);
+				continue;
+			}
+
+			for (uint32_t i = node.firstChildOrItem; i < node.firstChildOrItem + node.itemCount; ++i) {
+				const BoundingBox& itemBox = items[order[i]].box;
+				float distance = IntersectRay(origin, inverseDirection, maxDistance, itemBox.min, itemBox.max);
+				if (distance >= 0.0f) {
+					BVHRayHit hit = {order[i], distance};
+					outHits->push_back(hit);
+				}
+			}
+		}
+
+		std::sort(outHits->begin() + firstHit, outHits->end(), [](const BVHRayHit& a, const BVHRayHit& b) {
+			return a.distance < b.distance || (a.distance == b.distance && a.item < b.item);
+		});
+	}
+
+	// Each plane is a sum or difference of the last row of the matrix and one of the others.
+	void ExtractFrustum(const float* viewProjection, Frustum* out) {
+		for (size_t p = 0; p < 6; ++p) {
+			size_t row = p / 2;
+			float sign = p % 2 ? -1.0f : 1.0f;
+
+			float* plane = out->planes[p];
+			for (size_t column = 0; column < 4; ++column) {
+				plane[column] = viewProjection[column * 4 + 3] + sign * viewProjection[column * 4 + row];
+			}
+
+			float length = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+			if (length > 0.0f) {
+				for (size_t column = 0; column < 4; ++column) {
+					plane[column] /= length;
+				}
+			}
+		}
+	}
+}
\ No newline at end of file
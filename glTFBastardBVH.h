@@ -0,0 +1,136 @@
+/*
+Copyright (c) 2016 Ruben Cashie
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation 
+files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, 
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software 
+is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES 
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE 
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef GLTF_BASTARD_BVH_H
+#define GLTF_BASTARD_BVH_H
+
+#include <cstdint>
+#include "glTFBastardBounds.h"
+#include "glTFBastardSimd.h"
+
+namespace glTFBastard {
+
+	// A node of a BVH. Interior nodes have an itemCount of zero and two children at firstChildOrItem and the index
+	// after it; leaves refer to itemCount entries of the item order starting at firstChildOrItem.
+	// Siblings are stored next to each other on one cache line.
+	struct BVHNode {
+		float min[3];
+		uint32_t firstChildOrItem;
+		float max[3];
+		uint32_t itemCount;
+	};
+
+	// A primitive of a node in a scene. Only box is used when building over arbitrary items.
+	struct BVHItem {
+		std::string node;
+		std::string mesh;
+		uint32_t primitive;
+
+		// The bounds of the primitive in the space of its mesh, and in world space.
+		BoundingBox localBox;
+		BoundingBox box;
+
+		BVHItem() :
+			primitive(0) {
+		}
+	};
+
+	// Six planes with inward facing normals; a point p is inside when dot(plane.xyz, p) + plane.w >= 0 for all of them.
+	struct Frustum {
+		float planes[6][4];
+	};
+
+	// Extracts the planes of the frustum of a column major view projection matrix that maps to a -1 to 1 depth
+	// range, as OpenGL does. Planes are normalized.
+	void ExtractFrustum(const float* viewProjection, Frustum* out);
+
+	struct BVHRayHit {
+		uint32_t item;
+
+		// The distance along the ray, in multiples of the direction, at which it enters the box of the item.
+		float distance;
+	};
+
+	struct BVHOptions {
+		// Ranges of at most this many items become leaves when splitting them is not worth it by the surface area
+		// heuristic. Larger ranges are always split.
+		size_t maxLeafSize;
+
+		// The number of bins per axis that split candidates are evaluated with.
+		size_t binCount;
+
+		BVHOptions() :
+			maxLeafSize(4),
+			binCount(16) {
+		}
+	};
+
+	// A bounding volume hierarchy over world space primitive bounds, built with the binned surface area heuristic.
+	// The top levels are split on the calling thread until there are enough independent subtrees to keep every
+	// thread busy, and those subtrees are built in parallel.
+	// Queries are read-only and can run concurrently; building and refitting can not run with anything else.
+	class BVH {
+	public:
+		// Builds over every primitive with POSITION data of every node reachable from the roots of a scene.
+		// The buffers of the POSITION accessors of the meshes of the scene must have been loaded.
+		bool Build(const glTF& doc, const std::string& sceneId, const BVHOptions& options, std::string& outErr);
+
+		// Builds over arbitrary items, none of which may have an empty box.
+		void Build(std::vector<BVHItem> items, const BVHOptions& options);
+
+		// Recomputes the world space boxes of the items from the current node transforms and refits the hierarchy
+		// without changing its structure. Fails if the node of an item is no longer part of the scene; added nodes
+		// and changed meshes are not picked up. Refitted hierarchies answer queries correctly but get slower as
+		// objects move apart; build again when that matters.
+		bool Refit(const glTF& doc, std::string& outErr);
+
+		// Changes the box of an item; call Refit() once all of them have been changed.
+		void SetItemBox(uint32_t item, const BoundingBox& box);
+
+		// Recomputes the boxes of every node from the boxes of the items.
+		void Refit();
+
+		// Appends the items whose boxes overlap a box.
+		void QueryBox(const BoundingBox& box, std::vector<uint32_t>* outItems) const;
+
+		// Appends the items whose boxes are not entirely outside of a frustum.
+		void QueryFrustum(const Frustum& frustum, std::vector<uint32_t>* outItems) const;
+
+		// Appends the items whose boxes the ray enters within maxDistance, nearest first.
+		void QueryRay(const float* origin, const float* direction, float maxDistance, std::vector<BVHRayHit>* outHits) const;
+
+		const std::vector<BVHItem>& GetItems() const {
+			return items;
+		}
+
+		const std::vector<BVHNode, CacheLineAllocator<BVHNode>>& GetNodes() const {
+			return nodes;
+		}
+
+		// The item indices that leaves refer to.
+		const std::vector<uint32_t>& GetItemOrder() const {
+			return order;
+		}
+
+	private:
+		std::vector<BVHItem> items;
+		std::vector<BVHNode, CacheLineAllocator<BVHNode>> nodes;
+		std::vector<uint32_t> order;
+		std::string sceneId;
+	};
+}
+
+#endif
\ No newline at end of file
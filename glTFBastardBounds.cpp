@@ -0,0 +1,721 @@
+/*
+Copyright (c) 2016 Ruben Cashie
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation 
+files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, 
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software 
+is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES 
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE 
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_set>
+#include "glTFBastardBounds.h"
+#include "glTFBastardConvert.h"
+#include "glTFBastardMath.h"
+#include "glTFBastardParallel.h"
+#include "glTFBastardSceneGraph.h"
+#include "glTFBastardSimd.h"
+
+namespace glTFBastard {
+
+	// The largest number of components an accessor element can have (MAT4).
+	static const size_t MAX_COMPONENT_COUNT = 16;
+
+	// The number of bytes of accessor data that a single task reduces.
+	static const size_t MIN_MAX_TASK_BYTES = 256 * 1024;
+
+	// The number of elements converted at a time when an accessor can not be reduced in place.
+	static const size_t MIN_MAX_BLOCK_SIZE = 1024;
+
+	// A running per-component minimum and maximum.
+	struct MinMax {
+		float min[MAX_COMPONENT_COUNT];
+		float max[MAX_COMPONENT_COUNT];
+
+		MinMax() {
+			std::fill(min, min + MAX_COMPONENT_COUNT, std::numeric_limits<float>::infinity());
+			std::fill(max, max + MAX_COMPONENT_COUNT, -std::numeric_limits<float>::infinity());
+		}
+
+		void Include(size_t component, float value) {
+			// Written so that NaN values are ignored.
+			if (value < min[component]) {
+				min[component] = value;
+			}
+
+			if (value > max[component]) {
+				max[component] = value;
+			}
+		}
+
+		void Merge(const MinMax& other, size_t componentCount) {
+			for (size_t c = 0; c < componentCount; ++c) {
+				min[c] = std::min(min[c], other.min[c]);
+				max[c] = std::max(max[c], other.max[c]);
+			}
+		}
+	};
+
+	// Returns the least common multiple of the vector width and the component count.
+	static size_t GetComponentPeriod(size_t vectorWidth, size_t componentCount) {
+		size_t period = componentCount;
+		while (period % vectorWidth) {
+			period += componentCount;
+		}
+
+		return period;
+	}
+
+	// Reduces tightly packed float elements. The elements are treated as one flat stream of floats where
+	// float j belongs to component j % componentCount; that pattern repeats every GetComponentPeriod floats,
+	// so each vector accumulator always sees the same components in the same lanes.
+	static void ReducePackedFloats(const unsigned char* data, size_t elementCount, size_t componentCount, MinMax* inOut) {
+		size_t floatCount = elementCount * componentCount;
+		size_t j = 0;
+
+#if defined(GLTF_BASTARD_AVX2)
+		const size_t width = 8;
+		size_t period = GetComponentPeriod(width, componentCount);
+		size_t vectorCount = period / width;
+
+		__m256 mins[MAX_COMPONENT_COUNT];
+		__m256 maxs[MAX_COMPONENT_COUNT];
+		for (size_t v = 0; v < vectorCount; ++v) {
+			mins[v] = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+			maxs[v] = _mm256_set1_ps(-std::numeric_limits<float>::infinity());
+		}
+
+		const float* floats = reinterpret_cast<const float*>(data);
+		for (; j + period <= floatCount; j += period) {
+			for (size_t v = 0; v < vectorCount; ++v) {
+				__m256 value = _mm256_loadu_ps(floats + j + v * width);
+				mins[v] = _mm256_min_ps(value, mins[v]);
+				maxs[v] = _mm256_max_ps(value, maxs[v]);
+			}
+		}
+
+		for (size_t v = 0; v < vectorCount; ++v) {
+			float laneMins[width];
+			float laneMaxs[width];
+			_mm256_storeu_ps(laneMins, mins[v]);
+			_mm256_storeu_ps(laneMaxs, maxs[v]);
+
+			for (size_t lane = 0; lane < width; ++lane) {
+				size_t component = (v * width + lane) % componentCount;
+				inOut->min[component] = std::min(inOut->min[component], laneMins[lane]);
+				inOut->max[component] = std::max(inOut->max[component], laneMaxs[lane]);
+			}
+		}
+#elif defined(GLTF_BASTARD_SSE2)
+		const size_t width = 4;
+		size_t period = GetComponentPeriod(width, componentCount);
+		size_t vectorCount = period / width;
+
+		__m128 mins[MAX_COMPONENT_COUNT];
+		__m128 maxs[MAX_COMPONENT_COUNT];
+		for (size_t v = 0; v < vectorCount; ++v) {
+			mins[v] = _mm_set1_ps(std::numeric_limits<float>::infinity());
+			maxs[v] = _mm_set1_ps(-std::numeric_limits<float>::infinity());
+		}
+
+		const float* floats = reinterpret_cast<const float*>(data);
+		for (; j + period <= floatCount; j += period) {
+			for (size_t v = 0; v < vectorCount; ++v) {
+				__m128 value = _mm_loadu_ps(floats + j + v * width);
+				mins[v] = _mm_min_ps(value, mins[v]);
+				maxs[v] = _mm_max_ps(value, maxs[v]);
+			}
+		}
+
+		for (size_t v = 0; v < vectorCount; ++v) {
+			float laneMins[width];
+			float laneMaxs[width];
+			_mm_storeu_ps(laneMins, mins[v]);
+			_mm_storeu_ps(laneMaxs, maxs[v]);
+
+			for (size_t lane = 0; lane < width; ++lane) {
+				size_t component = (v * width + lane) % componentCount;
+				inOut->min[component] = std::min(inOut->min[component], laneMins[lane]);
+				inOut->max[component] = std::max(inOut->max[component], laneMaxs[lane]);
+			}
+		}
+#endif
+
+		for (; j < floatCount; ++j) {
+			float value;
+			memcpy(&value, data + j * sizeof(float), sizeof(float));
+			inOut->Include(j % componentCount, value);
+		}
+	}
+
+	// Reduces an array of floats into a single minimum and maximum.
+	static void ReduceFloats(const float* values, size_t count, float* inOutMin, float* inOutMax) {
+		size_t i = 0;
+		float minimum = *inOutMin;
+		float maximum = *inOutMax;
+
+#if defined(GLTF_BASTARD_SSE2)
+		if (count >= 4) {
+			__m128 mins = _mm_set1_ps(minimum);
+			__m128 maxs = _mm_set1_ps(maximum);
+			for (; i + 4 <= count; i += 4) {
+				__m128 value = _mm_loadu_ps(values + i);
+				mins = _mm_min_ps(value, mins);
+				maxs = _mm_max_ps(value, maxs);
+			}
+
+			float laneMins[4];
+			float laneMaxs[4];
+			_mm_storeu_ps(laneMins, mins);
+			_mm_storeu_ps(laneMaxs, maxs);
+			for (size_t lane = 0; lane < 4; ++lane) {
+				minimum = std::min(minimum, laneMins[lane]);
+				maximum = std::max(maximum, laneMaxs[lane]);
+			}
+		}
+#endif
+
+		for (; i < count; ++i) {
+			if (values[i] < minimum) {
+				minimum = values[i];
+			}
+
+			if (values[i] > maximum) {
+				maximum = values[i];
+			}
+		}
+
+		*inOutMin = minimum;
+		*inOutMax = maximum;
+	}
+
+	// Reduces the elements [begin, end) of an accessor.
+	static bool ReduceRange(const AccessorData& data, size_t begin, size_t end, MinMax* inOut, std::string& outErr) {
+		size_t componentCount = GetComponentCount(data.type);
+		size_t componentSize = GetComponentSize(data.componentType);
+		size_t elementSize = componentCount * componentSize;
+
+		const unsigned char* first = data.data + begin * data.byteStride;
+		if (data.componentType == Accessor::COMPONENT_TYPE_FLOAT && data.byteStride == elementSize) {
+			ReducePackedFloats(first, end - begin, componentCount, inOut);
+			return true;
+		}
+
+		// Indices are the only accessors with 32 bit integers, and there is no conversion kernel for them.
+		if (data.componentType == Accessor::COMPONENT_TYPE_UNSIGNED_INT) {
+			for (size_t i = begin; i < end; ++i) {
+				for (size_t c = 0; c < componentCount; ++c) {
+					uint32_t value;
+					memcpy(&value, data.data + i * data.byteStride + c * componentSize, sizeof(value));
+					inOut->Include(c, static_cast<float>(value));
+				}
+			}
+
+			return true;
+		}
+
+		// Everything else is converted to floats a block at a time with the vectorized kernels.
+		std::vector<float> scratch(componentCount * MIN_MAX_BLOCK_SIZE);
+		float* components[MAX_COMPONENT_COUNT];
+		for (size_t c = 0; c < componentCount; ++c) {
+			components[c] = &scratch[c * MIN_MAX_BLOCK_SIZE];
+		}
+
+		for (size_t blockBegin = begin; blockBegin < end; blockBegin += MIN_MAX_BLOCK_SIZE) {
+			AccessorData block = data;
+			block.data = data.data + blockBegin * data.byteStride;
+			block.count = std::min(MIN_MAX_BLOCK_SIZE, end - blockBegin);
+
+			if (!ConvertAccessorToSoA(block, false, components, outErr)) {
+				return false;
+			}
+
+			for (size_t c = 0; c < componentCount; ++c) {
+				ReduceFloats(components[c], block.count, &inOut->min[c], &inOut->max[c]);
+			}
+		}
+
+		return true;
+	}
+
+	// A range of elements of one accessor reduced by a single task.
+	struct MinMaxTask {
+		size_t accessorIndex;
+		size_t begin;
+		size_t end;
+	};
+
+	// Splits the accessors into tasks and reduces them in parallel into one result per accessor.
+	static bool ReduceAccessors(const std::vector<AccessorData>& accessors, std::vector<MinMax>* outResults, std::string& outErr) {
+		std::vector<MinMaxTask> tasks;
+		for (size_t a = 0; a < accessors.size(); ++a) {
+			size_t elementsPerTask = std::max<size_t>(1, MIN_MAX_TASK_BYTES / accessors[a].byteStride);
+			for (size_t begin = 0; begin < accessors[a].count; begin += elementsPerTask) {
+				MinMaxTask task;
+				task.accessorIndex = a;
+				task.begin = begin;
+				task.end = std::min(accessors[a].count, begin + elementsPerTask);
+				tasks.push_back(task);
+			}
+		}
+
+		std::vector<MinMax> partials(tasks.size());
+		std::vector<std::string> errors(tasks.size());
+		ParallelFor(tasks.size(), 1, [&](size_t begin, size_t end) {
+			for (size_t t = begin; t < end; ++t) {
+				const MinMaxTask& task = tasks[t];
+				ReduceRange(accessors[task.accessorIndex], task.begin, task.end, &partials[t], errors[t]);
+			}
+		});
+
+		outResults->assign(accessors.size(), MinMax());
+		for (size_t t = 0; t < tasks.size(); ++t) {
+			if (!errors[t].empty()) {
+				outErr = errors[t];
+				return false;
+			}
+
+			const AccessorData& accessor = accessors[tasks[t].accessorIndex];
+			(*outResults)[tasks[t].accessorIndex].Merge(partials[t], GetComponentCount(accessor.type));
+		}
+
+		return true;
+	}
+
+	// Computes the per-component minimum and maximum of the elements of an accessor.
+	bool ComputeAccessorMinMax(const AccessorData& data, std::vector<float>* outMin, std::vector<float>* outMax, std::string& outErr) {
+		size_t componentCount = GetComponentCount(data.type);
+		if (!componentCount || !GetComponentSize(data.componentType)) {
+			outErr = "Could not compute the min/max of accessor data. Unsupported type.";
+			return false;
+		}
+
+		AccessorData packed = data;
+		if (!packed.byteStride) {
+			packed.byteStride = componentCount * GetComponentSize(data.componentType);
+		}
+
+		std::vector<MinMax> results;
+		if (!ReduceAccessors(std::vector<AccessorData>(1, packed), &results, outErr)) {
+			return false;
+		}
+
+		outMin->assign(results[0].min, results[0].min + componentCount);
+		outMax->assign(results[0].max, results[0].max + componentCount);
+		return true;
+	}
+
+	// Returns true if the parsed values match the computed ones within tolerance.
+	static bool MatchesWithinTolerance(const std::vector<float>& parsed, const float* computed, size_t componentCount, float tolerance) {
+		if (parsed.size() != componentCount) {
+			return false;
+		}
+
+		for (size_t c = 0; c < componentCount; ++c) {
+			float allowed = tolerance * std::max(1.0f, std::fabs(computed[c]));
+			if (!(std::fabs(parsed[c] - computed[c]) <= allowed)) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	// Computes the min/max of every accessor and validates or updates them.
+	bool UpdateAccessorMinMax(
+		glTF* doc,
+		AccessorMinMaxPolicy policy,
+		float tolerance,
+		AccessorMinMaxReport* outReport,
+		std::string& outErr) {
+
+		std::vector<std::pair<const std::string*, Accessor*>> accessors;
+		std::vector<AccessorData> accessorData;
+		accessors.reserve(doc->accessors.size());
+		accessorData.reserve(doc->accessors.size());
+
+		for (auto& entry : doc->accessors) {
+			AccessorData data;
+			if (!GetAccessorData(*doc, *entry.second, &data, outErr)) {
+				return false;
+			}
+
+			// Empty accessors have no bounds to check.
+			if (!data.count) {
+				continue;
+			}
+
+			accessors.push_back(std::make_pair(&entry.first, entry.second.get()));
+			accessorData.push_back(data);
+		}
+
+		std::vector<MinMax> results;
+		if (!ReduceAccessors(accessorData, &results, outErr)) {
+			return false;
+		}
+
+		outReport->missing.clear();
+		outReport->mismatched.clear();
+
+		for (size_t a = 0; a < accessors.size(); ++a) {
+			Accessor* accessor = accessors[a].second;
+			const MinMax& result = results[a];
+			size_t componentCount = GetComponentCount(accessor->type);
+
+			bool isMissing = accessor->min.empty() || accessor->max.empty();
+			bool isMismatched = !isMissing
+				&& (!MatchesWithinTolerance(accessor->min, result.min, componentCount, tolerance)
+					|| !MatchesWithinTolerance(accessor->max, result.max, componentCount, tolerance));
+
+			if (isMissing) {
+				outReport->missing.push_back(*accessors[a].first);
+			}
+			else if (isMismatched) {
+				outReport->mismatched.push_back(*accessors[a].first);
+			}
+
+			bool update = (isMissing && policy != ACCESSOR_MIN_MAX_VALIDATE)
+				|| (isMismatched && policy == ACCESSOR_MIN_MAX_REPLACE);
+
+			if (update) {
+				accessor->min.assign(result.min, result.min + componentCount);
+				accessor->max.assign(result.max, result.max + componentCount);
+			}
+		}
+
+		std::sort(outReport->missing.begin(), outReport->missing.end());
+		std::sort(outReport->mismatched.begin(), outReport->mismatched.end());
+		return true;
+	}
+
+	// Returns the sphere around the center of a box that encloses the box.
+	static BoundingSphere GetBoxSphere(const BoundingBox& box) {
+		BoundingSphere sphere;
+		if (box.IsEmpty()) {
+			return sphere;
+		}
+
+		float lengthSquared = 0.0f;
+		for (size_t axis = 0; axis < 3; ++axis) {
+			sphere.center[axis] = (box.min[axis] + box.max[axis]) * 0.5f;
+			float half = (box.max[axis] - box.min[axis]) * 0.5f;
+			lengthSquared += half * half;
+		}
+
+		sphere.radius = std::sqrt(lengthSquared);
+		return sphere;
+	}
+
+	// Grows a sphere with a fixed center so that it encloses another sphere.
+	static void IncludeSphere(const BoundingSphere& other, BoundingSphere* inOut) {
+		if (other.radius < 0.0f) {
+			return;
+		}
+
+		float d[3] = {other.center[0] - inOut->center[0], other.center[1] - inOut->center[1], other.center[2] - inOut->center[2]};
+		inOut->radius = std::max(inOut->radius, std::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]) + other.radius);
+	}
+
+	// Applies the decode transform of a quantized POSITION accessor to a box of encoded values.
+	static void DecodeBox(const std::vector<float>& offset, const std::vector<float>& scale, BoundingBox* inOut) {
+		for (size_t axis = 0; axis < offset.size(); ++axis) {
+			float a = offset[axis] + inOut->min[axis] * scale[axis];
+			float b = offset[axis] + inOut->max[axis] * scale[axis];
+			inOut->min[axis] = std::min(a, b);
+			inOut->max[axis] = std::max(a, b);
+		}
+	}
+
+	// Computes the box of a POSITION accessor and the sphere around its center that encloses every position.
+	static bool ComputePositionBounds(const glTF& doc, const std::string& accessorId, const BoundsOptions& options, PrimitiveBounds* out, std::string& outErr) {
+		auto itr = doc.accessors.find(accessorId);
+		if (itr == doc.accessors.end()) {
+			outErr = "The accessor '" + accessorId + "' does not exist.";
+			return false;
+		}
+
+		// The min/max of a quantized accessor hold its integer range, so they are decoded like the positions.
+		std::vector<float> offset;
+		std::vector<float> scale;
+		if (!GetAccessorDecode(doc, accessorId, &offset, &scale, outErr)) {
+			return false;
+		}
+
+		const Accessor& accessor = *itr->second;
+		if (options.trustAccessorMinMax && accessor.min.size() == 3 && accessor.max.size() == 3) {
+			for (size_t axis = 0; axis < 3; ++axis) {
+				out->box.min[axis] = accessor.min[axis];
+				out->box.max[axis] = accessor.max[axis];
+			}
+
+			DecodeBox(offset, scale, &out->box);
+
+			out->sphere = GetBoxSphere(out->box);
+			return true;
+		}
+
+		AccessorData data;
+		if (!GetAccessorData(doc, accessor, &data, outErr)) {
+			return false;
+		}
+
+		if (GetComponentCount(data.type) != 3) {
+			outErr = "The POSITION accessor '" + accessorId + "' is not a VEC3.";
+			return false;
+		}
+
+		if (!data.count) {
+			return true;
+		}
+
+		std::vector<float> minimum;
+		std::vector<float> maximum;
+		if (!ComputeAccessorMinMax(data, &minimum, &maximum, outErr)) {
+			return false;
+		}
+
+		for (size_t axis = 0; axis < 3; ++axis) {
+			out->box.min[axis] = minimum[axis];
+			out->box.max[axis] = maximum[axis];
+		}
+
+		DecodeBox(offset, scale, &out->box);
+
+		// A second pass finds the position furthest from the center of the box.
+		out->sphere = GetBoxSphere(out->box);
+		const float* center = out->sphere.center;
+		float radiusSquared = 0.0f;
+
+		std::vector<float> block(MIN_MAX_BLOCK_SIZE * 3);
+		float* components[3] = {&block[0], &block[MIN_MAX_BLOCK_SIZE], &block[MIN_MAX_BLOCK_SIZE * 2]};
+		for (size_t begin = 0; begin < data.count; begin += MIN_MAX_BLOCK_SIZE) {
+			AccessorData range = data;
+			range.data += begin * data.byteStride;
+			range.count = std::min(MIN_MAX_BLOCK_SIZE, data.count - begin);
+			if (!ConvertAccessorToSoA(range, false, components, outErr)) {
+				return false;
+			}
+
+			DecodeComponents(offset, scale, range.count, components);
+			for (size_t i = 0; i < range.count; ++i) {
+				float dx = components[0][i] - center[0];
+				float dy = components[1][i] - center[1];
+				float dz = components[2][i] - center[2];
+				radiusSquared = std::max(radiusSquared, dx * dx + dy * dy + dz * dz);
+			}
+		}
+
+		out->sphere.radius = std::sqrt(radiusSquared);
+		return true;
+	}
+
+	// Transforms the center and extent of the box rather than its eight corners; the result is the same.
+	BoundingBox TransformBoundingBox(const float* matrix, const BoundingBox& box) {
+		BoundingBox result;
+		if (box.IsEmpty()) {
+			return result;
+		}
+
+		float center[3];
+		float extent[3];
+		for (size_t axis = 0; axis < 3; ++axis) {
+			center[axis] = (box.min[axis] + box.max[axis]) * 0.5f;
+			extent[axis] = (box.max[axis] - box.min[axis]) * 0.5f;
+		}
+
+		float transformedCenter[3];
+		TransformPoint(matrix, center, transformedCenter);
+
+		for (size_t row = 0; row < 3; ++row) {
+			float transformedExtent = std::fabs(matrix[row]) * extent[0]
+				+ std::fabs(matrix[4 + row]) * extent[1]
+				+ std::fabs(matrix[8 + row]) * extent[2];
+
+			result.min[row] = transformedCenter[row] - transformedExtent;
+			result.max[row] = transformedCenter[row] + transformedExtent;
+		}
+
+		return result;
+	}
+
+	// A primitive whose bounds are computed by one task.
+	struct PrimitiveBoundsJob {
+		std::string mesh;
+		size_t primitive;
+		std::string position;
+		std::string error;
+	};
+
+	// Computes the bounds of the primitives of a set of meshes, then of each mesh.
+	bool ComputeMeshBounds(
+		const glTF& doc,
+		const std::vector<std::string>& meshIds,
+		const BoundsOptions& options,
+		std::unordered_map<std::string, MeshBounds>* out,
+		std::string& outErr) {
+
+		out->clear();
+
+		std::vector<PrimitiveBoundsJob> jobs;
+		for (const std::string& meshId : meshIds) {
+			auto mesh = doc.meshes.find(meshId);
+			if (mesh == doc.meshes.end()) {
+				outErr = "The mesh '" + meshId + "' does not exist.";
+				return false;
+			}
+
+			MeshBounds& meshBounds = (*out)[meshId];
+			meshBounds.primitives.resize(mesh->second->primitives.size());
+
+			for (size_t p = 0; p < mesh->second->primitives.size(); ++p) {
+				auto position = mesh->second->primitives[p]->attributes.find("POSITION");
+				if (position != mesh->second->primitives[p]->attributes.end()) {
+					PrimitiveBoundsJob job;
+					job.mesh = meshId;
+					job.primitive = p;
+					job.position = position->second;
+					jobs.push_back(job);
+				}
+			}
+		}
+
+		ParallelFor(jobs.size(), 1, [&](size_t begin, size_t end) {
+			for (size_t j = begin; j < end; ++j) {
+				PrimitiveBoundsJob& job = jobs[j];
+				PrimitiveBounds* bounds = &out->at(job.mesh).primitives[job.primitive];
+				ComputePositionBounds(doc, job.position, options, bounds, job.error);
+			}
+		});
+
+		for (const PrimitiveBoundsJob& job : jobs) {
+			if (!job.error.empty()) {
+				outErr = job.error;
+				return false;
+			}
+		}
+
+		for (auto& mesh : *out) {
+			MeshBounds& meshBounds = mesh.second;
+			for (const PrimitiveBounds& primitive : meshBounds.primitives) {
+				meshBounds.box.Include(primitive.box);
+			}
+
+			meshBounds.sphere = GetBoxSphere(meshBounds.box);
+			if (!meshBounds.box.IsEmpty()) {
+				meshBounds.sphere.radius = 0.0f;
+				for (const PrimitiveBounds& primitive : meshBounds.primitives) {
+					IncludeSphere(primitive.sphere, &meshBounds.sphere);
+				}
+			}
+		}
+
+		return true;
+	}
+
+	// Computes the bounds of every primitive and mesh, then of every node.
+	bool ComputeSceneBounds(const glTF& doc, const BoundsOptions& options, SceneBounds* out, std::string& outErr) {
+		out->meshes.clear();
+		out->nodes.clear();
+
+		std::vector<std::string> meshIds;
+		for (auto& mesh : doc.meshes) {
+			meshIds.push_back(mesh.first);
+		}
+
+		if (!ComputeMeshBounds(doc, meshIds, options, &out->meshes, outErr)) {
+			return false;
+		}
+
+		// Flatten every node hierarchy of the document from the nodes that are nobody's child. Nodes that are not
+		// reached are part of a cycle, or below one, as the nodes of a cycle all have parents.
+		std::unordered_set<std::string> children;
+		for (auto& node : doc.nodes) {
+			children.insert(node.second->children.begin(), node.second->children.end());
+		}
+
+		std::vector<std::string> roots;
+		for (auto& node : doc.nodes) {
+			if (!children.count(node.first)) {
+				roots.push_back(node.first);
+			}
+		}
+
+		std::sort(roots.begin(), roots.end());
+
+		FlatScene flat;
+		if (!FlattenNodes(doc, roots, &flat, outErr)) {
+			return false;
+		}
+
+		if (flat.GetCount() != doc.nodes.size()) {
+			std::vector<std::string> unreached;
+			for (auto& node : doc.nodes) {
+				if (!flat.indices.count(node.first)) {
+					unreached.push_back(node.first);
+				}
+			}
+
+			outErr = "The node '" + *std::min_element(unreached.begin(), unreached.end()) + "' is part of a cycle.";
+			return false;
+		}
+
+		std::vector<float> worlds;
+		ComputeWorldMatrices(flat, &worlds);
+
+		// Children come after their parents, so reducing in reverse order handles every child first.
+		std::vector<NodeBounds> nodeBounds(flat.GetCount());
+		for (size_t i = flat.GetCount(); i-- > 0;) {
+			const float* world = &worlds[i * 16];
+			NodeBounds& bounds = nodeBounds[i];
+
+			std::vector<BoundingSphere> spheres;
+			for (const std::string& meshId : flat.nodes[i]->meshes) {
+				auto mesh = out->meshes.find(meshId);
+				if (mesh == out->meshes.end()) {
+					outErr = "The mesh '" + meshId + "' does not exist.";
+					return false;
+				}
+
+				bounds.box.Include(TransformBoundingBox(world, mesh->second.box));
+
+				BoundingSphere sphere;
+				if (mesh->second.sphere.radius >= 0.0f) {
+					TransformPoint(world, mesh->second.sphere.center, sphere.center);
+					sphere.radius = mesh->second.sphere.radius * GetMaxScale(world);
+				}
+
+				spheres.push_back(sphere);
+			}
+
+			// The direct children are found by skipping over the subtree of each one.
+			for (uint32_t child = static_cast<uint32_t>(i) + 1; child < flat.subtreeEnds[i]; child = flat.subtreeEnds[child]) {
+				bounds.box.Include(nodeBounds[child].box);
+				spheres.push_back(nodeBounds[child].sphere);
+			}
+
+			bounds.sphere = GetBoxSphere(bounds.box);
+			if (!bounds.box.IsEmpty()) {
+				bounds.sphere.radius = 0.0f;
+				for (const BoundingSphere& sphere : spheres) {
+					IncludeSphere(sphere, &bounds.sphere);
+				}
+			}
+		}
+
+		out->nodes.reserve(flat.GetCount());
+		for (size_t i = 0; i < flat.GetCount(); ++i) {
+			out->nodes[flat.ids[i]] = nodeBounds[i];
+		}
+
+		return true;
+	}
+}
\ No newline at end of file
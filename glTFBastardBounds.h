@@ -0,0 +1,148 @@
+/*
+Copyright (c) 2016 Ruben Cashie
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation 
+files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, 
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software 
+is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES 
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE 
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef GLTF_BASTARD_BOUNDS_H
+#define GLTF_BASTARD_BOUNDS_H
+
+#include <algorithm>
+#include <cmath>
+#include "glTFBastardAccessor.h"
+
+namespace glTFBastard {
+
+	// Computes the per-component minimum and maximum of the elements of an accessor.
+	// Values are the raw component values, as in Accessor::min and Accessor::max.
+	bool ComputeAccessorMinMax(const AccessorData& data, std::vector<float>* outMin, std::vector<float>* outMax, std::string& outErr);
+
+	// What UpdateAccessorMinMax does with the values it computes.
+	enum AccessorMinMaxPolicy {
+		// Only reports accessors whose min/max are missing or wrong.
+		ACCESSOR_MIN_MAX_VALIDATE,
+
+		// Fills in missing min/max and reports wrong ones.
+		ACCESSOR_MIN_MAX_FILL_MISSING,
+
+		// Fills in missing min/max and replaces wrong ones.
+		ACCESSOR_MIN_MAX_REPLACE
+	};
+
+	// The accessors UpdateAccessorMinMax found to have missing or wrong min/max.
+	struct AccessorMinMaxReport {
+		std::vector<std::string> missing;
+		std::vector<std::string> mismatched;
+	};
+
+	// Computes the min/max of every accessor in the document and validates or updates Accessor::min and Accessor::max
+	// according to the policy. Parsed values within tolerance (relative to the magnitude of the computed value, or
+	// absolute below a magnitude of one) are considered correct.
+	// Large accessors are split up so that the work spreads across threads even when a few accessors hold most of the data.
+	// The buffers of every accessor must have been loaded.
+	bool UpdateAccessorMinMax(
+		glTF* doc,
+		AccessorMinMaxPolicy policy,
+		float tolerance,
+		AccessorMinMaxReport* outReport,
+		std::string& outErr);
+
+	// An axis aligned bounding box. Empty boxes have min above max.
+	struct BoundingBox {
+		float min[3];
+		float max[3];
+
+		BoundingBox() {
+			for (size_t axis = 0; axis < 3; ++axis) {
+				min[axis] = INFINITY;
+				max[axis] = -INFINITY;
+			}
+		}
+
+		bool IsEmpty() const {
+			return min[0] > max[0];
+		}
+
+		void Include(const BoundingBox& other) {
+			for (size_t axis = 0; axis < 3; ++axis) {
+				min[axis] = std::min(min[axis], other.min[axis]);
+				max[axis] = std::max(max[axis], other.max[axis]);
+			}
+		}
+	};
+
+	// Returns the box around a box transformed by an affine matrix.
+	BoundingBox TransformBoundingBox(const float* matrix, const BoundingBox& box);
+
+	struct BoundingSphere {
+		float center[3];
+		float radius;
+
+		BoundingSphere() :
+			radius(-1.0f) {
+			center[0] = center[1] = center[2] = 0.0f;
+		}
+	};
+
+	struct PrimitiveBounds {
+		BoundingBox box;
+		BoundingSphere sphere;
+	};
+
+	// Bounds in the space of the mesh.
+	struct MeshBounds {
+		BoundingBox box;
+		BoundingSphere sphere;
+		std::vector<PrimitiveBounds> primitives;
+	};
+
+	// World space bounds of a node together with all of its descendants.
+	struct NodeBounds {
+		BoundingBox box;
+		BoundingSphere sphere;
+	};
+
+	struct SceneBounds {
+		std::unordered_map<std::string, MeshBounds> meshes;
+		std::unordered_map<std::string, NodeBounds> nodes;
+	};
+
+	struct BoundsOptions {
+		// Use the min/max of POSITION accessors that have them instead of reading the data. Only set this when
+		// they are known to be right, for example after UpdateAccessorMinMax; spheres are then looser.
+		bool trustAccessorMinMax;
+
+		BoundsOptions() :
+			trustAccessorMinMax(false) {
+		}
+	};
+
+	// Computes the bounding box and sphere of every primitive of the specified meshes, and of each mesh as a whole,
+	// from POSITION data in parallel across primitives. Fails if a mesh is missing.
+	// The buffers of every POSITION accessor that is read must have been loaded.
+	bool ComputeMeshBounds(
+		const glTF& doc,
+		const std::vector<std::string>& meshIds,
+		const BoundsOptions& options,
+		std::unordered_map<std::string, MeshBounds>* out,
+		std::string& outErr);
+
+	// Computes the bounding box and sphere of every primitive and mesh from POSITION data, in parallel across
+	// primitives, then the world space bounds of every node and its descendants by combining node transforms top
+	// down and reducing bounds bottom up. Spheres are centered on their boxes. Nodes without geometry in their
+	// subtree have empty bounds. Fails if a node is missing, has more than one parent or is part of a cycle.
+	// The buffers of every POSITION accessor that is read must have been loaded.
+	bool ComputeSceneBounds(const glTF& doc, const BoundsOptions& options, SceneBounds* out, std::string& outErr);
+}
+
+#endif
\ No newline at end of file
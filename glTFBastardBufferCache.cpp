@@ -0,0 +1,262 @@
+/*
+Copyright (c) 2016 Ruben Cashie
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation 
+files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, 
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software 
+is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES 
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE 
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <sstream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif
+
+#include "glTFBastardBufferCache.h"
+
+namespace glTFBastard {
+
+	static const uint64_t HASH_PRIME_1 = 0x9E3779B185EBCA87ULL;
+	static const uint64_t HASH_PRIME_2 = 0xC2B2AE3D27D4EB4FULL;
+
+	static uint64_t RotateLeft(uint64_t value, int bits) {
+		return (value << bits) | (value >> (64 - bits));
+	}
+
+	static uint64_t HashRound(uint64_t accumulator, uint64_t word) {
+		return RotateLeft(accumulator + word * HASH_PRIME_2, 31) * HASH_PRIME_1;
+	}
+
+	// Returns a 64 bit hash of a block of memory.
+	// Four independent lanes of 8 bytes keep several multiplies in flight.
+	uint64_t HashBufferContents(const unsigned char* data, size_t size) {
+		uint64_t lanes[4] = {HASH_PRIME_1 + HASH_PRIME_2, HASH_PRIME_2, 0, 0 - HASH_PRIME_1};
+		size_t offset = 0;
+
+		for (; offset + 32 <= size; offset += 32) {
+			for (size_t lane = 0; lane < 4; ++lane) {
+				uint64_t word;
+				memcpy(&word, data + offset + lane * 8, sizeof(word));
+				lanes[lane] = HashRound(lanes[lane], word);
+			}
+		}
+
+		uint64_t hash = RotateLeft(lanes[0], 1) + RotateLeft(lanes[1], 7) + RotateLeft(lanes[2], 12) + RotateLeft(lanes[3], 18);
+		hash ^= static_cast<uint64_t>(size) * HASH_PRIME_1;
+
+		for (; offset < size; offset += 8) {
+			uint64_t word = 0;
+			memcpy(&word, data + offset, size - offset < 8 ? size - offset : 8);
+			hash = HashRound(hash, word);
+		}
+
+		// Final avalanche.
+		hash ^= hash >> 33;
+		hash *= HASH_PRIME_2;
+		hash ^= hash >> 29;
+		hash *= HASH_PRIME_1;
+		hash ^= hash >> 32;
+		return hash;
+	}
+
+	// Builds the key of a file from its path, modification time and size so that changed files are read again.
+	static bool GetFileKey(const std::string& path, std::string* out) {
+		std::stringstream ss;
+		ss << path << '|';
+
+#ifdef _WIN32
+		WIN32_FILE_ATTRIBUTE_DATA attributes;
+		if (!GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &attributes)) {
+			return false;
+		}
+
+		ss << attributes.ftLastWriteTime.dwHighDateTime << ':' << attributes.ftLastWriteTime.dwLowDateTime << '|'
+			<< attributes.nFileSizeHigh << ':' << attributes.nFileSizeLow;
+#else
+		struct stat fileStat;
+		if (stat(path.c_str(), &fileStat) != 0) {
+			return false;
+		}
+
+		ss << static_cast<long long>(fileStat.st_mtime) << '|' << static_cast<long long>(fileStat.st_size);
+#endif
+
+		*out = ss.str();
+		return true;
+	}
+
+	BufferCache::BufferCache(size_t byteBudget) :
+		byteBudget(byteBudget) {
+	}
+
+	// Returns a file from the cache, or maps it and adds it.
+	BufferContents BufferCache::ReadFile(const std::string& path) {
+		std::string key;
+		if (!GetFileKey(path, &key)) {
+			return MapBufferFile(path);
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			auto itr = fileIndex.find(key);
+			if (itr != fileIndex.end()) {
+				++statistics.hits;
+				statistics.bytesSaved += itr->second->contents.size;
+				Touch(itr->second);
+				return itr->second->contents;
+			}
+		}
+
+		BufferContents contents = MapBufferFile(path);
+		if (!contents.data) {
+			return contents;
+		}
+
+		uint64_t hash = HashBufferContents(contents.data.get(), contents.size);
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		// Another load may have added the file, or an equal one, while this one was being read.
+		auto itr = fileIndex.find(key);
+		EntryIterator entry = itr != fileIndex.end() ? itr->second : FindContents(contents, hash);
+		if (entry != entries.end()) {
+			++statistics.hits;
+			statistics.bytesSaved += entry->contents.size;
+			Touch(entry);
+		}
+		else {
+			++statistics.misses;
+			entry = Insert(contents, hash);
+			if (entry == entries.end()) {
+				return contents;
+			}
+		}
+
+		if (itr == fileIndex.end()) {
+			entry->fileKeys.push_back(key);
+			fileIndex[key] = entry;
+		}
+
+		return entry->contents;
+	}
+
+	// Returns cached contents equal to the specified ones, or adds them.
+	BufferContents BufferCache::Share(const BufferContents& contents) {
+		if (!contents.data) {
+			return contents;
+		}
+
+		uint64_t hash = HashBufferContents(contents.data.get(), contents.size);
+
+		std::lock_guard<std::mutex> lock(mutex);
+		EntryIterator entry = FindContents(contents, hash);
+		if (entry != entries.end()) {
+			++statistics.hits;
+			statistics.bytesSaved += entry->contents.size;
+			Touch(entry);
+			return entry->contents;
+		}
+
+		++statistics.misses;
+		Insert(contents, hash);
+		return contents;
+	}
+
+	// Changes the budget, evicting entries if needed.
+	void BufferCache::SetByteBudget(size_t budget) {
+		std::lock_guard<std::mutex> lock(mutex);
+		byteBudget = budget;
+		Evict();
+	}
+
+	BufferCacheStatistics BufferCache::GetStatistics() const {
+		std::lock_guard<std::mutex> lock(mutex);
+		return statistics;
+	}
+
+	// Drops every entry.
+	void BufferCache::Clear() {
+		std::lock_guard<std::mutex> lock(mutex);
+		entries.clear();
+		fileIndex.clear();
+		contentIndex.clear();
+		statistics.bytesCached = 0;
+		statistics.entryCount = 0;
+	}
+
+	// Finds an entry with the same bytes; the hash only narrows down the candidates.
+	BufferCache::EntryIterator BufferCache::FindContents(const BufferContents& contents, uint64_t hash) {
+		auto range = contentIndex.equal_range(hash);
+		for (auto itr = range.first; itr != range.second; ++itr) {
+			const BufferContents& candidate = itr->second->contents;
+			if (candidate.size == contents.size
+				&& (candidate.data == contents.data || memcmp(candidate.data.get(), contents.data.get(), contents.size) == 0)) {
+				return itr->second;
+			}
+		}
+
+		return entries.end();
+	}
+
+	// Adds an entry as the most recently used one. Contents larger than the budget are not added.
+	BufferCache::EntryIterator BufferCache::Insert(const BufferContents& contents, uint64_t hash) {
+		if (contents.size > byteBudget) {
+			return entries.end();
+		}
+
+		Entry entry;
+		entry.contents = contents;
+		entry.hash = hash;
+		entries.push_front(entry);
+		contentIndex.insert(std::make_pair(hash, entries.begin()));
+
+		statistics.bytesCached += contents.size;
+		++statistics.entryCount;
+		Evict();
+		return entries.begin();
+	}
+
+	void BufferCache::Touch(EntryIterator entry) {
+		entries.splice(entries.begin(), entries, entry);
+	}
+
+	// Evicts the least recently used entries until the cached bytes are within the budget.
+	void BufferCache::Evict() {
+		while (statistics.bytesCached > byteBudget && !entries.empty()) {
+			EntryIterator entry = std::prev(entries.end());
+			for (const std::string& fileKey : entry->fileKeys) {
+				fileIndex.erase(fileKey);
+			}
+
+			auto range = contentIndex.equal_range(entry->hash);
+			for (auto itr = range.first; itr != range.second; ++itr) {
+				if (itr->second == entry) {
+					contentIndex.erase(itr);
+					break;
+				}
+			}
+
+			statistics.bytesCached -= entry->contents.size;
+			--statistics.entryCount;
+			entries.erase(entry);
+		}
+	}
+
+	// Returns the process-wide buffer cache.
+	std::shared_ptr<BufferCache> GetBufferCache() {
+		static const size_t DEFAULT_BYTE_BUDGET = 256 * 1024 * 1024;
+		static std::shared_ptr<BufferCache> cache(new BufferCache(DEFAULT_BYTE_BUDGET));
+		return cache;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,100 @@
+/*
+Copyright (c) 2016 Ruben Cashie
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation 
+files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, 
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software 
+is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES 
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE 
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef GLTF_BASTARD_BUFFER_CACHE_H
+#define GLTF_BASTARD_BUFFER_CACHE_H
+
+#include <list>
+#include <mutex>
+#include "glTFBastard.h"
+
+namespace glTFBastard {
+
+	// Returns a 64 bit hash of a block of memory; reads eight bytes at a time.
+	uint64_t HashBufferContents(const unsigned char* data, size_t size);
+
+	struct BufferCacheStatistics {
+		// Requests answered from the cache and requests that had to be read or kept as passed in.
+		size_t hits;
+		size_t misses;
+
+		// The bytes of all hits, which documents would otherwise have held a copy of.
+		size_t bytesSaved;
+
+		// The bytes and entries the cache currently holds.
+		size_t bytesCached;
+		size_t entryCount;
+
+		BufferCacheStatistics() :
+			hits(0),
+			misses(0),
+			bytesSaved(0),
+			bytesCached(0),
+			entryCount(0) {
+		}
+	};
+
+	// A buffer source that shares identical buffer contents between documents.
+	// Files are looked up by path, modification time and size, and all contents by a hash of their bytes, so equal
+	// files at different paths and equal embedded buffers are also shared. Entries are reference counted: evicting
+	// one only drops the cache's reference, and documents that use it keep it alive.
+	// The least recently used entries are evicted once the cached bytes exceed the budget. Thread-safe; files are
+	// read and hashed outside of the lock so that loads run concurrently.
+	class BufferCache : public BufferSource {
+	public:
+		explicit BufferCache(size_t byteBudget);
+
+		BufferContents ReadFile(const std::string& path) override;
+		BufferContents Share(const BufferContents& contents) override;
+
+		// Changes the budget, evicting entries if needed.
+		void SetByteBudget(size_t byteBudget);
+
+		BufferCacheStatistics GetStatistics() const;
+
+		// Drops every entry; statistics are kept.
+		void Clear();
+
+	private:
+		struct Entry {
+			BufferContents contents;
+			uint64_t hash;
+			std::vector<std::string> fileKeys;
+		};
+
+		typedef std::list<Entry>::iterator EntryIterator;
+
+		EntryIterator FindContents(const BufferContents& contents, uint64_t hash);
+		EntryIterator Insert(const BufferContents& contents, uint64_t hash);
+		void Touch(EntryIterator entry);
+		void Evict();
+
+		mutable std::mutex mutex;
+		size_t byteBudget;
+		BufferCacheStatistics statistics;
+
+		// Most recently used first.
+		std::list<Entry> entries;
+		std::unordered_map<std::string, EntryIterator> fileIndex;
+		std::unordered_multimap<uint64_t, EntryIterator> contentIndex;
+	};
+
+	// Returns the process-wide buffer cache, which starts with a budget of 256 MB.
+	// Install it with SetBufferSource(GetBufferCache()) to share buffers between all documents that are loaded.
+	std::shared_ptr<BufferCache> GetBufferCache();
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,82 @@
+/*
+Copyright (c) 2016 Ruben Cashie
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation 
+files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, 
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software 
+is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES 
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE 
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "glTFBastardBuilder.h"
+
+namespace glTFBastard {
+
+	// Appends the data of a new buffer view.
+	size_t BufferBuilder::AddView(const void* viewData, size_t size, BufferView::Target target) {
+		View view;
+		view.byteOffset = (data.size() + 3) & ~static_cast<size_t>(3);
+		view.byteLength = size;
+		view.target = target;
+
+		data.resize(view.byteOffset + size);
+		if (size) {
+			memcpy(&data[view.byteOffset], viewData, size);
+		}
+
+		views.push_back(view);
+		return views.size() - 1;
+	}
+
+	// Adds the buffer and its views to the document.
+	std::vector<std::string> BufferBuilder::Commit(glTF* doc, const std::string& idPrefix) {
+		std::shared_ptr<std::vector<unsigned char>> storage(new std::vector<unsigned char>());
+		storage->swap(data);
+
+		// Keep the data pointer non-null even for an empty buffer so that it counts as loaded.
+		storage->reserve(1);
+
+		std::string bufferId = MakeUniqueId(doc->buffers, idPrefix);
+		std::unique_ptr<Buffer> buffer(new Buffer());
+		buffer->byteLength = static_cast<long long>(storage->size());
+		buffer->data = std::shared_ptr<const unsigned char>(storage, storage->data());
+		doc->buffers[bufferId] = std::move(buffer);
+
+		std::vector<std::string> viewIds;
+		viewIds.reserve(views.size());
+		for (size_t i = 0; i < views.size(); ++i) {
+			std::stringstream ss;
+			ss << bufferId << "_view_" << i;
+
+			std::string viewId = MakeUniqueId(doc->bufferViews, ss.str());
+			std::unique_ptr<BufferView> bufferView(new BufferView());
+			bufferView->buffer = bufferId;
+			bufferView->byteOffset = static_cast<long long>(views[i].byteOffset);
+			bufferView->byteLength = static_cast<long long>(views[i].byteLength);
+			bufferView->target = views[i].target;
+			doc->bufferViews[viewId] = std::move(bufferView);
+			viewIds.push_back(viewId);
+		}
+
+		views.clear();
+		return viewIds;
+	}
+
+	// Adds a copy of an accessor that refers to a tightly packed buffer view.
+	std::string AddAccessor(glTF* doc, const std::string& idPrefix, const Accessor& source, const std::string& bufferView, long long count) {
+		std::string accessorId = MakeUniqueId(doc->accessors, idPrefix);
+		std::unique_ptr<Accessor> accessor(new Accessor(source));
+		accessor->bufferView = bufferView;
+		accessor->byteOffset = 0;
+		accessor->byteStride = 0;
+		accessor->count = count;
+		doc->accessors[accessorId] = std::move(accessor);
+		return accessorId;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+/*
+Copyright (c) 2016 Ruben Cashie
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation 
+files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, 
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software 
+is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES 
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE 
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef GLTF_BASTARD_BUILDER_H
+#define GLTF_BASTARD_BUILDER_H
+
+#include <sstream>
+#include "glTFBastard.h"
+
+namespace glTFBastard {
+
+	// Returns an id that starts with the prefix and is not used by any element of the map.
+	template<typename T> std::string MakeUniqueId(const std::unordered_map<std::string, T>& map, const std::string& prefix) {
+		if (map.find(prefix) == map.end()) {
+			return prefix;
+		}
+
+		for (size_t suffix = 1;; ++suffix) {
+			std::stringstream ss;
+			ss << prefix << "_" << suffix;
+			if (map.find(ss.str()) == map.end()) {
+				return ss.str();
+			}
+		}
+	}
+
+	// Accumulates the data of several buffer views and adds them to a document as a single new buffer.
+	// The new buffer lives in memory only and has no uri.
+	class BufferBuilder {
+	public:
+		// Appends the data of a new buffer view, aligned to four bytes. Returns the index of the view.
+		size_t AddView(const void* data, size_t size, BufferView::Target target);
+
+		// Returns the number of views added so far.
+		size_t GetViewCount() const {
+			return views.size();
+		}
+
+		// Adds the buffer and its views to the document. Returns the ids of the new views in the order they were added.
+		std::vector<std::string> Commit(glTF* doc, const std::string& idPrefix);
+
+	private:
+		struct View {
+			size_t byteOffset;
+			size_t byteLength;
+			BufferView::Target target;
+		};
+
+		std::vector<unsigned char> data;
+		std::vector<View> views;
+	};
+
+	// Adds a copy of an accessor that refers to a tightly packed buffer view; returns the id of the new accessor.
+	std::string AddAccessor(glTF* doc, const std::string& idPrefix, const Accessor& source, const std::string& bufferView, long long count);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,465 @@
+/*
+Copyright (c) 2016 Ruben Cashie
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation 
+files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, 
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software 
+is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES 
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE 
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "glTFBastardConvert.h"
+#include "glTFBastardSimd.h"
+
+namespace glTFBastard {
+
+	// The conversion parameters for a component type.
+	// Integers are multiplied by toFloatScale on the way to floats and clamped to [minValue, maxValue]
+	// after being multiplied by fromFloatScale on the way back.
+	struct ComponentConversion {
+		float toFloatScale;
+		float fromFloatScale;
+		float minValue;
+		float maxValue;
+		bool clampToMinusOne;
+	};
+
+	// Gets the conversion parameters for a component type.
+	template<typename T> static ComponentConversion GetComponentConversion(bool normalized) {
+		ComponentConversion result;
+		if (ComponentTraits<T>::componentType == Accessor::COMPONENT_TYPE_FLOAT) {
+			result.toFloatScale = 1.0f;
+			result.fromFloatScale = 1.0f;
+			result.minValue = -INFINITY;
+			result.maxValue = INFINITY;
+			result.clampToMinusOne = false;
+			return result;
+		}
+
+		float lowest = static_cast<float>(std::numeric_limits<T>::min());
+		float highest = static_cast<float>(std::numeric_limits<T>::max());
+		bool isSigned = lowest < 0.0f;
+
+		// Signed normalized values use the symmetric mapping where both the lowest and the
+		// next lowest integers map to -1.
+		result.toFloatScale = normalized ? 1.0f / highest : 1.0f;
+		result.fromFloatScale = normalized ? highest : 1.0f;
+		result.minValue = normalized && isSigned ? -highest : lowest;
+		result.maxValue = highest;
+		result.clampToMinusOne = normalized && isSigned;
+		return result;
+	}
+
+	// Reads a single component.
+	template<typename T> static inline T LoadComponent(const unsigned char* source) {
+		T value;
+		memcpy(&value, source, sizeof(T));
+		return value;
+	}
+
+	// Converts a range of elements to SoA one element at a time.
+	template<typename T> static void ToSoAScalar(
+		const AccessorData& data,
+		size_t componentCount,
+		const ComponentConversion& conversion,
+		size_t begin,
+		float* const* outComponents) {
+
+		for (size_t i = begin; i < data.count; ++i) {
+			const unsigned char* element = data.data + i * data.byteStride;
+			for (size_t c = 0; c < componentCount; ++c) {
+				float value = static_cast<float>(LoadComponent<T>(element + c * sizeof(T))) * conversion.toFloatScale;
+				outComponents[c][i] = conversion.clampToMinusOne ? std::max(value, -1.0f) : value;
+			}
+		}
+	}
+
+	// Converts a range of SoA elements to interleaved elements one element at a time.
+	template<typename T> static void FromSoAScalar(
+		const float* const* components,
+		size_t count,
+		size_t componentCount,
+		const ComponentConversion& conversion,
+		size_t begin,
+		unsigned char* outData,
+		size_t byteStride) {
+
+		bool isFloat = ComponentTraits<T>::componentType == Accessor::COMPONENT_TYPE_FLOAT;
+		for (size_t i = begin; i < count; ++i) {
+			unsigned char* element = outData + i * byteStride;
+			for (size_t c = 0; c < componentCount; ++c) {
+				float value = components[c][i];
+				if (!isFloat) {
+					value = std::nearbyint(value * conversion.fromFloatScale);
+					value = std::min(std::max(value, conversion.minValue), conversion.maxValue);
+				}
+
+				T result = static_cast<T>(value);
+				memcpy(element + c * sizeof(T), &result, sizeof(T));
+			}
+		}
+	}
+
+	// Returns the number of leading elements whose components can all be read with 32 bit loads
+	// without reading past the last byte of the accessor.
+	static size_t GetWideLoadSafeCount(const AccessorData& data, size_t componentCount, size_t componentSize) {
+		if (!data.count) {
+			return 0;
+		}
+
+		size_t totalBytes = (data.count - 1) * data.byteStride + componentCount * componentSize;
+		size_t lastComponentEnd = (componentCount - 1) * componentSize + 4;
+		if (lastComponentEnd > totalBytes) {
+			return 0;
+		}
+
+		return (totalBytes - lastComponentEnd) / data.byteStride + 1;
+	}
+
+#if defined(GLTF_BASTARD_AVX2)
+	static const size_t VECTOR_WIDTH = 8;
+
+	// Extracts the components in the low bits of each 32 bit lane and converts them to floats.
+	template<typename T> static inline __m256 WidenToFloat(__m256i raw);
+
+	template<> inline __m256 WidenToFloat<int8_t>(__m256i raw) {
+		return _mm256_cvtepi32_ps(_mm256_srai_epi32(_mm256_slli_epi32(raw, 24), 24));
+	}
+
+	template<> inline __m256 WidenToFloat<uint8_t>(__m256i raw) {
+		return _mm256_cvtepi32_ps(_mm256_and_si256(raw, _mm256_set1_epi32(0xFF)));
+	}
+
+	template<> inline __m256 WidenToFloat<int16_t>(__m256i raw) {
+		return _mm256_cvtepi32_ps(_mm256_srai_epi32(_mm256_slli_epi32(raw, 16), 16));
+	}
+
+	template<> inline __m256 WidenToFloat<uint16_t>(__m256i raw) {
+		return _mm256_cvtepi32_ps(_mm256_and_si256(raw, _mm256_set1_epi32(0xFFFF)));
+	}
+
+	template<> inline __m256 WidenToFloat<float>(__m256i raw) {
+		return _mm256_castsi256_ps(raw);
+	}
+
+	// Converts as many elements as possible eight at a time by gathering each component
+	// across elements. Returns the number of elements converted.
+	template<typename T> static size_t ToSoAVector(
+		const AccessorData& data,
+		size_t componentCount,
+		const ComponentConversion& conversion,
+		float* const* outComponents) {
+
+		size_t safeCount = GetWideLoadSafeCount(data, componentCount, sizeof(T));
+		if (safeCount < VECTOR_WIDTH) {
+			return 0;
+		}
+
+		int stride = static_cast<int>(data.byteStride);
+		__m256i offsets = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(stride));
+		__m256 scale = _mm256_set1_ps(conversion.toFloatScale);
+		__m256 minusOne = _mm256_set1_ps(-1.0f);
+
+		size_t i = 0;
+		for (; i + VECTOR_WIDTH <= safeCount; i += VECTOR_WIDTH) {
+			const unsigned char* element = data.data + i * data.byteStride;
+			for (size_t c = 0; c < componentCount; ++c) {
+				__m256i raw = _mm256_i32gather_epi32(reinterpret_cast<const int*>(element + c * sizeof(T)), offsets, 1);
+				__m256 value = _mm256_mul_ps(WidenToFloat<T>(raw), scale);
+				if (conversion.clampToMinusOne) {
+					value = _mm256_max_ps(value, minusOne);
+				}
+
+				_mm256_storeu_ps(outComponents[c] + i, value);
+			}
+		}
+
+		return i;
+	}
+
+	// Rounds and clamps eight values of a component to its integer range.
+	static inline __m256i NarrowToInt(__m256 value, const ComponentConversion& conversion) {
+		value = _mm256_mul_ps(value, _mm256_set1_ps(conversion.fromFloatScale));
+		value = _mm256_max_ps(value, _mm256_set1_ps(conversion.minValue));
+		value = _mm256_min_ps(value, _mm256_set1_ps(conversion.maxValue));
+		return _mm256_cvtps_epi32(value);
+	}
+#elif defined(GLTF_BASTARD_SSE2)
+	static const size_t VECTOR_WIDTH = 4;
+
+	// Extracts the components in the low bits of each 32 bit lane and converts them to floats.
+	template<typename T> static inline __m128 WidenToFloat(__m128i raw);
+
+	template<> inline __m128 WidenToFloat<int8_t>(__m128i raw) {
+		return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_slli_epi32(raw, 24), 24));
+	}
+
+	template<> inline __m128 WidenToFloat<uint8_t>(__m128i raw) {
+		return _mm_cvtepi32_ps(_mm_and_si128(raw, _mm_set1_epi32(0xFF)));
+	}
+
+	template<> inline __m128 WidenToFloat<int16_t>(__m128i raw) {
+		return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_slli_epi32(raw, 16), 16));
+	}
+
+	template<> inline __m128 WidenToFloat<uint16_t>(__m128i raw) {
+		return _mm_cvtepi32_ps(_mm_and_si128(raw, _mm_set1_epi32(0xFFFF)));
+	}
+
+	template<> inline __m128 WidenToFloat<float>(__m128i raw) {
+		return _mm_castsi128_ps(raw);
+	}
+
+	// Converts as many elements as possible four at a time by loading each component
+	// across elements. Returns the number of elements converted.
+	template<typename T> static size_t ToSoAVector(
+		const AccessorData& data,
+		size_t componentCount,
+		const ComponentConversion& conversion,
+		float* const* outComponents) {
+
+		size_t safeCount = GetWideLoadSafeCount(data, componentCount, sizeof(T));
+		if (safeCount < VECTOR_WIDTH) {
+			return 0;
+		}
+
+		size_t stride = data.byteStride;
+		__m128 scale = _mm_set1_ps(conversion.toFloatScale);
+		__m128 minusOne = _mm_set1_ps(-1.0f);
+
+		size_t i = 0;
+		for (; i + VECTOR_WIDTH <= safeCount; i += VECTOR_WIDTH) {
+			const unsigned char* element = data.data + i * stride;
+			for (size_t c = 0; c < componentCount; ++c) {
+				const unsigned char* component = element + c * sizeof(T);
+				__m128i raw = _mm_setr_epi32(
+					LoadComponent<int>(component),
+					LoadComponent<int>(component + stride),
+					LoadComponent<int>(component + stride * 2),
+					LoadComponent<int>(component + stride * 3));
+
+				__m128 value = _mm_mul_ps(WidenToFloat<T>(raw), scale);
+				if (conversion.clampToMinusOne) {
+					value = _mm_max_ps(value, minusOne);
+				}
+
+				_mm_storeu_ps(outComponents[c] + i, value);
+			}
+		}
+
+		return i;
+	}
+
+	// Rounds and clamps four values of a component to its integer range.
+	static inline __m128i NarrowToInt(__m128 value, const ComponentConversion& conversion) {
+		value = _mm_mul_ps(value, _mm_set1_ps(conversion.fromFloatScale));
+		value = _mm_max_ps(value, _mm_set1_ps(conversion.minValue));
+		value = _mm_min_ps(value, _mm_set1_ps(conversion.maxValue));
+		return _mm_cvtps_epi32(value);
+	}
+#endif
+
+#if defined(GLTF_BASTARD_AVX2) || defined(GLTF_BASTARD_SSE2)
+	// Converts as many SoA elements as possible a vector at a time. The rounding and clamping is vectorized,
+	// the narrowed values are then stored to the interleaved elements. Returns the number of elements converted.
+	template<typename T> static size_t FromSoAVector(
+		const float* const* components,
+		size_t count,
+		size_t componentCount,
+		const ComponentConversion& conversion,
+		unsigned char* outData,
+		size_t byteStride) {
+
+		bool isFloat = ComponentTraits<T>::componentType == Accessor::COMPONENT_TYPE_FLOAT;
+		int32_t lanes[VECTOR_WIDTH];
+
+		size_t i = 0;
+		for (; i + VECTOR_WIDTH <= count; i += VECTOR_WIDTH) {
+			unsigned char* element = outData + i * byteStride;
+			for (size_t c = 0; c < componentCount; ++c) {
+				unsigned char* component = element + c * sizeof(T);
+				if (isFloat) {
+					for (size_t lane = 0; lane < VECTOR_WIDTH; ++lane) {
+						memcpy(component + lane * byteStride, &components[c][i + lane], sizeof(float));
+					}
+
+					continue;
+				}
+
+#if defined(GLTF_BASTARD_AVX2)
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), NarrowToInt(_mm256_loadu_ps(components[c] + i), conversion));
+#else
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), NarrowToInt(_mm_loadu_ps(components[c] + i), conversion));
+#endif
+				for (size_t lane = 0; lane < VECTOR_WIDTH; ++lane) {
+					T value = static_cast<T>(lanes[lane]);
+					memcpy(component + lane * byteStride, &value, sizeof(T));
+				}
+			}
+		}
+
+		return i;
+	}
+#else
+	// No vector kernels are available; everything goes through the scalar path.
+	template<typename T> static size_t ToSoAVector(const AccessorData&, size_t, const ComponentConversion&, float* const*) {
+		return 0;
+	}
+
+	template<typename T> static size_t FromSoAVector(
+		const float* const*, size_t, size_t, const ComponentConversion&, unsigned char*, size_t) {
+		return 0;
+	}
+#endif
+
+	// Converts an accessor of a known component type to SoA.
+	template<typename T> static void ToSoA(const AccessorData& data, bool normalized, bool vectorize, float* const* outComponents) {
+		size_t componentCount = GetComponentCount(data.type);
+		ComponentConversion conversion = GetComponentConversion<T>(normalized);
+
+		size_t converted = vectorize ? ToSoAVector<T>(data, componentCount, conversion, outComponents) : 0;
+		ToSoAScalar<T>(data, componentCount, conversion, converted, outComponents);
+	}
+
+	// Converts SoA to interleaved elements of a known component type.
+	template<typename T> static void FromSoA(
+		const float* const* components,
+		size_t count,
+		size_t componentCount,
+		bool normalized,
+		bool vectorize,
+		unsigned char* outData,
+		size_t byteStride) {
+
+		ComponentConversion conversion = GetComponentConversion<T>(normalized);
+		size_t converted = vectorize
+			? FromSoAVector<T>(components, count, componentCount, conversion, outData, byteStride)
+			: 0;
+
+		FromSoAScalar<T>(components, count, componentCount, conversion, converted, outData, byteStride);
+	}
+
+	// Dispatches the conversion to SoA on the component type of the accessor.
+	static bool DispatchToSoA(const AccessorData& data, bool normalized, bool vectorize, float* const* outComponents, std::string& outErr) {
+		if (!GetComponentCount(data.type)) {
+			outErr = "Could not convert accessor data. Unsupported type.";
+			return false;
+		}
+
+		AccessorData packed = data;
+		if (!packed.byteStride) {
+			packed.byteStride = GetComponentCount(data.type) * GetComponentSize(data.componentType);
+		}
+
+		switch (data.componentType) {
+			case Accessor::COMPONENT_TYPE_BYTE: ToSoA<int8_t>(packed, normalized, vectorize, outComponents); return true;
+			case Accessor::COMPONENT_TYPE_UNSIGNED_BYTE: ToSoA<uint8_t>(packed, normalized, vectorize, outComponents); return true;
+			case Accessor::COMPONENT_TYPE_SHORT: ToSoA<int16_t>(packed, normalized, vectorize, outComponents); return true;
+			case Accessor::COMPONENT_TYPE_UNSIGNED_SHORT: ToSoA<uint16_t>(packed, normalized, vectorize, outComponents); return true;
+			case Accessor::COMPONENT_TYPE_FLOAT: ToSoA<float>(packed, normalized, vectorize, outComponents); return true;
+			case Accessor::COMPONENT_TYPE_UNSIGNED_INT: break;
+		}
+
+		outErr = "Could not convert accessor data. Unsupported component type.";
+		return false;
+	}
+
+	// Dispatches the conversion from SoA on the destination component type.
+	static bool DispatchFromSoA(
+		const float* const* components,
+		size_t count,
+		bool normalized,
+		bool vectorize,
+		Accessor::ComponentType componentType,
+		Accessor::Type type,
+		unsigned char* outData,
+		size_t byteStride,
+		std::string& outErr) {
+
+		size_t componentCount = GetComponentCount(type);
+		if (!componentCount) {
+			outErr = "Could not convert to accessor data. Unsupported type.";
+			return false;
+		}
+
+		size_t elementSize = componentCount * GetComponentSize(componentType);
+		if (!byteStride) {
+			byteStride = elementSize;
+		}
+
+		if (byteStride < elementSize) {
+			outErr = "Could not convert to accessor data. The byteStride is smaller than the element size.";
+			return false;
+		}
+
+		switch (componentType) {
+			case Accessor::COMPONENT_TYPE_BYTE:
+				FromSoA<int8_t>(components, count, componentCount, normalized, vectorize, outData, byteStride);
+				return true;
+			case Accessor::COMPONENT_TYPE_UNSIGNED_BYTE:
+				FromSoA<uint8_t>(components, count, componentCount, normalized, vectorize, outData, byteStride);
+				return true;
+			case Accessor::COMPONENT_TYPE_SHORT:
+				FromSoA<int16_t>(components, count, componentCount, normalized, vectorize, outData, byteStride);
+				return true;
+			case Accessor::COMPONENT_TYPE_UNSIGNED_SHORT:
+				FromSoA<uint16_t>(components, count, componentCount, normalized, vectorize, outData, byteStride);
+				return true;
+			case Accessor::COMPONENT_TYPE_FLOAT:
+				FromSoA<float>(components, count, componentCount, normalized, vectorize, outData, byteStride);
+				return true;
+			case Accessor::COMPONENT_TYPE_UNSIGNED_INT:
+				break;
+		}
+
+		outErr = "Could not convert to accessor data. Unsupported component type.";
+		return false;
+	}
+
+	// Converts the elements of an accessor into separate float arrays using the vector kernels.
+	bool ConvertAccessorToSoA(const AccessorData& data, bool normalized, float* const* outComponents, std::string& outErr) {
+		return DispatchToSoA(data, normalized, true, outComponents, outErr);
+	}
+
+	// Converts separate float arrays into interleaved accessor elements using the vector kernels.
+	bool ConvertSoAToAccessor(
+		const float* const* components,
+		size_t count,
+		bool normalized,
+		Accessor::ComponentType componentType,
+		Accessor::Type type,
+		unsigned char* outData,
+		size_t byteStride,
+		std::string& outErr) {
+
+		return DispatchFromSoA(components, count, normalized, true, componentType, type, outData, byteStride, outErr);
+	}
+
+	// Converts the elements of an accessor into separate float arrays one element at a time.
+	bool ConvertAccessorToSoAReference(const AccessorData& data, bool normalized, float* const* outComponents, std::string& outErr) {
+		return DispatchToSoA(data, normalized, false, outComponents, outErr);
+	}
+
+	// Converts separate float arrays into interleaved accessor elements one element at a time.
+	bool ConvertSoAToAccessorReference(
+		const float* const* components,
+		size_t count,
+		bool normalized,
+		Accessor::ComponentType componentType,
+		Accessor::Type type,
+		unsigned char* outData,
+		size_t byteStride,
+		std::string& outErr) {
+
+		return DispatchFromSoA(components, count, normalized, false, componentType, type, outData, byteStride, outErr);
+	}
+}
\ No newline at end of file
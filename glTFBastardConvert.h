@@ -0,0 +1,60 @@
+/*
+Copyright (c) 2016 Ruben Cashie
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation 
+files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, 
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software 
+is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES 
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE 
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef GLTF_BASTARD_CONVERT_H
+#define GLTF_BASTARD_CONVERT_H
+
+#include "glTFBastardAccessor.h"
+
+namespace glTFBastard {
+
+	// Converts the elements of an accessor into separate float arrays, one per component (structure of arrays).
+	// outComponents must hold GetComponentCount(data.type) arrays with room for data.count floats each.
+	// When normalized is true integer components are mapped to [0, 1] (unsigned) or [-1, 1] (signed);
+	// otherwise they are converted as is.
+	// Uses AVX2 or SSE2 kernels when the library is compiled with support for them.
+	bool ConvertAccessorToSoA(const AccessorData& data, bool normalized, float* const* outComponents, std::string& outErr);
+
+	// Converts separate float arrays, one per component, into interleaved accessor elements.
+	// outData must have room for count elements of the specified componentType and type, byteStride apart;
+	// a byteStride of zero means the elements are tightly packed.
+	// Values are rounded to the nearest integer and clamped to the range of integer component types.
+	bool ConvertSoAToAccessor(
+		const float* const* components,
+		size_t count,
+		bool normalized,
+		Accessor::ComponentType componentType,
+		Accessor::Type type,
+		unsigned char* outData,
+		size_t byteStride,
+		std::string& outErr);
+
+	// Scalar implementations of the conversions above. They produce the same results as the
+	// vectorized kernels and exist to validate them.
+	bool ConvertAccessorToSoAReference(const AccessorData& data, bool normalized, float* const* outComponents, std::string& outErr);
+
+	bool ConvertSoAToAccessorReference(
+		const float* const* components,
+		size_t count,
+		bool normalized,
+		Accessor::ComponentType componentType,
+		Accessor::Type type,
+		unsigned char* outData,
+		size_t byteStride,
+		std::string& outErr);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,106 @@
+/*
+Copyright (c) 2016 Ruben Cashie
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation 
+files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, 
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software 
+is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES 
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE 
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <algorithm>
+#include <map>
+#include <tuple>
+#include "glTFBastardInstancing.h"
+#include "glTFBastardTransform.h"
+
+namespace glTFBastard {
+
+	bool BuildInstanceBatches(const glTF& doc, const std::string& sceneId, std::vector<InstanceBatch>* out, std::string& outErr) {
+		out->clear();
+
+		FlatScene scene;
+		if (!FlattenScene(doc, sceneId, &scene, outErr)) {
+			return false;
+		}
+
+		SceneTransforms transforms;
+		transforms.Build(scene);
+		transforms.Update();
+
+		// The primitives of each mesh, grouped by material in order of first use.
+		typedef std::vector<std::pair<std::string, std::vector<uint32_t>>> MaterialGroups;
+		std::unordered_map<std::string, MaterialGroups> meshGroups;
+
+		// Batches are keyed by their mesh, material and skin ids.
+		std::map<std::tuple<std::string, std::string, std::string>, size_t> batchIndices;
+
+		for (uint32_t n = 0; n < scene.GetCount(); ++n) {
+			const Node& node = *scene.nodes[n];
+			for (const std::string& meshId : node.meshes) {
+				auto groups = meshGroups.find(meshId);
+				if (groups == meshGroups.end()) {
+					auto mesh = doc.meshes.find(meshId);
+					if (mesh == doc.meshes.end()) {
+						outErr = "The mesh '" + meshId + "' does not exist.";
+						return false;
+					}
+
+					MaterialGroups newGroups;
+					const std::vector<std::unique_ptr<Mesh::Primitive>>& primitives = mesh->second->primitives;
+					for (uint32_t p = 0; p < primitives.size(); ++p) {
+						auto group = std::find_if(newGroups.begin(), newGroups.end(), [&](const MaterialGroups::value_type& g) {
+							return g.first == primitives[p]->material;
+						});
+
+						if (group == newGroups.end()) {
+							newGroups.push_back(std::make_pair(primitives[p]->material, std::vector<uint32_t>()));
+							group = newGroups.end() - 1;
+						}
+
+						group->second.push_back(p);
+					}
+
+					groups = meshGroups.insert(std::make_pair(meshId, std::move(newGroups))).first;
+				}
+
+				const float* world = transforms.GetWorldMatrix(n);
+				for (auto& group : groups->second) {
+					auto inserted = batchIndices.insert(std::make_pair(std::make_tuple(meshId, group.first, node.skin), out->size()));
+					if (inserted.second) {
+						InstanceBatch batch;
+						batch.mesh = meshId;
+						batch.material = group.first;
+						batch.skin = node.skin;
+						batch.primitives = group.second;
+						out->push_back(std::move(batch));
+					}
+
+					InstanceBatch& batch = (*out)[inserted.first->second];
+					batch.nodes.push_back(scene.ids[n]);
+					batch.worldMatrices.insert(batch.worldMatrices.end(), world, world + 16);
+				}
+			}
+		}
+
+		std::sort(out->begin(), out->end(), [](const InstanceBatch& a, const InstanceBatch& b) {
+			if (a.mesh != b.mesh) {
+				return a.mesh < b.mesh;
+			}
+
+			if (a.material != b.material) {
+				return a.material < b.material;
+			}
+
+			return a.skin < b.skin;
+		});
+
+		return true;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,51 @@
+/*
+Copyright (c) 2016 Ruben Cashie
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation 
+files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, 
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software 
+is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES 
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE 
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef GLTF_BASTARD_INSTANCING_H
+#define GLTF_BASTARD_INSTANCING_H
+
+#include "glTFBastard.h"
+
+namespace glTFBastard {
+
+	// The primitives of a mesh that share a material, and every node of a scene that places them with a given skin.
+	struct InstanceBatch {
+		std::string mesh;
+		std::string material;
+
+		// Empty for nodes without a skin.
+		std::string skin;
+
+		// Indices into Mesh::primitives.
+		std::vector<uint32_t> primitives;
+
+		// The instances, in hierarchy order, and their world matrices packed one after another as 16 floats each,
+		// column major.
+		std::vector<std::string> nodes;
+		std::vector<float> worldMatrices;
+
+		size_t GetInstanceCount() const {
+			return nodes.size();
+		}
+	};
+
+	// Groups the mesh instances of a scene by mesh, material and skin, so that each unique mesh is processed once
+	// with all of its instance transforms at hand instead of once per node. Batches are sorted by mesh, material
+	// and skin id.
+	bool BuildInstanceBatches(const glTF& doc, const std::string& sceneId, std::vector<InstanceBatch>* out, std::string& outErr);
+}
+
+#endif
\ No newline at end of file
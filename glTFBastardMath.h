@@ -0,0 +1,161 @@
+/*
+Copyright (c) 2016 Ruben Cashie
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation 
+files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, 
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software 
+is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES 
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE 
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef GLTF_BASTARD_MATH_H
+#define GLTF_BASTARD_MATH_H
+
+#include <algorithm>
+#include <cmath>
+#include "glTFBastard.h"
+
+namespace glTFBastard {
+
+	// Matrices are 4x4 and column major, as in glTF. Quaternions are x, y, z, w.
+
+	inline void SetIdentity(float* out) {
+		for (size_t i = 0; i < 16; ++i) {
+			out[i] = i % 5 == 0 ? 1.0f : 0.0f;
+		}
+	}
+
+	// out = a * b; out may not alias a or b.
+	inline void MultiplyMatrices(const float* a, const float* b, float* out) {
+		for (size_t column = 0; column < 4; ++column) {
+			for (size_t row = 0; row < 4; ++row) {
+				out[column * 4 + row] = a[row] * b[column * 4]
+					+ a[4 + row] * b[column * 4 + 1]
+					+ a[8 + row] * b[column * 4 + 2]
+					+ a[12 + row] * b[column * 4 + 3];
+			}
+		}
+	}
+
+	// Builds translation * rotation * scale.
+	inline void ComposeMatrix(const float* translation, const float* rotation, const float* scale, float* out) {
+		float x = rotation[0];
+		float y = rotation[1];
+		float z = rotation[2];
+		float w = rotation[3];
+
+		out[0] = (1.0f - 2.0f * (y * y + z * z)) * scale[0];
+		out[1] = (2.0f * (x * y + z * w)) * scale[0];
+		out[2] = (2.0f * (x * z - y * w)) * scale[0];
+		out[3] = 0.0f;
+
+		out[4] = (2.0f * (x * y - z * w)) * scale[1];
+		out[5] = (1.0f - 2.0f * (x * x + z * z)) * scale[1];
+		out[6] = (2.0f * (y * z + x * w)) * scale[1];
+		out[7] = 0.0f;
+
+		out[8] = (2.0f * (x * z + y * w)) * scale[2];
+		out[9] = (2.0f * (y * z - x * w)) * scale[2];
+		out[10] = (1.0f - 2.0f * (x * x + y * y)) * scale[2];
+		out[11] = 0.0f;
+
+		out[12] = translation[0];
+		out[13] = translation[1];
+		out[14] = translation[2];
+		out[15] = 1.0f;
+	}
+
+	// Splits an affine matrix without shear into translation, rotation and scale. Mirroring is folded into a
+	// negative x scale.
+	inline void DecomposeMatrix(const float* matrix, float* outTranslation, float* outRotation, float* outScale) {
+		for (size_t axis = 0; axis < 3; ++axis) {
+			const float* column = &matrix[axis * 4];
+			outTranslation[axis] = matrix[12 + axis];
+			outScale[axis] = std::sqrt(column[0] * column[0] + column[1] * column[1] + column[2] * column[2]);
+		}
+
+		float determinant = matrix[0] * (matrix[5] * matrix[10] - matrix[6] * matrix[9])
+			- matrix[4] * (matrix[1] * matrix[10] - matrix[2] * matrix[9])
+			+ matrix[8] * (matrix[1] * matrix[6] - matrix[2] * matrix[5]);
+
+		if (determinant < 0.0f) {
+			outScale[0] = -outScale[0];
+		}
+
+		float r[9];
+		for (size_t column = 0; column < 3; ++column) {
+			float inverseScale = outScale[column] != 0.0f ? 1.0f / outScale[column] : 0.0f;
+			for (size_t row = 0; row < 3; ++row) {
+				r[column * 3 + row] = matrix[column * 4 + row] * inverseScale;
+			}
+		}
+
+		// Picks the largest of the four quaternion components to divide by, for precision.
+		float trace = r[0] + r[4] + r[8];
+		if (trace > 0.0f) {
+			float s = std::sqrt(trace + 1.0f) * 2.0f;
+			outRotation[0] = (r[5] - r[7]) / s;
+			outRotation[1] = (r[6] - r[2]) / s;
+			outRotation[2] = (r[1] - r[3]) / s;
+			outRotation[3] = 0.25f * s;
+		}
+		else if (r[0] > r[4] && r[0] > r[8]) {
+			float s = std::sqrt(1.0f + r[0] - r[4] - r[8]) * 2.0f;
+			outRotation[0] = 0.25f * s;
+			outRotation[1] = (r[3] + r[1]) / s;
+			outRotation[2] = (r[6] + r[2]) / s;
+			outRotation[3] = (r[5] - r[7]) / s;
+		}
+		else if (r[4] > r[8]) {
+			float s = std::sqrt(1.0f + r[4] - r[0] - r[8]) * 2.0f;
+			outRotation[0] = (r[3] + r[1]) / s;
+			outRotation[1] = 0.25f * s;
+			outRotation[2] = (r[7] + r[5]) / s;
+			outRotation[3] = (r[6] - r[2]) / s;
+		}
+		else {
+			float s = std::sqrt(1.0f + r[8] - r[0] - r[4]) * 2.0f;
+			outRotation[0] = (r[6] + r[2]) / s;
+			outRotation[1] = (r[7] + r[5]) / s;
+			outRotation[2] = 0.25f * s;
+			outRotation[3] = (r[1] - r[3]) / s;
+		}
+	}
+
+	// Gets the local transform of a node as a matrix.
+	inline void GetNodeMatrix(const Node& node, float* out) {
+		if (node.transformType == Node::TRANSFORM_TYPE_MATRIX) {
+			memcpy(out, node.transform.matrix, sizeof(node.transform.matrix));
+		}
+		else {
+			const Node::Composite& composite = node.transform.composite;
+			ComposeMatrix(composite.translation, composite.rotation, composite.scale, out);
+		}
+	}
+
+	// Transforms a point by an affine matrix.
+	inline void TransformPoint(const float* matrix, const float* point, float* out) {
+		for (size_t row = 0; row < 3; ++row) {
+			out[row] = matrix[row] * point[0] + matrix[4 + row] * point[1] + matrix[8 + row] * point[2] + matrix[12 + row];
+		}
+	}
+
+	// Returns the largest factor by which an affine matrix scales a length.
+	inline float GetMaxScale(const float* matrix) {
+		float largest = 0.0f;
+		for (size_t column = 0; column < 3; ++column) {
+			const float* axis = &matrix[column * 4];
+			largest = std::max(largest, axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+		}
+
+		return std::sqrt(largest);
+	}
+}
+
+#endif
\ No newline at end of file
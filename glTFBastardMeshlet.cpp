@@ -0,0 +1,334 @@
+/*
+Copyright (c) 2016 Ruben Cashie
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation 
+files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, 
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software 
+is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES 
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE 
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include "glTFBastardConvert.h"
+#include "glTFBastardMeshlet.h"
+#include "glTFBastardParallel.h"
+#include "glTFBastardTopology.h"
+
+namespace glTFBastard {
+
+	static const uint32_t NO_LOCAL_INDEX = 0xFFFFFFFF;
+
+	static float Dot(const float* a, const float* b) {
+		return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+	}
+
+	// Computes an approximate bounding sphere of points with Ritter's algorithm.
+	static void ComputeBoundingSphere(const std::vector<float>& points, float* outCenter, float* outRadius) {
+		size_t count = points.size() / 3;
+
+		// Start with the pair of axis extremes that are furthest apart.
+		size_t extremes[6] = {0, 0, 0, 0, 0, 0};
+		for (size_t p = 1; p < count; ++p) {
+			for (size_t axis = 0; axis < 3; ++axis) {
+				if (points[p * 3 + axis] < points[extremes[axis] * 3 + axis]) {
+					extremes[axis] = p;
+				}
+
+				if (points[p * 3 + axis] > points[extremes[axis + 3] * 3 + axis]) {
+					extremes[axis + 3] = p;
+				}
+			}
+		}
+
+		size_t bestAxis = 0;
+		float bestDistance = -1.0f;
+		for (size_t axis = 0; axis < 3; ++axis) {
+			const float* a = &points[extremes[axis] * 3];
+			const float* b = &points[extremes[axis + 3] * 3];
+			float d[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+			if (Dot(d, d) > bestDistance) {
+				bestDistance = Dot(d, d);
+				bestAxis = axis;
+			}
+		}
+
+		const float* a = &points[extremes[bestAxis] * 3];
+		const float* b = &points[extremes[bestAxis + 3] * 3];
+		float center[3] = {(a[0] + b[0]) * 0.5f, (a[1] + b[1]) * 0.5f, (a[2] + b[2]) * 0.5f};
+		float radius = std::sqrt(bestDistance) * 0.5f;
+
+		// Grow the sphere to include every point outside of it.
+		for (size_t p = 0; p < count; ++p) {
+			const float* point = &points[p * 3];
+			float d[3] = {point[0] - center[0], point[1] - center[1], point[2] - center[2]};
+			float distance = std::sqrt(Dot(d, d));
+			if (distance > radius) {
+				float grow = (distance - radius) * 0.5f;
+				radius += grow;
+				for (size_t axis = 0; axis < 3; ++axis) {
+					center[axis] += d[axis] * (grow / distance);
+				}
+			}
+		}
+
+		memcpy(outCenter, center, sizeof(center));
+		*outRadius = radius;
+	}
+
+	// Computes the bounding sphere and normal cone of the last meshlet.
+	static MeshletBounds ComputeMeshletBounds(const MeshletData& data, const float* const* positions) {
+		const Meshlet& meshlet = data.meshlets.back();
+		MeshletBounds bounds;
+
+		std::vector<float> points(meshlet.vertexCount * 3);
+		for (size_t v = 0; v < meshlet.vertexCount; ++v) {
+			uint32_t vertex = data.vertices[meshlet.vertexOffset + v];
+			for (size_t axis = 0; axis < 3; ++axis) {
+				points[v * 3 + axis] = positions[axis][vertex];
+			}
+		}
+
+		ComputeBoundingSphere(points, bounds.center, &bounds.radius);
+
+		// The cone axis is the average of the unit triangle normals; degenerate triangles are ignored.
+		std::vector<float> normals;
+		std::vector<float> centroids;
+		float axis[3] = {0.0f, 0.0f, 0.0f};
+
+		for (size_t t = 0; t < meshlet.triangleCount; ++t) {
+			const uint8_t* triangle = &data.triangles[meshlet.triangleOffset + t * 3];
+			const float* p0 = &points[triangle[0] * 3];
+			const float* p1 = &points[triangle[1] * 3];
+			const float* p2 = &points[triangle[2] * 3];
+
+			float e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+			float e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+			float normal[3] = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+			float length = std::sqrt(Dot(normal, normal));
+			if (length == 0.0f) {
+				continue;
+			}
+
+			for (size_t c = 0; c < 3; ++c) {
+				normal[c] /= length;
+				axis[c] += normal[c];
+				normals.push_back(normal[c]);
+				centroids.push_back((p0[c] + p1[c] + p2[c]) / 3.0f);
+			}
+		}
+
+		memcpy(bounds.coneApex, bounds.center, sizeof(bounds.coneApex));
+		memset(bounds.coneAxis, 0, sizeof(bounds.coneAxis));
+		bounds.coneCutoff = 1.0f;
+
+		float axisLength = std::sqrt(Dot(axis, axis));
+		if (axisLength == 0.0f) {
+			return bounds;
+		}
+
+		for (size_t c = 0; c < 3; ++c) {
+			axis[c] /= axisLength;
+		}
+
+		float minDot = 1.0f;
+		for (size_t n = 0; n < normals.size(); n += 3) {
+			minDot = std::min(minDot, Dot(&normals[n], axis));
+		}
+
+		// Cones wider than about 85 degrees hardly ever cull anything.
+		if (minDot <= 0.1f) {
+			return bounds;
+		}
+
+		// Move the apex back along the axis until every triangle plane is in front of it.
+		float maxT = 0.0f;
+		for (size_t n = 0; n < normals.size(); n += 3) {
+			float d[3] = {bounds.center[0] - centroids[n], bounds.center[1] - centroids[n + 1], bounds.center[2] - centroids[n + 2]};
+			float t = Dot(d, &normals[n]) / Dot(axis, &normals[n]);
+			maxT = std::max(maxT, t);
+		}
+
+		for (size_t c = 0; c < 3; ++c) {
+			bounds.coneApex[c] = bounds.center[c] - axis[c] * maxT;
+			bounds.coneAxis[c] = axis[c];
+		}
+
+		bounds.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+		return bounds;
+	}
+
+	// Splits a triangle list into meshlets in index order.
+	bool BuildMeshlets(
+		const uint32_t* indices,
+		size_t indexCount,
+		const float* const* positions,
+		size_t vertexCount,
+		const MeshletOptions& options,
+		MeshletData* out,
+		std::string& outErr) {
+
+		if (options.maxVertices < 3 || options.maxVertices > 255 || options.maxTriangles < 1) {
+			outErr = "Meshlets need a maxVertices of 3 to 255 and a maxTriangles of at least 1.";
+			return false;
+		}
+
+		for (size_t i = 0; i < indexCount; ++i) {
+			if (indices[i] >= vertexCount) {
+				outErr = "An index is out of the range of the positions.";
+				return false;
+			}
+		}
+
+		out->meshlets.clear();
+		out->bounds.clear();
+		out->vertices.clear();
+		out->triangles.clear();
+
+		// The index within the current meshlet of every vertex.
+		std::vector<uint32_t> localIndices(vertexCount, NO_LOCAL_INDEX);
+
+		Meshlet current = {0, 0, 0, 0};
+		auto finish = [&]() {
+			for (size_t v = 0; v < current.vertexCount; ++v) {
+				localIndices[out->vertices[current.vertexOffset + v]] = NO_LOCAL_INDEX;
+			}
+
+			out->meshlets.push_back(current);
+			out->bounds.push_back(ComputeMeshletBounds(*out, positions));
+
+			current.vertexOffset = static_cast<uint32_t>(out->vertices.size());
+			current.triangleOffset = static_cast<uint32_t>(out->triangles.size());
+			current.vertexCount = 0;
+			current.triangleCount = 0;
+		};
+
+		for (size_t i = 0; i + 2 < indexCount; i += 3) {
+			size_t newVertices = 0;
+			for (size_t corner = 0; corner < 3; ++corner) {
+				uint32_t vertex = indices[i + corner];
+				bool repeated = (corner > 0 && vertex == indices[i]) || (corner > 1 && vertex == indices[i + 1]);
+				newVertices += localIndices[vertex] == NO_LOCAL_INDEX && !repeated;
+			}
+
+			if (current.vertexCount + newVertices > options.maxVertices || current.triangleCount == options.maxTriangles) {
+				finish();
+			}
+
+			for (size_t corner = 0; corner < 3; ++corner) {
+				uint32_t vertex = indices[i + corner];
+				if (localIndices[vertex] == NO_LOCAL_INDEX) {
+					localIndices[vertex] = current.vertexCount++;
+					out->vertices.push_back(vertex);
+				}
+
+				out->triangles.push_back(static_cast<uint8_t>(localIndices[vertex]));
+			}
+
+			++current.triangleCount;
+		}
+
+		if (current.triangleCount) {
+			finish();
+		}
+
+		return true;
+	}
+
+	// The work and results for a single primitive.
+	struct MeshletJob {
+		const Mesh::Primitive* primitive;
+		AccessorData positionData;
+		std::vector<float> positionOffset;
+		std::vector<float> positionScale;
+		std::string error;
+	};
+
+	// Builds the meshlets of a single primitive.
+	static bool RunMeshletJob(const glTF& doc, const MeshletOptions& options, const MeshletJob& job, MeshletData* out, std::string& outErr) {
+		IndexList list;
+		if (!ConvertPrimitiveToList(doc, *job.primitive, Accessor::COMPONENT_TYPE_UNSIGNED_INT, &list, outErr)) {
+			return false;
+		}
+
+		std::vector<uint32_t> indices(list.count);
+		if (list.count) {
+			memcpy(indices.data(), list.data.data(), list.count * sizeof(uint32_t));
+		}
+
+		size_t vertexCount = job.positionData.count;
+		std::vector<float> positions(vertexCount * 3);
+		float* components[3] = {positions.data(), positions.data() + vertexCount, positions.data() + vertexCount * 2};
+		if (!ConvertAccessorToSoA(job.positionData, false, components, outErr)) {
+			return false;
+		}
+
+		DecodeComponents(job.positionOffset, job.positionScale, vertexCount, components);
+
+		return BuildMeshlets(indices.data(), indices.size(), components, vertexCount, options, out, outErr);
+	}
+
+	// Builds the meshlets of every triangle primitive in the document.
+	bool BuildMeshlets(const glTF& doc, const MeshletOptions& options, std::vector<PrimitiveMeshlets>* out, std::string& outErr) {
+		std::vector<std::string> meshIds;
+		for (auto& mesh : doc.meshes) {
+			meshIds.push_back(mesh.first);
+		}
+
+		std::sort(meshIds.begin(), meshIds.end());
+
+		out->clear();
+		std::vector<MeshletJob> jobs;
+		for (const std::string& meshId : meshIds) {
+			auto& primitives = doc.meshes.at(meshId)->primitives;
+			for (size_t p = 0; p < primitives.size(); ++p) {
+				const Mesh::Primitive* primitive = primitives[p].get();
+				auto position = primitive->attributes.find("POSITION");
+				if (GetListMode(primitive->mode) != Mesh::Primitive::TYPE_TRIANGLES || position == primitive->attributes.end()) {
+					continue;
+				}
+
+				MeshletJob job;
+				job.primitive = primitive;
+				if (!GetAccessorData(doc, position->second, &job.positionData, outErr)
+					|| !GetAccessorDecode(doc, position->second, &job.positionOffset, &job.positionScale, outErr)) {
+					return false;
+				}
+
+				if (GetComponentCount(job.positionData.type) != 3) {
+					outErr = "The POSITION attribute of mesh '" + meshId + "' is not a VEC3.";
+					return false;
+				}
+
+				jobs.push_back(job);
+
+				PrimitiveMeshlets result;
+				result.mesh = meshId;
+				result.primitive = p;
+				out->push_back(std::move(result));
+			}
+		}
+
+		ParallelFor(jobs.size(), 1, [&](size_t begin, size_t end) {
+			for (size_t j = begin; j < end; ++j) {
+				RunMeshletJob(doc, options, jobs[j], &(*out)[j].data, jobs[j].error);
+			}
+		});
+
+		for (const MeshletJob& job : jobs) {
+			if (!job.error.empty()) {
+				outErr = job.error;
+				out->clear();
+				return false;
+			}
+		}
+
+		return true;
+	}
+}
\ No newline at end of file
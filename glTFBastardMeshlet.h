@@ -0,0 +1,98 @@
+/*
+Copyright (c) 2016 Ruben Cashie
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation 
+files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, 
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software 
+is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES 
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE 
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef GLTF_BASTARD_MESHLET_H
+#define GLTF_BASTARD_MESHLET_H
+
+#include "glTFBastardAccessor.h"
+
+namespace glTFBastard {
+
+	// A cluster of triangles; its vertices and triangles are ranges of the arrays in MeshletData.
+	struct Meshlet {
+		// The first element of MeshletData::vertices and the number of vertices.
+		uint32_t vertexOffset;
+		uint32_t vertexCount;
+
+		// The first element of MeshletData::triangles and the number of triangles, three local indices each.
+		uint32_t triangleOffset;
+		uint32_t triangleCount;
+	};
+
+	// The culling data of a meshlet.
+	// A meshlet is entirely back facing for a camera at position p if
+	// dot(normalize(coneApex - p), coneAxis) >= coneCutoff. A coneCutoff of one never culls.
+	struct MeshletBounds {
+		float center[3];
+		float radius;
+		float coneApex[3];
+		float coneAxis[3];
+		float coneCutoff;
+	};
+
+	// The meshlets of a triangle list, packed into flat arrays.
+	struct MeshletData {
+		std::vector<Meshlet> meshlets;
+		std::vector<MeshletBounds> bounds;
+
+		// The primitive's vertex index of every meshlet vertex.
+		std::vector<uint32_t> vertices;
+
+		// Three indices into the meshlet's vertices per triangle.
+		std::vector<uint8_t> triangles;
+	};
+
+	struct MeshletOptions {
+		// At most 255 so that local indices fit in a byte.
+		size_t maxVertices;
+		size_t maxTriangles;
+
+		MeshletOptions() :
+			maxVertices(64),
+			maxTriangles(124) {
+		}
+	};
+
+	// Splits a triangle list into meshlets in index order and computes their bounding spheres and normal cones.
+	// Meshlets are most compact when the triangles have been ordered for vertex cache locality first.
+	// positions holds the x, y and z arrays of vertexCount positions.
+	bool BuildMeshlets(
+		const uint32_t* indices,
+		size_t indexCount,
+		const float* const* positions,
+		size_t vertexCount,
+		const MeshletOptions& options,
+		MeshletData* out,
+		std::string& outErr);
+
+	// The meshlets of one primitive.
+	struct PrimitiveMeshlets {
+		std::string mesh;
+		size_t primitive;
+		MeshletData data;
+
+		PrimitiveMeshlets() :
+			primitive(0) {
+		}
+	};
+
+	// Builds the meshlets of every triangle, triangle strip and triangle fan primitive in the document, in parallel
+	// across primitives. Results are ordered by mesh id and primitive index.
+	// The buffers of the POSITION attributes and indices must have been loaded.
+	bool BuildMeshlets(const glTF& doc, const MeshletOptions& options, std::vector<PrimitiveMeshlets>* out, std::string& outErr);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,168 @@
+/*
+Copyright (c) 2016 Ruben Cashie
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation 
+files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, 
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software 
+is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES 
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE 
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "glTFBastardParallel.h"
+
+namespace glTFBastard {
+
+	// A fixed set of worker threads that cooperate on one ParallelFor at a time.
+	class WorkerPool {
+	public:
+		WorkerPool() :
+			busy(false),
+			body(nullptr),
+			count(0),
+			grainSize(1),
+			nextIndex(0),
+			generation(0),
+			activeWorkers(0),
+			shuttingDown(false) {
+
+			unsigned int hardwareThreads = std::thread::hardware_concurrency();
+			size_t workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+			for (size_t i = 0; i < workerCount; ++i) {
+				workers.push_back(std::thread(&WorkerPool::WorkerMain, this));
+			}
+		}
+
+		~WorkerPool() {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				shuttingDown = true;
+			}
+
+			wakeWorkers.notify_all();
+			for (auto& worker : workers) {
+				worker.join();
+			}
+		}
+
+		size_t GetThreadCount() const {
+			return workers.size() + 1;
+		}
+
+		// Runs the loop on the pool; returns false without running anything if the pool is already busy.
+		bool TryRun(size_t loopCount, size_t loopGrainSize, const std::function<void(size_t, size_t)>& loopBody) {
+			bool expected = false;
+			if (!busy.compare_exchange_strong(expected, true)) {
+				return false;
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				body = &loopBody;
+				count = loopCount;
+				grainSize = loopGrainSize;
+				nextIndex = 0;
+				activeWorkers = workers.size();
+				++generation;
+			}
+
+			wakeWorkers.notify_all();
+			RunRanges();
+
+			std::unique_lock<std::mutex> lock(mutex);
+			workersDone.wait(lock, [this] { return activeWorkers == 0; });
+			body = nullptr;
+			busy = false;
+			return true;
+		}
+
+	private:
+		// Claims and runs ranges until the loop is exhausted.
+		void RunRanges() {
+			for (;;) {
+				size_t begin = nextIndex.fetch_add(grainSize);
+				if (begin >= count) {
+					return;
+				}
+
+				size_t end = count - begin < grainSize ? count : begin + grainSize;
+				(*body)(begin, end);
+			}
+		}
+
+		void WorkerMain() {
+			size_t seenGeneration = 0;
+			for (;;) {
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					wakeWorkers.wait(lock, [this, seenGeneration] { return shuttingDown || generation != seenGeneration; });
+					if (shuttingDown) {
+						return;
+					}
+
+					seenGeneration = generation;
+				}
+
+				RunRanges();
+
+				std::lock_guard<std::mutex> lock(mutex);
+				if (--activeWorkers == 0) {
+					workersDone.notify_one();
+				}
+			}
+		}
+
+		std::vector<std::thread> workers;
+		std::atomic<bool> busy;
+		std::mutex mutex;
+		std::condition_variable wakeWorkers;
+		std::condition_variable workersDone;
+
+		const std::function<void(size_t, size_t)>* body;
+		size_t count;
+		size_t grainSize;
+		std::atomic<size_t> nextIndex;
+		size_t generation;
+		size_t activeWorkers;
+		bool shuttingDown;
+	};
+
+	// Returns the process wide worker pool; it is created on first use.
+	static WorkerPool& GetWorkerPool() {
+		static WorkerPool pool;
+		return pool;
+	}
+
+	// Runs a loop across the worker pool.
+	void ParallelFor(size_t count, size_t grainSize, const std::function<void(size_t begin, size_t end)>& body) {
+		if (!count) {
+			return;
+		}
+
+		if (!grainSize) {
+			grainSize = 1;
+		}
+
+		// Not worth waking the pool for a single range.
+		if (count <= grainSize || !GetWorkerPool().TryRun(count, grainSize, body)) {
+			for (size_t begin = 0; begin < count; begin += grainSize) {
+				body(begin, count - begin < grainSize ? count : begin + grainSize);
+			}
+		}
+	}
+
+	// Returns the number of threads that ParallelFor spreads work over.
+	size_t GetParallelThreadCount() {
+		return GetWorkerPool().GetThreadCount();
+	}
+}
\ No newline at end of file
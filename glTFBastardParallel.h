@@ -0,0 +1,35 @@
+/*
+Copyright (c) 2016 Ruben Cashie
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation 
+files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, 
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software 
+is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES 
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE 
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef GLTF_BASTARD_PARALLEL_H
+#define GLTF_BASTARD_PARALLEL_H
+
+#include <cstddef>
+#include <functional>
+
+namespace glTFBastard {
+
+	// Splits [0, count) into ranges of at most grainSize indices and runs body(begin, end) for each of them
+	// across a process wide pool of worker threads. The calling thread takes part and the call returns once
+	// every range has been processed.
+	// Calls made while the pool is busy, including calls from within a body, run on the calling thread.
+	void ParallelFor(size_t count, size_t grainSize, const std::function<void(size_t begin, size_t end)>& body);
+
+	// Returns the number of threads, including the calling thread, that ParallelFor spreads work over.
+	size_t GetParallelThreadCount();
+}
+
+#endif
\ No newline at end of file
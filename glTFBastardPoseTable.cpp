@@ -0,0 +1,435 @@
+/*
+Copyright (c) 2016 Ruben Cashie
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation 
+files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, 
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software 
+is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES 
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE 
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include "glTFBastardBufferCache.h"
+#include "glTFBastardParallel.h"
+#include "glTFBastardPoseTable.h"
+
+namespace glTFBastard {
+
+	// "GBPT" in little endian; tables written on a machine of the other byte order do not match it.
+	static const uint32_t POSE_TABLE_MAGIC = 0x54504247;
+	static const uint32_t POSE_TABLE_VERSION = 1;
+
+	// Frames start on a cache line.
+	static const size_t POSE_TABLE_FRAME_ALIGNMENT = 64;
+
+	// The layout of a pose table: the header, a record per clip, a record per track, the names of the clips and
+	// nodes, and then the frames of each clip. Offsets are from the start of the table.
+	struct PoseTableHeader {
+		uint32_t magic;
+		uint32_t version;
+		uint64_t hash;
+		float frameRate;
+		uint32_t clipCount;
+	};
+
+	struct PoseTableClipRecord {
+		uint64_t framesOffset;
+		uint32_t nameOffset;
+		uint32_t nameLength;
+		uint32_t tracksOffset;
+		uint32_t trackCount;
+		uint32_t frameCount;
+		uint32_t valueCount;
+		float startTime;
+		float endTime;
+	};
+
+	struct PoseTableTrackRecord {
+		uint32_t nodeOffset;
+		uint32_t nodeLength;
+		uint32_t path;
+	};
+
+	struct NamedClip {
+		std::string animation;
+		AnimationClip clip;
+	};
+
+	// Decodes every animation of a document, ordered by id.
+	static bool LoadClips(const glTF& doc, std::vector<NamedClip>* out, std::string& outErr) {
+		std::vector<std::string> animationIds;
+		for (auto& animation : doc.animations) {
+			animationIds.push_back(animation.first);
+		}
+
+		std::sort(animationIds.begin(), animationIds.end());
+
+		out->resize(animationIds.size());
+		for (size_t i = 0; i < animationIds.size(); ++i) {
+			(*out)[i].animation = animationIds[i];
+			if (!LoadAnimationClip(doc, animationIds[i], &(*out)[i].clip, outErr)) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	static void AppendBytes(std::vector<unsigned char>* out, const void* data, size_t size) {
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		out->insert(out->end(), bytes, bytes + size);
+	}
+
+	static void AppendString(std::vector<unsigned char>* out, const std::string& value) {
+		uint64_t length = value.size();
+		AppendBytes(out, &length, sizeof(length));
+		AppendBytes(out, value.data(), value.size());
+	}
+
+	// Hashes everything that the frames of a table depend on.
+	static uint64_t HashClips(const std::vector<NamedClip>& clips, float frameRate) {
+		std::vector<unsigned char> key;
+		AppendBytes(&key, &POSE_TABLE_VERSION, sizeof(POSE_TABLE_VERSION));
+		AppendBytes(&key, &frameRate, sizeof(frameRate));
+		for (const NamedClip& named : clips) {
+			AppendString(&key, named.animation);
+			for (const AnimationTrack& track : named.clip.tracks) {
+				uint32_t path = track.path;
+				uint64_t keyCount = track.times.size();
+				AppendString(&key, track.node);
+				AppendBytes(&key, &path, sizeof(path));
+				AppendBytes(&key, &keyCount, sizeof(keyCount));
+				AppendBytes(&key, track.times.data(), track.times.size() * sizeof(float));
+				AppendBytes(&key, track.values.data(), track.values.size() * sizeof(float));
+			}
+		}
+
+		return HashBufferContents(key.data(), key.size());
+	}
+
+	bool HashAnimations(const glTF& doc, float frameRate, uint64_t* outHash, std::string& outErr) {
+		std::vector<NamedClip> clips;
+		if (!LoadClips(doc, &clips, outErr)) {
+			return false;
+		}
+
+		*outHash = HashClips(clips, frameRate);
+		return true;
+	}
+
+	// Samples every frame of a clip into a table.
+	static void BakeFrames(const AnimationClip& clip, float frameRate, uint32_t frameCount, float* outFrames) {
+		size_t valueCount = clip.GetValueCount();
+		ParallelFor(frameCount, 32, [&](size_t begin, size_t end) {
+			std::vector<uint32_t> cursors;
+			for (size_t f = begin; f < end; ++f) {
+				float time = std::min(static_cast<float>(clip.startTime + f / static_cast<double>(frameRate)), clip.endTime);
+				SampleAnimation(clip, time, ROTATION_INTERPOLATION_SLERP, &cursors, outFrames + f * valueCount);
+			}
+		});
+
+		// Flip rotations onto the hemisphere of the previous frame so that playback can interpolate them directly.
+		size_t offset = 0;
+		for (const AnimationTrack& track : clip.tracks) {
+			if (track.path == AnimationTrack::PATH_ROTATION) {
+				for (size_t f = 1; f < frameCount; ++f) {
+					const float* previous = outFrames + (f - 1) * valueCount + offset;
+					float* current = outFrames + f * valueCount + offset;
+					if (previous[0] * current[0] + previous[1] * current[1] + previous[2] * current[2] + previous[3] * current[3] < 0.0f) {
+						for (size_t c = 0; c < 4; ++c) {
+							current[c] = -current[c];
+						}
+					}
+				}
+			}
+
+			offset += track.GetComponentCount();
+		}
+	}
+
+	PoseTable::PoseTable() :
+		size(0),
+		hash(0),
+		frameRate(0.0f) {
+	}
+
+	bool PoseTable::Bake(const glTF& doc, float bakeFrameRate, std::string& outErr) {
+		if (!(bakeFrameRate > 0.0f)) {
+			outErr = "The frame rate of a pose table must be positive.";
+			return false;
+		}
+
+		std::vector<NamedClip> named;
+		if (!LoadClips(doc, &named, outErr)) {
+			return false;
+		}
+
+		// Lay out the records and names first, then the frames of each clip.
+		std::vector<PoseTableClipRecord> clipRecords(named.size());
+		std::vector<PoseTableTrackRecord> trackRecords;
+		std::string names;
+		size_t trackCount = 0;
+		for (const NamedClip& clip : named) {
+			trackCount += clip.clip.tracks.size();
+		}
+
+		size_t namesOffset = sizeof(PoseTableHeader) + clipRecords.size() * sizeof(PoseTableClipRecord) + trackCount * sizeof(PoseTableTrackRecord);
+		for (size_t i = 0; i < named.size(); ++i) {
+			const AnimationClip& clip = named[i].clip;
+			PoseTableClipRecord& record = clipRecords[i];
+			record.nameOffset = static_cast<uint32_t>(namesOffset + names.size());
+			record.nameLength = static_cast<uint32_t>(named[i].animation.size());
+			names += named[i].animation;
+
+			record.tracksOffset = static_cast<uint32_t>(sizeof(PoseTableHeader) + clipRecords.size() * sizeof(PoseTableClipRecord)
+				+ trackRecords.size() * sizeof(PoseTableTrackRecord));
+			record.trackCount = static_cast<uint32_t>(clip.tracks.size());
+			for (const AnimationTrack& track : clip.tracks) {
+				PoseTableTrackRecord trackRecord;
+				trackRecord.nodeOffset = static_cast<uint32_t>(namesOffset + names.size());
+				trackRecord.nodeLength = static_cast<uint32_t>(track.node.size());
+				trackRecord.path = track.path;
+				trackRecords.push_back(trackRecord);
+				names += track.node;
+			}
+
+			// The last frame is at or just past the end of the clip; a small allowance keeps rounding from adding one.
+			double duration = static_cast<double>(clip.endTime) - clip.startTime;
+			record.frameCount = static_cast<uint32_t>(std::ceil(std::max(duration * bakeFrameRate - 0.001, 0.0))) + 1;
+			record.valueCount = static_cast<uint32_t>(clip.GetValueCount());
+			record.startTime = clip.startTime;
+			record.endTime = clip.endTime;
+		}
+
+		size_t tableSize = namesOffset + names.size();
+		for (PoseTableClipRecord& record : clipRecords) {
+			tableSize = (tableSize + POSE_TABLE_FRAME_ALIGNMENT - 1) / POSE_TABLE_FRAME_ALIGNMENT * POSE_TABLE_FRAME_ALIGNMENT;
+			record.framesOffset = tableSize;
+			tableSize += static_cast<size_t>(record.frameCount) * record.valueCount * sizeof(float);
+		}
+
+		PoseTableHeader header;
+		header.magic = POSE_TABLE_MAGIC;
+		header.version = POSE_TABLE_VERSION;
+		header.hash = HashClips(named, bakeFrameRate);
+		header.frameRate = bakeFrameRate;
+		header.clipCount = static_cast<uint32_t>(clipRecords.size());
+
+		std::shared_ptr<std::vector<unsigned char>> storage(new std::vector<unsigned char>(tableSize));
+		unsigned char* table = storage->data();
+		memcpy(table, &header, sizeof(header));
+		if (!clipRecords.empty()) {
+			memcpy(table + sizeof(header), clipRecords.data(), clipRecords.size() * sizeof(PoseTableClipRecord));
+		}
+
+		if (!trackRecords.empty()) {
+			memcpy(table + sizeof(header) + clipRecords.size() * sizeof(PoseTableClipRecord), trackRecords.data(), trackRecords.size() * sizeof(PoseTableTrackRecord));
+		}
+
+		if (!names.empty()) {
+			memcpy(table + namesOffset, names.data(), names.size());
+		}
+
+		for (size_t i = 0; i < named.size(); ++i) {
+			BakeFrames(named[i].clip, bakeFrameRate, clipRecords[i].frameCount, reinterpret_cast<float*>(table + clipRecords[i].framesOffset));
+		}
+
+		return Parse(std::shared_ptr<const unsigned char>(storage, table), tableSize, outErr);
+	}
+
+	bool PoseTable::Parse(const std::shared_ptr<const unsigned char>& tableData, size_t tableSize, std::string& outErr) {
+		const unsigned char* table = tableData.get();
+		const std::string corrupt = "The pose table is truncated or corrupt.";
+
+		PoseTableHeader header;
+		if (tableSize < sizeof(header)) {
+			outErr = corrupt;
+			return false;
+		}
+
+		memcpy(&header, table, sizeof(header));
+		if (header.magic != POSE_TABLE_MAGIC || header.version != POSE_TABLE_VERSION) {
+			outErr = "The file is not a pose table of this version and byte order.";
+			return false;
+		}
+
+		uint64_t recordsEnd = sizeof(header) + static_cast<uint64_t>(header.clipCount) * sizeof(PoseTableClipRecord);
+		if (recordsEnd > tableSize) {
+			outErr = corrupt;
+			return false;
+		}
+
+		std::vector<BakedClip> parsedClips(header.clipCount);
+		for (size_t i = 0; i < parsedClips.size(); ++i) {
+			PoseTableClipRecord record;
+			memcpy(&record, table + sizeof(header) + i * sizeof(record), sizeof(record));
+
+			uint64_t tracksEnd = record.tracksOffset + static_cast<uint64_t>(record.trackCount) * sizeof(PoseTableTrackRecord);
+			uint64_t frameBytes = static_cast<uint64_t>(record.frameCount) * record.valueCount * sizeof(float);
+			if (static_cast<uint64_t>(record.nameOffset) + record.nameLength > tableSize || tracksEnd > tableSize
+				|| record.frameCount == 0 || record.valueCount > record.trackCount * 4ULL
+				|| record.framesOffset % sizeof(float) || record.framesOffset > tableSize || frameBytes > tableSize - record.framesOffset) {
+				outErr = corrupt;
+				return false;
+			}
+
+			BakedClip& clip = parsedClips[i];
+			clip.animation.assign(reinterpret_cast<const char*>(table + record.nameOffset), record.nameLength);
+			clip.startTime = record.startTime;
+			clip.endTime = record.endTime;
+			clip.frameCount = record.frameCount;
+			clip.valueCount = record.valueCount;
+			clip.frames = reinterpret_cast<const float*>(table + record.framesOffset);
+
+			uint64_t valueCount = 0;
+			for (size_t t = 0; t < record.trackCount; ++t) {
+				PoseTableTrackRecord trackRecord;
+				memcpy(&trackRecord, table + record.tracksOffset + t * sizeof(trackRecord), sizeof(trackRecord));
+				if (static_cast<uint64_t>(trackRecord.nodeOffset) + trackRecord.nodeLength > tableSize || trackRecord.path > AnimationTrack::PATH_SCALE) {
+					outErr = corrupt;
+					return false;
+				}
+
+				AnimationTrack::Path path = static_cast<AnimationTrack::Path>(trackRecord.path);
+				clip.nodes.push_back(std::string(reinterpret_cast<const char*>(table + trackRecord.nodeOffset), trackRecord.nodeLength));
+				clip.paths.push_back(path);
+				valueCount += path == AnimationTrack::PATH_ROTATION ? 4 : 3;
+			}
+
+			if (valueCount != record.valueCount) {
+				outErr = corrupt;
+				return false;
+			}
+		}
+
+		data = tableData;
+		size = tableSize;
+		hash = header.hash;
+		frameRate = header.frameRate;
+		clips.swap(parsedClips);
+		return true;
+	}
+
+	bool PoseTable::Save(const std::string& path, std::string& outErr) const {
+		std::stringstream ss;
+		ss << path << ".tmp" << std::hex << std::random_device()();
+		std::string temporaryPath = ss.str();
+
+		std::ofstream file(temporaryPath.c_str(), std::ios::binary | std::ios::trunc);
+		if (!file) {
+			outErr = "Could not create file '" + temporaryPath + "'.";
+			return false;
+		}
+
+		file.write(reinterpret_cast<const char*>(data.get()), static_cast<std::streamsize>(size));
+		file.close();
+		if (!file) {
+			std::remove(temporaryPath.c_str());
+			outErr = "Could not write file '" + temporaryPath + "'.";
+			return false;
+		}
+
+		// Renaming over an existing file fails on Windows, so another process may have saved the same table first.
+		if (std::rename(temporaryPath.c_str(), path.c_str()) != 0) {
+			std::remove(path.c_str());
+			if (std::rename(temporaryPath.c_str(), path.c_str()) != 0) {
+				std::remove(temporaryPath.c_str());
+				outErr = "Could not rename '" + temporaryPath + "' to '" + path + "'.";
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool PoseTable::Load(const std::string& path, std::string& outErr) {
+		BufferContents contents = MapBufferFile(path);
+		if (!contents.data) {
+			outErr = contents.error;
+			return false;
+		}
+
+		return Parse(contents.data, contents.size, outErr);
+	}
+
+	void PoseTable::Sample(const BakedClip& clip, float time, float* out) const {
+		float position = (std::min(std::max(time, clip.startTime), clip.endTime) - clip.startTime) * frameRate;
+		uint32_t frame = std::min(static_cast<uint32_t>(position), clip.frameCount - 1);
+		uint32_t next = std::min(frame + 1, clip.frameCount - 1);
+		float t = std::min(position - static_cast<float>(frame), 1.0f);
+
+		// The last frame is clamped to the end of the clip, so the final interval may be shorter than a frame period.
+		if (next != frame && next == clip.frameCount - 1) {
+			float interval = (clip.endTime - clip.startTime) * frameRate - static_cast<float>(frame);
+			t = interval > 0.0f ? std::min((position - static_cast<float>(frame)) / interval, 1.0f) : 1.0f;
+		}
+
+		const float* a = clip.frames + static_cast<size_t>(frame) * clip.valueCount;
+		const float* b = clip.frames + static_cast<size_t>(next) * clip.valueCount;
+		for (size_t i = 0; i < clip.valueCount; ++i) {
+			out[i] = a[i] + (b[i] - a[i]) * t;
+		}
+
+		size_t offset = 0;
+		for (AnimationTrack::Path path : clip.paths) {
+			if (path == AnimationTrack::PATH_ROTATION) {
+				float* rotation = out + offset;
+				float lengthSquared = rotation[0] * rotation[0] + rotation[1] * rotation[1] + rotation[2] * rotation[2] + rotation[3] * rotation[3];
+				float inverseLength = lengthSquared > 0.0f ? 1.0f / std::sqrt(lengthSquared) : 0.0f;
+				for (size_t c = 0; c < 4; ++c) {
+					rotation[c] *= inverseLength;
+				}
+
+				offset += 4;
+			}
+			else {
+				offset += 3;
+			}
+		}
+	}
+
+	const BakedClip* PoseTable::FindClip(const std::string& animationId) const {
+		for (const BakedClip& clip : clips) {
+			if (clip.animation == animationId) {
+				return &clip;
+			}
+		}
+
+		return nullptr;
+	}
+
+	bool LoadOrBakePoseTable(const glTF& doc, float frameRate, const std::string& directory, PoseTable* out, std::string& outErr) {
+		uint64_t hash;
+		if (!HashAnimations(doc, frameRate, &hash, outErr)) {
+			return false;
+		}
+
+		std::stringstream ss;
+		if (!directory.empty()) {
+			ss << directory << '/';
+		}
+
+		ss << std::hex << std::setw(16) << std::setfill('0') << hash << ".poses";
+		std::string path = ss.str();
+
+		// A missing, stale or damaged file is simply baked again.
+		std::string loadErr;
+		if (out->Load(path, loadErr) && out->GetHash() == hash) {
+			return true;
+		}
+
+		return out->Bake(doc, frameRate, outErr) && out->Save(path, outErr);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,111 @@
+/*
+Copyright (c) 2016 Ruben Cashie
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation 
+files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, 
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software 
+is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES 
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE 
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef GLTF_BASTARD_POSE_TABLE_H
+#define GLTF_BASTARD_POSE_TABLE_H
+
+#include <cstdint>
+#include "glTFBastardAnimation.h"
+
+namespace glTFBastard {
+
+	// An animation resampled at a fixed rate. Frame f holds the value of every track at startTime + f / frameRate,
+	// clamped to endTime, laid out as SampleAnimation writes them; consecutive rotations are kept on the same
+	// hemisphere so that they can be interpolated directly.
+	struct BakedClip {
+		std::string animation;
+
+		// The target node and path of each track.
+		std::vector<std::string> nodes;
+		std::vector<AnimationTrack::Path> paths;
+
+		float startTime;
+		float endTime;
+		uint32_t frameCount;
+
+		// The number of floats per frame.
+		uint32_t valueCount;
+
+		// frameCount * valueCount floats, owned by the pose table.
+		const float* frames;
+
+		BakedClip() :
+			startTime(0.0f),
+			endTime(0.0f),
+			frameCount(0),
+			valueCount(0),
+			frames(nullptr) {
+		}
+	};
+
+	// The baked clips of every animation of a document in one contiguous block, which is the same in memory and on
+	// disk. Tables loaded from a file map it rather than read it, so every process that plays the same document
+	// shares one copy through the page cache. Read-only once baked or loaded, so any number of threads can sample it.
+	class PoseTable {
+	public:
+		PoseTable();
+
+		// Resamples every animation of a document at frameRate frames per second. Frames are sampled in parallel
+		// with slerp. The buffers of every animation must have been loaded.
+		bool Bake(const glTF& doc, float frameRate, std::string& outErr);
+
+		// Writes the table to a file. The file is written under a temporary name and then renamed, so that other
+		// processes never map a partly written table.
+		bool Save(const std::string& path, std::string& outErr) const;
+
+		// Maps a table written by Save. Fails if the file is not a pose table of this version and byte order.
+		bool Load(const std::string& path, std::string& outErr);
+
+		// Samples a clip with two frame reads and a linear interpolation, normalizing rotations; out receives
+		// valueCount floats. Times outside of the clip are clamped.
+		void Sample(const BakedClip& clip, float time, float* out) const;
+
+		// Returns the clip baked from an animation, or null.
+		const BakedClip* FindClip(const std::string& animationId) const;
+
+		const std::vector<BakedClip>& GetClips() const {
+			return clips;
+		}
+
+		// The hash of the animation data and rate that the table was baked from; see HashAnimations.
+		uint64_t GetHash() const {
+			return hash;
+		}
+
+		float GetFrameRate() const {
+			return frameRate;
+		}
+
+	private:
+		bool Parse(const std::shared_ptr<const unsigned char>& tableData, size_t tableSize, std::string& outErr);
+
+		std::shared_ptr<const unsigned char> data;
+		size_t size;
+		uint64_t hash;
+		float frameRate;
+		std::vector<BakedClip> clips;
+	};
+
+	// Hashes the decoded channels of every animation of a document together with a frame rate, which identifies
+	// the pose table baked from them. The buffers of every animation must have been loaded.
+	bool HashAnimations(const glTF& doc, float frameRate, uint64_t* outHash, std::string& outErr);
+
+	// Loads the pose table of a document from "<directory>/<hash>.poses", with the hash of HashAnimations in hex.
+	// If there is no such file or it can not be used, the table is baked and saved there for the next time.
+	bool LoadOrBakePoseTable(const glTF& doc, float frameRate, const std::string& directory, PoseTable* out, std::string& outErr);
+}
+
+#endif
\ No newline at end of file
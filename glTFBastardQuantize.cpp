@@ -0,0 +1,369 @@
+/*
+Copyright (c) 2016 Ruben Cashie
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation 
+files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, 
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software 
+is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES 
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE 
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include "glTFBastardBounds.h"
+#include "glTFBastardBuilder.h"
+#include "glTFBastardConvert.h"
+#include "glTFBastardParallel.h"
+#include "glTFBastardQuantize.h"
+
+namespace glTFBastard {
+
+	static float SignNotZero(float value) {
+		return value < 0.0f ? -1.0f : 1.0f;
+	}
+
+	// Encodes a unit vector into two octahedral components.
+	void EncodeOctahedral(const float* normal, float* outEncoded) {
+		float sum = std::fabs(normal[0]) + std::fabs(normal[1]) + std::fabs(normal[2]);
+		if (sum == 0.0f) {
+			outEncoded[0] = 0.0f;
+			outEncoded[1] = 0.0f;
+			return;
+		}
+
+		float x = normal[0] / sum;
+		float y = normal[1] / sum;
+		if (normal[2] < 0.0f) {
+			float foldedX = (1.0f - std::fabs(y)) * SignNotZero(x);
+			float foldedY = (1.0f - std::fabs(x)) * SignNotZero(y);
+			x = foldedX;
+			y = foldedY;
+		}
+
+		outEncoded[0] = x;
+		outEncoded[1] = y;
+	}
+
+	// Decodes two octahedral components into a unit vector.
+	void DecodeOctahedral(const float* encoded, float* outNormal) {
+		float x = encoded[0];
+		float y = encoded[1];
+		float z = 1.0f - std::fabs(x) - std::fabs(y);
+		if (z < 0.0f) {
+			float unfoldedX = (1.0f - std::fabs(y)) * SignNotZero(x);
+			float unfoldedY = (1.0f - std::fabs(x)) * SignNotZero(y);
+			x = unfoldedX;
+			y = unfoldedY;
+		}
+
+		float length = std::sqrt(x * x + y * y + z * z);
+		outNormal[0] = x / length;
+		outNormal[1] = y / length;
+		outNormal[2] = z / length;
+	}
+
+	// The work and results for a single accessor.
+	struct QuantizeJob {
+		AccessorData data;
+		QuantizeReport report;
+		Accessor::Type type;
+		std::vector<unsigned char> encoded;
+		std::string error;
+	};
+
+	// The integer component types tried in order, with the largest value they encode.
+	struct QuantizeLevel {
+		Accessor::ComponentType componentType;
+		float levels;
+	};
+
+	static const QuantizeLevel LINEAR_LEVELS[] = {
+		{Accessor::COMPONENT_TYPE_UNSIGNED_BYTE, 255.0f},
+		{Accessor::COMPONENT_TYPE_UNSIGNED_SHORT, 65535.0f}
+	};
+
+	static const QuantizeLevel OCTAHEDRAL_LEVELS[] = {
+		{Accessor::COMPONENT_TYPE_BYTE, 127.0f},
+		{Accessor::COMPONENT_TYPE_SHORT, 32767.0f}
+	};
+
+	// Quantizes components to the smallest unsigned integer type whose decode error is within the relative bound.
+	static bool QuantizeLinear(QuantizeJob* job, const std::vector<float>& values, float maxRelativeError) {
+		size_t count = job->data.count;
+		size_t componentCount = GetComponentCount(job->data.type);
+
+		std::vector<float> minimum(componentCount, 0.0f);
+		std::vector<float> maximum(componentCount, 0.0f);
+		float extent = 0.0f;
+		for (size_t c = 0; c < componentCount; ++c) {
+			const float* component = &values[c * count];
+			if (count) {
+				minimum[c] = *std::min_element(component, component + count);
+				maximum[c] = *std::max_element(component, component + count);
+			}
+
+			extent = std::max(extent, maximum[c] - minimum[c]);
+		}
+
+		std::vector<float> quantized(values.size());
+		for (const QuantizeLevel& level : LINEAR_LEVELS) {
+			std::vector<float> scale(componentCount);
+			float maxError = 0.0f;
+
+			for (size_t c = 0; c < componentCount; ++c) {
+				scale[c] = (maximum[c] - minimum[c]) / level.levels;
+				for (size_t i = 0; i < count; ++i) {
+					float value = values[c * count + i];
+					float q = scale[c] > 0.0f ? std::floor((value - minimum[c]) / scale[c] + 0.5f) : 0.0f;
+					quantized[c * count + i] = q;
+					maxError = std::max(maxError, std::fabs(minimum[c] + q * scale[c] - value));
+				}
+			}
+
+			if (maxError > maxRelativeError * extent) {
+				continue;
+			}
+
+			std::vector<const float*> components(componentCount);
+			for (size_t c = 0; c < componentCount; ++c) {
+				components[c] = &quantized[c * count];
+			}
+
+			job->encoded.resize(count * componentCount * GetComponentSize(level.componentType));
+			if (!ConvertSoAToAccessor(
+				components.data(), count, false, level.componentType, job->data.type, job->encoded.data(), 0, job->error)) {
+				return false;
+			}
+
+			job->report.encoding = QUANTIZE_ENCODING_LINEAR;
+			job->report.componentType = level.componentType;
+			job->report.maxError = maxError;
+			job->report.decodeOffset = minimum;
+			job->report.decodeScale = scale;
+			job->type = job->data.type;
+			return true;
+		}
+
+		return true;
+	}
+
+	// Encodes normals as octahedral pairs of the smallest signed integer type whose angular error is within the bound.
+	static bool QuantizeOctahedral(QuantizeJob* job, const std::vector<float>& values, float maxAngle) {
+		size_t count = job->data.count;
+		if (GetComponentCount(job->data.type) != 3) {
+			return true;
+		}
+
+		std::vector<float> encoded(count * 2);
+		for (size_t i = 0; i < count; ++i) {
+			float normal[3] = {values[i], values[count + i], values[count * 2 + i]};
+			float pair[2];
+			EncodeOctahedral(normal, pair);
+			encoded[i] = pair[0];
+			encoded[count + i] = pair[1];
+		}
+
+		for (const QuantizeLevel& level : OCTAHEDRAL_LEVELS) {
+			float maxError = 0.0f;
+			for (size_t i = 0; i < count; ++i) {
+				float normal[3] = {values[i], values[count + i], values[count * 2 + i]};
+				float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+				if (length == 0.0f) {
+					continue;
+				}
+
+				float pair[2] = {
+					std::floor(encoded[i] * level.levels + 0.5f) / level.levels,
+					std::floor(encoded[count + i] * level.levels + 0.5f) / level.levels
+				};
+
+				float decoded[3];
+				DecodeOctahedral(pair, decoded);
+
+				float cross[3] = {
+					normal[1] * decoded[2] - normal[2] * decoded[1],
+					normal[2] * decoded[0] - normal[0] * decoded[2],
+					normal[0] * decoded[1] - normal[1] * decoded[0]
+				};
+
+				float sine = std::sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]);
+				float cosine = normal[0] * decoded[0] + normal[1] * decoded[1] + normal[2] * decoded[2];
+				maxError = std::max(maxError, std::atan2(sine, cosine));
+			}
+
+			if (maxError > maxAngle) {
+				continue;
+			}
+
+			const float* components[2] = {&encoded[0], &encoded[count]};
+			job->encoded.resize(count * 2 * GetComponentSize(level.componentType));
+			if (!ConvertSoAToAccessor(
+				components, count, true, level.componentType, Accessor::TYPE_VEC2, job->encoded.data(), 0, job->error)) {
+				return false;
+			}
+
+			job->report.encoding = QUANTIZE_ENCODING_OCTAHEDRAL;
+			job->report.componentType = level.componentType;
+			job->report.maxError = maxError;
+			job->type = Accessor::TYPE_VEC2;
+			return true;
+		}
+
+		return true;
+	}
+
+	// Encodes a single accessor without touching the document.
+	static void RunQuantizeJob(const QuantizeOptions& options, QuantizeJob* job) {
+		size_t count = job->data.count;
+		size_t componentCount = GetComponentCount(job->data.type);
+
+		std::vector<float> values(count * componentCount);
+		std::vector<float*> components(componentCount);
+		for (size_t c = 0; c < componentCount; ++c) {
+			components[c] = &values[c * count];
+		}
+
+		if (!ConvertAccessorToSoA(job->data, false, components.data(), job->error)) {
+			return;
+		}
+
+		for (float value : values) {
+			if (!std::isfinite(value)) {
+				return;
+			}
+		}
+
+		if (job->report.semantic == "NORMAL") {
+			QuantizeOctahedral(job, values, options.maxNormalError);
+		}
+		else if (job->report.semantic == "POSITION") {
+			QuantizeLinear(job, values, options.maxPositionError);
+		}
+		else {
+			QuantizeLinear(job, values, options.maxTexCoordError);
+		}
+
+		job->report.byteLengthAfter = job->report.encoding == QUANTIZE_ENCODING_NONE
+			? job->report.byteLengthBefore
+			: job->encoded.size();
+	}
+
+	// Quantizes the float POSITION, NORMAL and TEXCOORD_n accessors of every primitive.
+	bool QuantizeAttributes(glTF* doc, const QuantizeOptions& options, std::vector<QuantizeReport>* outReport, std::string& outErr) {
+		// Find the semantic of every attribute accessor; an empty semantic marks accessors used with several.
+		std::unordered_map<std::string, std::string> semantics;
+		for (auto& mesh : doc->meshes) {
+			for (auto& primitive : mesh.second->primitives) {
+				for (auto& attribute : primitive->attributes) {
+					const std::string& name = attribute.first;
+					std::string semantic = name == "POSITION" || name == "NORMAL" || name.compare(0, 8, "TEXCOORD") == 0 ? name : "";
+					if (semantic.compare(0, 8, "TEXCOORD") == 0) {
+						semantic = "TEXCOORD";
+					}
+
+					auto existing = semantics.find(attribute.second);
+					if (existing == semantics.end()) {
+						semantics[attribute.second] = semantic;
+					}
+					else if (existing->second != semantic) {
+						existing->second.clear();
+					}
+				}
+			}
+		}
+
+		// The decode transform is stored under an id derived from the accessor's, so that id has to be free.
+		std::vector<std::string> accessorIds;
+		for (auto& semantic : semantics) {
+			if (!semantic.second.empty() && doc->accessors.count(semantic.first)
+				&& doc->accessors[semantic.first]->componentType == Accessor::COMPONENT_TYPE_FLOAT
+				&& !doc->accessors.count(semantic.first + ACCESSOR_DECODE_SUFFIX)) {
+				accessorIds.push_back(semantic.first);
+			}
+		}
+
+		std::sort(accessorIds.begin(), accessorIds.end());
+
+		std::vector<QuantizeJob> jobs(accessorIds.size());
+		for (size_t j = 0; j < jobs.size(); ++j) {
+			QuantizeJob& job = jobs[j];
+			if (!GetAccessorData(*doc, accessorIds[j], &job.data, outErr)) {
+				return false;
+			}
+
+			job.report.accessor = accessorIds[j];
+			job.report.semantic = semantics[accessorIds[j]];
+			job.report.byteLengthBefore = job.data.count * GetComponentCount(job.data.type) * sizeof(float);
+			job.type = job.data.type;
+		}
+
+		ParallelFor(jobs.size(), 1, [&](size_t begin, size_t end) {
+			for (size_t j = begin; j < end; ++j) {
+				RunQuantizeJob(options, &jobs[j]);
+			}
+		});
+
+		// Linear encodings are followed by their decode transform: the offset of every component, then the scale.
+		BufferBuilder builder;
+		std::vector<size_t> views(jobs.size());
+		for (size_t j = 0; j < jobs.size(); ++j) {
+			QuantizeJob& job = jobs[j];
+			if (!job.error.empty()) {
+				outErr = job.error;
+				return false;
+			}
+
+			if (job.report.encoding != QUANTIZE_ENCODING_NONE) {
+				views[j] = builder.AddView(job.encoded.data(), job.encoded.size(), BufferView::TARGET_ARRAY_BUFFER);
+			}
+
+			if (job.report.encoding == QUANTIZE_ENCODING_LINEAR) {
+				std::vector<float> decode(job.report.decodeOffset);
+				decode.insert(decode.end(), job.report.decodeScale.begin(), job.report.decodeScale.end());
+				builder.AddView(decode.data(), decode.size() * sizeof(float), BufferView::TARGET_OTHER);
+			}
+		}
+
+		std::vector<std::string> viewIds;
+		if (builder.GetViewCount()) {
+			viewIds = builder.Commit(doc, "quantized");
+		}
+
+		outReport->clear();
+		for (size_t j = 0; j < jobs.size(); ++j) {
+			QuantizeJob& job = jobs[j];
+			if (job.report.encoding != QUANTIZE_ENCODING_NONE) {
+				Accessor& accessor = *doc->accessors[job.report.accessor];
+				accessor.bufferView = viewIds[views[j]];
+				accessor.byteOffset = 0;
+				accessor.byteStride = 0;
+				accessor.componentType = job.report.componentType;
+				accessor.type = job.type;
+
+				AccessorData data;
+				if (!GetAccessorData(*doc, accessor, &data, outErr) || !ComputeAccessorMinMax(data, &accessor.min, &accessor.max, outErr)) {
+					return false;
+				}
+			}
+
+			if (job.report.encoding == QUANTIZE_ENCODING_LINEAR) {
+				std::unique_ptr<Accessor> decode(new Accessor());
+				decode->bufferView = viewIds[views[j] + 1];
+				decode->count = 2;
+				decode->componentType = Accessor::COMPONENT_TYPE_FLOAT;
+				decode->type = job.type;
+				doc->accessors[job.report.accessor + ACCESSOR_DECODE_SUFFIX] = std::move(decode);
+			}
+
+			outReport->push_back(job.report);
+		}
+
+		return true;
+	}
+}
\ No newline at end of file
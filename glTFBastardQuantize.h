@@ -0,0 +1,99 @@
+/*
+Copyright (c) 2016 Ruben Cashie
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation 
+files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, 
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software 
+is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES 
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE 
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef GLTF_BASTARD_QUANTIZE_H
+#define GLTF_BASTARD_QUANTIZE_H
+
+#include "glTFBastardAccessor.h"
+
+namespace glTFBastard {
+
+	// Encodes a unit vector into two components in [-1, 1] with the octahedral mapping
+	// (Cigolle et al., "A Survey of Efficient Representations for Independent Unit Vectors").
+	void EncodeOctahedral(const float* normal, float* outEncoded);
+
+	// Decodes two octahedral components into a unit vector.
+	void DecodeOctahedral(const float* encoded, float* outNormal);
+
+	enum QuantizeEncoding {
+		// The accessor was left as float because no component type met the error bound.
+		QUANTIZE_ENCODING_NONE,
+
+		// Unsigned integers; each component decodes as decodeOffset + value * decodeScale. The transform is also stored
+		// in the document as the decode accessor of the accessor; see GetAccessorDecode.
+		QUANTIZE_ENCODING_LINEAR,
+
+		// A VEC2 of signed integers that decode as value / 127 or value / 32767 followed by DecodeOctahedral.
+		QUANTIZE_ENCODING_OCTAHEDRAL
+	};
+
+	struct QuantizeOptions {
+		// The largest error allowed for POSITION components, relative to the largest extent of the accessor.
+		float maxPositionError;
+
+		// The largest angle in radians allowed between a NORMAL and its decoded value.
+		float maxNormalError;
+
+		// The largest error allowed for TEXCOORD components, relative to the largest extent of the accessor.
+		float maxTexCoordError;
+
+		QuantizeOptions() :
+			maxPositionError(0.0005f),
+			maxNormalError(0.01f),
+			maxTexCoordError(0.0005f) {
+		}
+	};
+
+	// How one accessor was encoded.
+	struct QuantizeReport {
+		std::string accessor;
+		std::string semantic;
+		QuantizeEncoding encoding;
+		Accessor::ComponentType componentType;
+
+		// The size of the tightly packed elements before and after.
+		size_t byteLengthBefore;
+		size_t byteLengthAfter;
+
+		// The largest difference between a decoded and an original component, or the largest angle for normals.
+		float maxError;
+
+		// The per-component decode transform of linear encodings.
+		std::vector<float> decodeOffset;
+		std::vector<float> decodeScale;
+
+		QuantizeReport() :
+			encoding(QUANTIZE_ENCODING_NONE),
+			componentType(Accessor::COMPONENT_TYPE_FLOAT),
+			byteLengthBefore(0),
+			byteLengthAfter(0),
+			maxError(0.0f) {
+		}
+	};
+
+	// Quantizes the float POSITION, NORMAL and TEXCOORD_n accessors of every primitive: positions and texture
+	// coordinates to UNSIGNED_BYTE or UNSIGNED_SHORT with a per-component decode transform, normals to octahedral
+	// BYTE or SHORT pairs. The smallest component type that meets the error bound of the semantic is used.
+	// glTF 1.0 has no normalized accessors, so the decode transform of linear encodings is added to the document as
+	// an "<accessor id>_decode" accessor that GetAccessorDecode reads, and which shaders have to apply; the min/max of
+	// a quantized accessor hold its integer range. The accessors are rewritten in place to refer to a new buffer.
+	// Accessors are encoded in parallel; accessors used with more than one semantic, or whose decode accessor id is
+	// already taken, are left alone.
+	// The buffers of every attribute must have been loaded.
+	bool QuantizeAttributes(glTF* doc, const QuantizeOptions& options, std::vector<QuantizeReport>* outReport, std::string& outErr);
+}
+
+#endif
\ No newline at end of file
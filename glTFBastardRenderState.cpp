@@ -0,0 +1,305 @@
+/*
+Copyright (c) 2016 Ruben Cashie
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation 
+files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, 
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software 
+is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES 
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE 
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include "glTFBastardBufferCache.h"
+#include "glTFBastardRenderState.h"
+
+namespace glTFBastard {
+
+	// Assigns compact ids, from 1 up, to document ids paired with the parts of a description of their content, in
+	// order of their document ids. Ids with equal contents share the compact id of the first of them.
+	static void AssignCompactIds(
+		const std::vector<std::pair<std::string, std::vector<std::string>>>& contents,
+		std::vector<std::string>* outStates,
+		std::unordered_map<std::string, uint32_t>* outIds) {
+
+		outStates->assign(1, std::string());
+		outIds->clear();
+		(*outIds)[std::string()] = 0;
+
+		std::map<std::vector<std::string>, uint32_t> contentIds;
+		for (const auto& entry : contents) {
+			auto inserted = contentIds.insert(std::make_pair(entry.second, static_cast<uint32_t>(outStates->size())));
+			if (inserted.second) {
+				outStates->push_back(entry.first);
+			}
+
+			(*outIds)[entry.first] = inserted.first->second;
+		}
+	}
+
+	// Assigns compact ids to document ids that are distinct by id.
+	static void AssignCompactIds(
+		const std::set<std::string>& ids,
+		std::vector<std::string>* outStates,
+		std::unordered_map<std::string, uint32_t>* outIds) {
+
+		std::vector<std::pair<std::string, std::vector<std::string>>> contents;
+		for (const std::string& id : ids) {
+			contents.push_back(std::make_pair(id, std::vector<std::string>(1, id)));
+		}
+
+		AssignCompactIds(contents, outStates, outIds);
+	}
+
+	// Describes the content of a shader by its type and a hash of its source. Shaders whose source can not be read
+	// are described by their uri instead, or by their id if they have no uri.
+	static std::vector<std::string> GetShaderContent(const Shader& shader, const std::string& shaderId, const std::string& baseDirectory) {
+		std::vector<std::string> content(1, std::to_string(shader.type));
+		if (shader.uri.empty()) {
+			content.push_back("id");
+			content.push_back(shaderId);
+			return content;
+		}
+
+		BufferContents source = ReadUriContents(baseDirectory, shader.uri);
+		if (!source.data) {
+			content.push_back("uri");
+			content.push_back(shader.uri);
+			return content;
+		}
+
+		content.push_back("source");
+		content.push_back(std::to_string(HashBufferContents(source.data.get(), source.size)));
+		return content;
+	}
+
+	bool BuildRenderStates(const glTF& doc, const FlatScene& scene, const std::string& baseDirectory, RenderStates* out, std::string& outErr) {
+		*out = RenderStates();
+
+		// Gather the meshes and materials of the scene.
+		std::set<std::string> meshIds;
+		std::set<std::string> materialIds;
+		for (uint32_t n = 0; n < scene.GetCount(); ++n) {
+			for (const std::string& meshId : scene.nodes[n]->meshes) {
+				if (!meshIds.insert(meshId).second) {
+					continue;
+				}
+
+				auto mesh = doc.meshes.find(meshId);
+				if (mesh == doc.meshes.end()) {
+					outErr = "The mesh '" + meshId + "' does not exist.";
+					return false;
+				}
+
+				if (mesh->second->primitives.size() > (size_t(1) << SORT_KEY_PRIMITIVE_BITS)) {
+					outErr = "The mesh '" + meshId + "' has more primitives than a sort key can hold.";
+					return false;
+				}
+
+				for (const auto& primitive : mesh->second->primitives) {
+					if (!primitive->material.empty()) {
+						materialIds.insert(primitive->material);
+					}
+				}
+			}
+		}
+
+		// Follow the references of each layer to the next one.
+		std::set<std::string> techniqueIds;
+		for (const std::string& materialId : materialIds) {
+			auto material = doc.materials.find(materialId);
+			if (material == doc.materials.end()) {
+				outErr = "The material '" + materialId + "' does not exist.";
+				return false;
+			}
+
+			if (!material->second->technique.empty()) {
+				techniqueIds.insert(material->second->technique);
+			}
+		}
+
+		std::set<std::string> programIds;
+		for (const std::string& techniqueId : techniqueIds) {
+			auto technique = doc.techniques.find(techniqueId);
+			if (technique == doc.techniques.end()) {
+				outErr = "The technique '" + techniqueId + "' does not exist.";
+				return false;
+			}
+
+			if (!technique->second->program.empty()) {
+				programIds.insert(technique->second->program);
+			}
+		}
+
+		std::set<std::string> shaderIds;
+		for (const std::string& programId : programIds) {
+			auto program = doc.programs.find(programId);
+			if (program == doc.programs.end()) {
+				outErr = "The program '" + programId + "' does not exist.";
+				return false;
+			}
+
+			for (const std::string* shaderId : {&program->second->vertexShader, &program->second->fragmentShader}) {
+				if (!shaderId->empty()) {
+					shaderIds.insert(*shaderId);
+				}
+			}
+		}
+
+		// Deduplicate shaders by content, then programs by the compact ids of their shaders and their attributes.
+		std::vector<std::pair<std::string, std::vector<std::string>>> shaderContents;
+		for (const std::string& shaderId : shaderIds) {
+			auto shader = doc.shaders.find(shaderId);
+			if (shader == doc.shaders.end()) {
+				outErr = "The shader '" + shaderId + "' does not exist.";
+				return false;
+			}
+
+			shaderContents.push_back(std::make_pair(shaderId, GetShaderContent(*shader->second, shaderId, baseDirectory)));
+		}
+
+		AssignCompactIds(shaderContents, &out->shaders, &out->shaderIds);
+
+		std::vector<std::pair<std::string, std::vector<std::string>>> programContents;
+		for (const std::string& programId : programIds) {
+			const Program& program = *doc.programs.find(programId)->second;
+			std::vector<std::string> content;
+			content.push_back(std::to_string(out->shaderIds[program.vertexShader]));
+			content.push_back(std::to_string(out->shaderIds[program.fragmentShader]));
+			content.insert(content.end(), program.attributes.begin(), program.attributes.end());
+
+			programContents.push_back(std::make_pair(programId, content));
+		}
+
+		AssignCompactIds(programContents, &out->programs, &out->programIds);
+		AssignCompactIds(techniqueIds, &out->techniques, &out->techniqueIds);
+		AssignCompactIds(materialIds, &out->materials, &out->materialIds);
+
+		for (const std::string& meshId : meshIds) {
+			out->meshIds[meshId] = static_cast<uint32_t>(out->meshes.size());
+			out->meshes.push_back(meshId);
+		}
+
+		const struct {
+			size_t count;
+			uint32_t bits;
+			const char* name;
+		} layers[] = {
+			{out->programs.size(), SORT_KEY_PROGRAM_BITS, "programs"},
+			{out->techniques.size(), SORT_KEY_TECHNIQUE_BITS, "techniques"},
+			{out->materials.size(), SORT_KEY_MATERIAL_BITS, "materials"},
+			{out->meshes.size(), SORT_KEY_MESH_BITS, "meshes"}
+		};
+
+		for (const auto& layer : layers) {
+			if (layer.count > (size_t(1) << layer.bits)) {
+				outErr = std::string("The scene has more distinct ") + layer.name + " than a sort key can hold.";
+				return false;
+			}
+		}
+
+		// Compute the key of every draw.
+		std::vector<uint64_t> states;
+		for (uint32_t n = 0; n < scene.GetCount(); ++n) {
+			for (const std::string& meshId : scene.nodes[n]->meshes) {
+				uint32_t mesh = out->meshIds[meshId];
+				const std::vector<std::unique_ptr<Mesh::Primitive>>& primitives = doc.meshes.find(meshId)->second->primitives;
+				for (uint32_t p = 0; p < primitives.size(); ++p) {
+					uint32_t material = out->materialIds[primitives[p]->material];
+					uint32_t technique = 0;
+					uint32_t program = 0;
+					if (material) {
+						const std::string& techniqueId = doc.materials.find(primitives[p]->material)->second->technique;
+						technique = out->techniqueIds[techniqueId];
+						if (technique) {
+							program = out->programIds[doc.techniques.find(techniqueId)->second->program];
+						}
+					}
+
+					DrawKey draw;
+					draw.key = MakeSortKey(program, technique, material, mesh, p);
+					draw.node = n;
+					draw.mesh = mesh;
+					draw.primitive = p;
+					out->draws.push_back(draw);
+					states.push_back(draw.key >> SORT_KEY_MATERIAL_SHIFT);
+				}
+			}
+		}
+
+		std::sort(states.begin(), states.end());
+		out->stateCount = std::unique(states.begin(), states.end()) - states.begin();
+		return true;
+	}
+
+	void SortDrawKeys(std::vector<DrawKey>* draws) {
+		if (draws->size() < 2) {
+			return;
+		}
+
+		// Count every byte of every key in one pass.
+		std::vector<size_t> counts(8 * 256, 0);
+		for (const DrawKey& draw : *draws) {
+			for (size_t byte = 0; byte < 8; ++byte) {
+				++counts[byte * 256 + ((draw.key >> (byte * 8)) & 0xff)];
+			}
+		}
+
+		std::vector<DrawKey> scratch(draws->size());
+		for (size_t byte = 0; byte < 8; ++byte) {
+			size_t* byteCounts = &counts[byte * 256];
+			size_t shift = byte * 8;
+			if (byteCounts[(draws->front().key >> shift) & 0xff] == draws->size()) {
+				continue;
+			}
+
+			size_t offset = 0;
+			for (size_t digit = 0; digit < 256; ++digit) {
+				size_t count = byteCounts[digit];
+				byteCounts[digit] = offset;
+				offset += count;
+			}
+
+			for (const DrawKey& draw : *draws) {
+				scratch[byteCounts[(draw.key >> shift) & 0xff]++] = draw;
+			}
+
+			draws->swap(scratch);
+		}
+	}
+
+	StateChangeCounts CountStateChanges(const std::vector<DrawKey>& draws) {
+		StateChangeCounts counts;
+		for (size_t i = 0; i < draws.size(); ++i) {
+			uint64_t key = draws[i].key;
+			uint64_t previous = i ? draws[i - 1].key : ~key;
+
+			// Switching a layer also switches every layer below it.
+			if ((key ^ previous) >> SORT_KEY_PROGRAM_SHIFT) {
+				++counts.programs;
+			}
+
+			if ((key ^ previous) >> SORT_KEY_TECHNIQUE_SHIFT) {
+				++counts.techniques;
+			}
+
+			if ((key ^ previous) >> SORT_KEY_MATERIAL_SHIFT) {
+				++counts.materials;
+			}
+
+			// Vertex buffers only change with the mesh, whatever the material.
+			if (GetSortKeyField(key ^ previous, SORT_KEY_MESH_SHIFT, SORT_KEY_MESH_BITS)) {
+				++counts.meshes;
+			}
+		}
+
+		return counts;
+	}
+}
\ No newline at end of file
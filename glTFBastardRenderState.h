@@ -0,0 +1,122 @@
+/*
+Copyright (c) 2016 Ruben Cashie
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation 
+files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, 
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software 
+is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES 
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE 
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef GLTF_BASTARD_RENDER_STATE_H
+#define GLTF_BASTARD_RENDER_STATE_H
+
+#include <cstdint>
+#include "glTFBastardSceneGraph.h"
+
+namespace glTFBastard {
+
+	// The fields of a draw sort key, from the least significant bit up: primitive, mesh, material, technique and
+	// program. Sorting by key groups draws by program first, as switching programs costs the most, and by mesh last
+	// so that draws of the same mesh share vertex buffers.
+	static const uint32_t SORT_KEY_PRIMITIVE_BITS = 8;
+	static const uint32_t SORT_KEY_MESH_BITS = 16;
+	static const uint32_t SORT_KEY_MATERIAL_BITS = 16;
+	static const uint32_t SORT_KEY_TECHNIQUE_BITS = 12;
+	static const uint32_t SORT_KEY_PROGRAM_BITS = 12;
+
+	static const uint32_t SORT_KEY_MESH_SHIFT = SORT_KEY_PRIMITIVE_BITS;
+	static const uint32_t SORT_KEY_MATERIAL_SHIFT = SORT_KEY_MESH_SHIFT + SORT_KEY_MESH_BITS;
+	static const uint32_t SORT_KEY_TECHNIQUE_SHIFT = SORT_KEY_MATERIAL_SHIFT + SORT_KEY_MATERIAL_BITS;
+	static const uint32_t SORT_KEY_PROGRAM_SHIFT = SORT_KEY_TECHNIQUE_SHIFT + SORT_KEY_TECHNIQUE_BITS;
+
+	// Packs compact state ids into a sort key; every id must fit in the bits of its field.
+	inline uint64_t MakeSortKey(uint32_t program, uint32_t technique, uint32_t material, uint32_t mesh, uint32_t primitive) {
+		return (static_cast<uint64_t>(program) << SORT_KEY_PROGRAM_SHIFT)
+			| (static_cast<uint64_t>(technique) << SORT_KEY_TECHNIQUE_SHIFT)
+			| (static_cast<uint64_t>(material) << SORT_KEY_MATERIAL_SHIFT)
+			| (static_cast<uint64_t>(mesh) << SORT_KEY_MESH_SHIFT)
+			| primitive;
+	}
+
+	// Extracts a field of a sort key.
+	inline uint32_t GetSortKeyField(uint64_t key, uint32_t shift, uint32_t bits) {
+		return static_cast<uint32_t>((key >> shift) & ((uint64_t(1) << bits) - 1));
+	}
+
+	// A primitive of a mesh of a node of a flattened scene.
+	struct DrawKey {
+		uint64_t key;
+		uint32_t node;
+
+		// The compact mesh id and the index into Mesh::primitives, which the key also holds.
+		uint32_t mesh;
+		uint32_t primitive;
+	};
+
+	// The render states of the draws of a scene, with compact ids for each layer of state. Shaders are identical
+	// when their type and source are, whether the source is embedded as a data uri or in a file; shaders whose
+	// source can not be read are identical only when their uris are. Programs are identical when they link
+	// identical shaders with the same attributes. Techniques, materials and meshes are distinct by id.
+	struct RenderStates {
+		// The document id of every distinct state of each layer, by compact id; of identical shaders and programs,
+		// the first in sorted order stands for all of them. Compact id 0 of every layer but meshes is the default
+		// state, with an empty id, which primitives without a material, materials without a technique and so on use.
+		std::vector<std::string> shaders;
+		std::vector<std::string> programs;
+		std::vector<std::string> techniques;
+		std::vector<std::string> materials;
+		std::vector<std::string> meshes;
+
+		// The compact id of every document id the draws refer to, identical ones included; the empty id maps to 0.
+		std::unordered_map<std::string, uint32_t> shaderIds;
+		std::unordered_map<std::string, uint32_t> programIds;
+		std::unordered_map<std::string, uint32_t> techniqueIds;
+		std::unordered_map<std::string, uint32_t> materialIds;
+		std::unordered_map<std::string, uint32_t> meshIds;
+
+		// One draw per primitive of every mesh of every node, in scene order.
+		std::vector<DrawKey> draws;
+
+		// The number of distinct combinations of program, technique and material among the draws.
+		size_t stateCount;
+
+		RenderStates() :
+			stateCount(0) {
+		}
+	};
+
+	// Resolves the material, technique, program and shaders of every primitive of a scene and computes the sort key
+	// of each draw. Fails if a mesh, material, technique, program or shader is missing, or if a layer has more
+	// distinct states than the bits of its field of the sort key can hold. Shader files are read relative to the
+	// base directory, which should be the directory of the document and end in a separator.
+	bool BuildRenderStates(const glTF& doc, const FlatScene& scene, const std::string& baseDirectory, RenderStates* out, std::string& outErr);
+
+	// Sorts draws by key with a stable radix sort, a byte per pass; bytes that every key shares are skipped.
+	void SortDrawKeys(std::vector<DrawKey>* draws);
+
+	// The state changes that submitting draws in order takes; the first draw sets every state.
+	struct StateChangeCounts {
+		size_t programs;
+		size_t techniques;
+		size_t materials;
+		size_t meshes;
+
+		StateChangeCounts() :
+			programs(0),
+			techniques(0),
+			materials(0),
+			meshes(0) {
+		}
+	};
+
+	StateChangeCounts CountStateChanges(const std::vector<DrawKey>& draws);
+}
+
+#endif
\ No newline at end of file
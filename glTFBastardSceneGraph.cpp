@@ -0,0 +1,133 @@
+/*
+Copyright (c) 2016 Ruben Cashie
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation 
+files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, 
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software 
+is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES 
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE 
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "glTFBastardSceneGraph.h"
+#include "glTFBastardMath.h"
+
+namespace glTFBastard {
+
+	// Returns true if a node is the flattened node at index or one of its ancestors.
+	static bool IsAncestor(const FlatScene& scene, uint32_t ancestor, uint32_t index) {
+		for (uint32_t i = index; i != FLAT_SCENE_NO_PARENT; i = scene.parents[i]) {
+			if (i == ancestor) {
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	bool FlattenScene(const glTF& doc, const std::string& sceneId, FlatScene* out, std::string& outErr) {
+		auto scene = doc.scenes.find(sceneId);
+		if (scene == doc.scenes.end()) {
+			*out = FlatScene();
+			outErr = "The scene '" + sceneId + "' does not exist.";
+			return false;
+		}
+
+		return FlattenNodes(doc, scene->second->nodes, out, outErr);
+	}
+
+	bool FlattenNodes(const glTF& doc, const std::vector<std::string>& roots, FlatScene* out, std::string& outErr) {
+		out->ids.clear();
+		out->nodes.clear();
+		out->parents.clear();
+		out->depths.clear();
+		out->subtreeEnds.clear();
+		out->indices.clear();
+		out->indices.reserve(doc.nodes.size());
+
+		// Children are pushed in reverse so that siblings keep their order. A node is popped again once its whole
+		// subtree has been added, which is when the end of its range is known.
+		struct PendingNode {
+			const std::string* id;
+
+			// The parent of the node to add, or the node whose subtree is finished.
+			uint32_t parent;
+			bool finished;
+		};
+
+		std::vector<PendingNode> stack;
+		for (auto root = roots.rbegin(); root != roots.rend(); ++root) {
+			PendingNode pending = {&*root, FLAT_SCENE_NO_PARENT, false};
+			stack.push_back(pending);
+		}
+
+		while (!stack.empty()) {
+			PendingNode pending = stack.back();
+			stack.pop_back();
+
+			if (pending.finished) {
+				out->subtreeEnds[pending.parent] = static_cast<uint32_t>(out->ids.size());
+				continue;
+			}
+
+			auto node = doc.nodes.find(*pending.id);
+			if (node == doc.nodes.end()) {
+				outErr = "The node '" + *pending.id + "' does not exist.";
+				return false;
+			}
+
+			auto existing = out->indices.find(*pending.id);
+			if (existing != out->indices.end()) {
+				if (pending.parent != FLAT_SCENE_NO_PARENT && IsAncestor(*out, existing->second, pending.parent)) {
+					outErr = "The node '" + *pending.id + "' is part of a cycle.";
+				}
+				else {
+					outErr = "The node '" + *pending.id + "' has more than one parent.";
+				}
+
+				return false;
+			}
+
+			uint32_t index = static_cast<uint32_t>(out->ids.size());
+			out->indices[node->first] = index;
+			out->ids.push_back(node->first);
+			out->nodes.push_back(node->second.get());
+			out->parents.push_back(pending.parent);
+			out->depths.push_back(pending.parent == FLAT_SCENE_NO_PARENT ? 0 : out->depths[pending.parent] + 1);
+			out->subtreeEnds.push_back(index + 1);
+
+			PendingNode finished = {nullptr, index, true};
+			stack.push_back(finished);
+
+			const std::vector<std::string>& children = node->second->children;
+			for (auto child = children.rbegin(); child != children.rend(); ++child) {
+				PendingNode childPending = {&*child, index, false};
+				stack.push_back(childPending);
+			}
+		}
+
+		return true;
+	}
+
+	void ComputeWorldMatrices(const FlatScene& scene, std::vector<float>* outWorld) {
+		outWorld->resize(scene.GetCount() * 16);
+
+		float local[16];
+		for (size_t i = 0; i < scene.GetCount(); ++i) {
+			float* world = &(*outWorld)[i * 16];
+			GetNodeMatrix(*scene.nodes[i], local);
+
+			if (scene.parents[i] == FLAT_SCENE_NO_PARENT) {
+				memcpy(world, local, sizeof(local));
+			}
+			else {
+				MultiplyMatrices(&(*outWorld)[scene.parents[i] * 16], local, world);
+			}
+		}
+	}
+}
\ No newline at end of file
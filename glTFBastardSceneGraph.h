@@ -0,0 +1,60 @@
+/*
+Copyright (c) 2016 Ruben Cashie
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation 
+files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, 
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software 
+is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES 
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE 
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef GLTF_BASTARD_SCENE_GRAPH_H
+#define GLTF_BASTARD_SCENE_GRAPH_H
+
+#include <cstdint>
+#include "glTFBastard.h"
+
+namespace glTFBastard {
+
+	// The parent index of root nodes.
+	static const uint32_t FLAT_SCENE_NO_PARENT = 0xffffffff;
+
+	// The nodes of a scene in depth first order, so that every parent comes before its children and every subtree
+	// is a contiguous range. Each array has one entry per node.
+	// The Node pointers stay valid until nodes are added to or removed from the document.
+	struct FlatScene {
+		std::vector<std::string> ids;
+		std::vector<const Node*> nodes;
+		std::vector<uint32_t> parents;
+
+		// Roots have a depth of zero.
+		std::vector<uint32_t> depths;
+
+		// The subtree of node i is [i, subtreeEnds[i]).
+		std::vector<uint32_t> subtreeEnds;
+
+		std::unordered_map<std::string, uint32_t> indices;
+
+		size_t GetCount() const {
+			return ids.size();
+		}
+	};
+
+	// Flattens the hierarchy reachable from the roots of a scene. Fails if a node is missing, is part of a cycle or
+	// has more than one parent, counting the scene as the parent of its roots.
+	bool FlattenScene(const glTF& doc, const std::string& sceneId, FlatScene* out, std::string& outErr);
+
+	// Flattens the hierarchies below a list of root nodes, which count as having a common parent; see above.
+	bool FlattenNodes(const glTF& doc, const std::vector<std::string>& roots, FlatScene* out, std::string& outErr);
+
+	// Computes the world matrix of every node of a flattened scene in one pass, as 16 floats per node.
+	void ComputeWorldMatrices(const FlatScene& scene, std::vector<float>* outWorld);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,118 @@
+/*
+Copyright (c) 2016 Ruben Cashie
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation 
+files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, 
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software 
+is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES 
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE 
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef GLTF_BASTARD_SIMD_H
+#define GLTF_BASTARD_SIMD_H
+
+// Selects the x86 vector instruction sets that the library is being compiled for.
+// Wider sets imply the narrower ones, so GLTF_BASTARD_AVX2 comes with GLTF_BASTARD_SSE41 and GLTF_BASTARD_SSE2.
+// None of them are defined on other architectures, where the scalar paths are used.
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define GLTF_BASTARD_AVX2
+#define GLTF_BASTARD_SSE41
+#define GLTF_BASTARD_SSE2
+#elif defined(__SSE4_1__)
+#include <smmintrin.h>
+#define GLTF_BASTARD_SSE41
+#define GLTF_BASTARD_SSE2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define GLTF_BASTARD_SSE2
+#endif
+
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include "glTFBastardMath.h"
+
+// Building blocks shared by the vectorized modules.
+namespace glTFBastard {
+
+	// Allocates arrays aligned to 64 bytes, so that elements of that size never straddle cache lines and vectors of
+	// them can be loaded and stored aligned.
+	template<typename T> struct CacheLineAllocator {
+		typedef T value_type;
+
+		CacheLineAllocator() {
+		}
+
+		template<typename U> CacheLineAllocator(const CacheLineAllocator<U>&) {
+		}
+
+		T* allocate(size_t count) {
+			// The address returned by malloc is stored just before the aligned block.
+			void* raw = malloc(count * sizeof(T) + 64 + sizeof(void*));
+			if (!raw) {
+				throw std::bad_alloc();
+			}
+
+			uintptr_t aligned = (reinterpret_cast<uintptr_t>(raw) + sizeof(void*) + 63) & ~static_cast<uintptr_t>(63);
+			reinterpret_cast<void**>(aligned)[-1] = raw;
+			return reinterpret_cast<T*>(aligned);
+		}
+
+		void deallocate(T* pointer, size_t) {
+			free(reinterpret_cast<void**>(pointer)[-1]);
+		}
+
+		template<typename U> bool operator==(const CacheLineAllocator<U>&) const {
+			return true;
+		}
+
+		template<typename U> bool operator!=(const CacheLineAllocator<U>&) const {
+			return false;
+		}
+	};
+
+	// out = a * b; out may not alias a or b. Each column of out is the columns of a weighted by a column of b.
+	inline void MultiplyMatricesVector(const float* a, const float* b, float* out) {
+#if defined(GLTF_BASTARD_AVX2)
+		// Two columns of out at a time, one per 128 bit half.
+		__m256 a0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(a));
+		__m256 a1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(a + 4));
+		__m256 a2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(a + 8));
+		__m256 a3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(a + 12));
+
+		for (size_t column = 0; column < 4; column += 2) {
+			__m256 bColumns = _mm256_loadu_ps(b + column * 4);
+			__m256 result = _mm256_mul_ps(a0, _mm256_permute_ps(bColumns, 0x00));
+			result = _mm256_add_ps(result, _mm256_mul_ps(a1, _mm256_permute_ps(bColumns, 0x55)));
+			result = _mm256_add_ps(result, _mm256_mul_ps(a2, _mm256_permute_ps(bColumns, 0xaa)));
+			result = _mm256_add_ps(result, _mm256_mul_ps(a3, _mm256_permute_ps(bColumns, 0xff)));
+			_mm256_storeu_ps(out + column * 4, result);
+		}
+#elif defined(GLTF_BASTARD_SSE2)
+		__m128 a0 = _mm_loadu_ps(a);
+		__m128 a1 = _mm_loadu_ps(a + 4);
+		__m128 a2 = _mm_loadu_ps(a + 8);
+		__m128 a3 = _mm_loadu_ps(a + 12);
+
+		for (size_t column = 0; column < 4; ++column) {
+			__m128 bColumn = _mm_loadu_ps(b + column * 4);
+			__m128 result = _mm_mul_ps(a0, _mm_shuffle_ps(bColumn, bColumn, 0x00));
+			result = _mm_add_ps(result, _mm_mul_ps(a1, _mm_shuffle_ps(bColumn, bColumn, 0x55)));
+			result = _mm_add_ps(result, _mm_mul_ps(a2, _mm_shuffle_ps(bColumn, bColumn, 0xaa)));
+			result = _mm_add_ps(result, _mm_mul_ps(a3, _mm_shuffle_ps(bColumn, bColumn, 0xff)));
+			_mm_storeu_ps(out + column * 4, result);
+		}
+#else
+		MultiplyMatrices(a, b, out);
+#endif
+	}
+}
+
+#endif
\ No newline at end of file
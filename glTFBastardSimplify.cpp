@@ -0,0 +1,548 @@
+/*
+Copyright (c) 2016 Ruben Cashie
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation 
+files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, 
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software 
+is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES 
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE 
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include "glTFBastardBuilder.h"
+#include "glTFBastardConvert.h"
+#include "glTFBastardParallel.h"
+#include "glTFBastardSimplify.h"
+#include "glTFBastardTopology.h"
+
+namespace glTFBastard {
+
+	// The sum of squared distances to a set of weighted planes: p'Ap + 2b'p + c.
+	struct Quadric {
+		double a00, a01, a02, a11, a12, a22;
+		double b0, b1, b2;
+		double c;
+		double weight;
+
+		Quadric() :
+			a00(0.0), a01(0.0), a02(0.0), a11(0.0), a12(0.0), a22(0.0),
+			b0(0.0), b1(0.0), b2(0.0),
+			c(0.0),
+			weight(0.0) {
+		}
+
+		void AddPlane(const double* normal, double d, double planeWeight) {
+			a00 += planeWeight * normal[0] * normal[0];
+			a01 += planeWeight * normal[0] * normal[1];
+			a02 += planeWeight * normal[0] * normal[2];
+			a11 += planeWeight * normal[1] * normal[1];
+			a12 += planeWeight * normal[1] * normal[2];
+			a22 += planeWeight * normal[2] * normal[2];
+			b0 += planeWeight * d * normal[0];
+			b1 += planeWeight * d * normal[1];
+			b2 += planeWeight * d * normal[2];
+			c += planeWeight * d * d;
+			weight += planeWeight;
+		}
+
+		void Add(const Quadric& other) {
+			a00 += other.a00;
+			a01 += other.a01;
+			a02 += other.a02;
+			a11 += other.a11;
+			a12 += other.a12;
+			a22 += other.a22;
+			b0 += other.b0;
+			b1 += other.b1;
+			b2 += other.b2;
+			c += other.c;
+			weight += other.weight;
+		}
+
+		double Evaluate(double x, double y, double z) const {
+			double result = a00 * x * x + a11 * y * y + a22 * z * z
+				+ 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z)
+				+ 2.0 * (b0 * x + b1 * y + b2 * z)
+				+ c;
+
+			return std::max(result, 0.0);
+		}
+	};
+
+	// A candidate collapse of vertex 'from' onto vertex 'to'.
+	struct Collapse {
+		uint32_t from;
+		uint32_t to;
+		double error;
+
+		bool operator<(const Collapse& other) const {
+			return error < other.error;
+		}
+	};
+
+	static void GetTriangleNormal(const float* const* positions, uint32_t a, uint32_t b, uint32_t c, double* out) {
+		double e1[3];
+		double e2[3];
+		for (size_t axis = 0; axis < 3; ++axis) {
+			e1[axis] = static_cast<double>(positions[axis][b]) - positions[axis][a];
+			e2[axis] = static_cast<double>(positions[axis][c]) - positions[axis][a];
+		}
+
+		out[0] = e1[1] * e2[2] - e1[2] * e2[1];
+		out[1] = e1[2] * e2[0] - e1[0] * e2[2];
+		out[2] = e1[0] * e2[1] - e1[1] * e2[0];
+	}
+
+	// Marks the vertices that must not move: those that share a position with another vertex and those on an edge
+	// that is not shared by exactly two triangles.
+	static void FindLockedVertices(
+		const std::vector<uint32_t>& indices,
+		const float* const* positions,
+		size_t vertexCount,
+		std::vector<char>* outLocked) {
+
+		// Group the referenced vertices by position.
+		std::vector<uint32_t> sorted;
+		std::vector<char> referenced(vertexCount, 0);
+		for (uint32_t index : indices) {
+			if (!referenced[index]) {
+				referenced[index] = 1;
+				sorted.push_back(index);
+			}
+		}
+
+		auto lessPosition = [&](uint32_t a, uint32_t b) {
+			for (size_t axis = 0; axis < 3; ++axis) {
+				if (positions[axis][a] != positions[axis][b]) {
+					return positions[axis][a] < positions[axis][b];
+				}
+			}
+
+			return false;
+		};
+
+		std::sort(sorted.begin(), sorted.end(), lessPosition);
+
+		std::vector<uint32_t> positionIds(vertexCount, 0);
+		outLocked->assign(vertexCount, 0);
+		for (size_t i = 0; i < sorted.size();) {
+			size_t end = i + 1;
+			while (end < sorted.size() && !lessPosition(sorted[i], sorted[end])) {
+				++end;
+			}
+
+			for (size_t j = i; j < end; ++j) {
+				positionIds[sorted[j]] = sorted[i];
+				(*outLocked)[sorted[j]] = end - i > 1;
+			}
+
+			i = end;
+		}
+
+		// Count the triangles on each undirected edge between positions.
+		std::unordered_map<uint64_t, uint32_t> edgeUses;
+		for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+			for (size_t corner = 0; corner < 3; ++corner) {
+				uint64_t a = positionIds[indices[i + corner]];
+				uint64_t b = positionIds[indices[i + (corner + 1) % 3]];
+				++edgeUses[a < b ? (a << 32) | b : (b << 32) | a];
+			}
+		}
+
+		std::vector<char> lockedPositions(vertexCount, 0);
+		for (auto& edge : edgeUses) {
+			if (edge.second != 2) {
+				lockedPositions[edge.first >> 32] = 1;
+				lockedPositions[edge.first & 0xFFFFFFFF] = 1;
+			}
+		}
+
+		for (uint32_t vertex : sorted) {
+			(*outLocked)[vertex] = (*outLocked)[vertex] || lockedPositions[positionIds[vertex]];
+		}
+	}
+
+	// Simplifies a triangle list with quadric error metric edge collapses.
+	size_t SimplifyTriangles(
+		const uint32_t* indices,
+		size_t indexCount,
+		const float* const* positions,
+		size_t vertexCount,
+		size_t targetIndexCount,
+		float maxError,
+		uint32_t* outIndices,
+		float* outError) {
+
+		std::vector<uint32_t> current(indices, indices + indexCount - indexCount % 3);
+		float resultError = 0.0f;
+
+		// Errors are measured relative to the largest dimension of the bounding box.
+		double extent = 0.0;
+		if (!current.empty()) {
+			for (size_t axis = 0; axis < 3; ++axis) {
+				float minimum = positions[axis][current[0]];
+				float maximum = minimum;
+				for (uint32_t index : current) {
+					minimum = std::min(minimum, positions[axis][index]);
+					maximum = std::max(maximum, positions[axis][index]);
+				}
+
+				extent = std::max(extent, static_cast<double>(maximum) - minimum);
+			}
+		}
+
+		double maxErrorSquared = static_cast<double>(maxError) * maxError * extent * extent;
+
+		std::vector<char> locked;
+		FindLockedVertices(current, positions, vertexCount, &locked);
+
+		// Every vertex starts out with the planes of its triangles, weighted by area.
+		std::vector<Quadric> quadrics(vertexCount);
+		for (size_t i = 0; i < current.size(); i += 3) {
+			double normal[3];
+			GetTriangleNormal(positions, current[i], current[i + 1], current[i + 2], normal);
+
+			double length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+			if (length == 0.0) {
+				continue;
+			}
+
+			for (size_t axis = 0; axis < 3; ++axis) {
+				normal[axis] /= length;
+			}
+
+			double d = -(normal[0] * positions[0][current[i]] + normal[1] * positions[1][current[i]] + normal[2] * positions[2][current[i]]);
+			for (size_t corner = 0; corner < 3; ++corner) {
+				quadrics[current[i + corner]].AddPlane(normal, d, length * 0.5);
+			}
+		}
+
+		std::vector<Collapse> collapses;
+		std::vector<uint32_t> adjacencyOffsets;
+		std::vector<uint32_t> adjacency;
+		std::vector<char> touched(vertexCount);
+		std::vector<uint32_t> collapseTo(vertexCount);
+
+		// Each pass collapses the cheapest edges whose neighbourhoods do not overlap.
+		while (current.size() > targetIndexCount) {
+			collapses.clear();
+			for (size_t i = 0; i < current.size(); i += 3) {
+				for (size_t corner = 0; corner < 3; ++corner) {
+					uint32_t a = current[i + corner];
+					uint32_t b = current[i + (corner + 1) % 3];
+					Quadric quadric = quadrics[a];
+					quadric.Add(quadrics[b]);
+
+					double weight = quadric.weight > 0.0 ? quadric.weight : 1.0;
+					if (!locked[a]) {
+						Collapse collapse = {a, b, quadric.Evaluate(positions[0][b], positions[1][b], positions[2][b]) / weight};
+						collapses.push_back(collapse);
+					}
+
+					if (!locked[b]) {
+						Collapse collapse = {b, a, quadric.Evaluate(positions[0][a], positions[1][a], positions[2][a]) / weight};
+						collapses.push_back(collapse);
+					}
+				}
+			}
+
+			std::sort(collapses.begin(), collapses.end());
+
+			adjacencyOffsets.assign(vertexCount + 1, 0);
+			for (uint32_t index : current) {
+				++adjacencyOffsets[index + 1];
+			}
+
+			for (size_t v = 0; v < vertexCount; ++v) {
+				adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+			}
+
+			adjacency.resize(current.size());
+			{
+				std::vector<uint32_t> cursor(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+				for (size_t i = 0; i < current.size(); ++i) {
+					adjacency[cursor[current[i]]++] = static_cast<uint32_t>(i / 3);
+				}
+			}
+
+			std::fill(touched.begin(), touched.end(), 0);
+			for (size_t v = 0; v < vertexCount; ++v) {
+				collapseTo[v] = static_cast<uint32_t>(v);
+			}
+
+			size_t triangleCount = current.size() / 3;
+			size_t targetTriangleCount = targetIndexCount / 3;
+			size_t collapsed = 0;
+
+			for (const Collapse& collapse : collapses) {
+				if (collapse.error > maxErrorSquared || triangleCount <= targetTriangleCount) {
+					break;
+				}
+
+				if (touched[collapse.from] || touched[collapse.to]) {
+					continue;
+				}
+
+				// Reject collapses that flip a triangle that stays or turn it by more than about 75 degrees, which
+				// also keeps slivers from flipping in later passes.
+				bool flips = false;
+				size_t removed = 0;
+				for (uint32_t a = adjacencyOffsets[collapse.from]; a < adjacencyOffsets[collapse.from + 1] && !flips; ++a) {
+					const uint32_t* triangle = &current[adjacency[a] * 3];
+					if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to) {
+						++removed;
+						continue;
+					}
+
+					uint32_t moved[3];
+					for (size_t corner = 0; corner < 3; ++corner) {
+						moved[corner] = triangle[corner] == collapse.from ? collapse.to : triangle[corner];
+					}
+
+					double before[3];
+					double after[3];
+					GetTriangleNormal(positions, triangle[0], triangle[1], triangle[2], before);
+					GetTriangleNormal(positions, moved[0], moved[1], moved[2], after);
+					double dot = before[0] * after[0] + before[1] * after[1] + before[2] * after[2];
+					double lengths = std::sqrt((before[0] * before[0] + before[1] * before[1] + before[2] * before[2])
+						* (after[0] * after[0] + after[1] * after[1] + after[2] * after[2]));
+					flips = dot <= 0.25 * lengths;
+				}
+
+				if (flips) {
+					continue;
+				}
+
+				collapseTo[collapse.from] = collapse.to;
+				quadrics[collapse.to].Add(quadrics[collapse.from]);
+				resultError = std::max(resultError, static_cast<float>(std::sqrt(collapse.error) / (extent > 0.0 ? extent : 1.0)));
+
+				// Keep the rest of this pass away from the triangles that changed.
+				for (uint32_t a = adjacencyOffsets[collapse.from]; a < adjacencyOffsets[collapse.from + 1]; ++a) {
+					for (size_t corner = 0; corner < 3; ++corner) {
+						touched[current[adjacency[a] * 3 + corner]] = 1;
+					}
+				}
+
+				triangleCount -= removed;
+				++collapsed;
+			}
+
+			if (!collapsed) {
+				break;
+			}
+
+			// Apply the collapses and drop the triangles that became degenerate.
+			size_t write = 0;
+			for (size_t i = 0; i < current.size(); i += 3) {
+				uint32_t a = collapseTo[current[i]];
+				uint32_t b = collapseTo[current[i + 1]];
+				uint32_t c = collapseTo[current[i + 2]];
+				if (a == b || b == c || c == a) {
+					continue;
+				}
+
+				current[write++] = a;
+				current[write++] = b;
+				current[write++] = c;
+			}
+
+			current.resize(write);
+		}
+
+		if (!current.empty()) {
+			memcpy(outIndices, current.data(), current.size() * sizeof(uint32_t));
+		}
+
+		if (outError) {
+			*outError = resultError;
+		}
+
+		return current.size();
+	}
+
+	// The work and results for a single primitive.
+	struct SimplifyJob {
+		const Mesh::Primitive* primitive;
+		AccessorData positionData;
+		std::vector<float> positionOffset;
+		std::vector<float> positionScale;
+		size_t triangleCount;
+		std::vector<std::vector<uint32_t>> lods;
+		std::string error;
+	};
+
+	// Simplifies a single primitive into every level without touching the document.
+	static void RunSimplifyJob(const glTF& doc, const SimplifyOptions& options, SimplifyJob* job) {
+		IndexList list;
+		if (!ConvertPrimitiveToList(doc, *job->primitive, Accessor::COMPONENT_TYPE_UNSIGNED_INT, &list, job->error)) {
+			return;
+		}
+
+		std::vector<uint32_t> indices(list.count);
+		if (list.count) {
+			memcpy(indices.data(), list.data.data(), list.count * sizeof(uint32_t));
+		}
+
+		size_t vertexCount = job->positionData.count;
+		for (uint32_t index : indices) {
+			if (index >= vertexCount) {
+				job->error = "An index is out of the range of the POSITION attribute.";
+				return;
+			}
+		}
+
+		std::vector<float> positions(vertexCount * 3);
+		float* components[3] = {positions.data(), positions.data() + vertexCount, positions.data() + vertexCount * 2};
+		if (!ConvertAccessorToSoA(job->positionData, false, components, job->error)) {
+			return;
+		}
+
+		DecodeComponents(job->positionOffset, job->positionScale, vertexCount, components);
+
+		job->triangleCount = indices.size() / 3;
+		for (float ratio : options.ratios) {
+			size_t targetIndexCount = static_cast<size_t>(job->triangleCount * static_cast<double>(ratio)) * 3;
+			std::vector<uint32_t> lod(indices.size());
+			lod.resize(SimplifyTriangles(
+				indices.data(), indices.size(), components, vertexCount, targetIndexCount, options.maxError, lod.data(), nullptr));
+
+			job->lods.push_back(lod);
+			indices.swap(lod);
+		}
+	}
+
+	// Generates a chain of levels of detail for every mesh in the document.
+	bool SimplifyMeshes(glTF* doc, const SimplifyOptions& options, std::vector<SimplifyReport>* outReport, std::string& outErr) {
+		std::vector<std::string> meshIds;
+		for (auto& mesh : doc->meshes) {
+			meshIds.push_back(mesh.first);
+		}
+
+		std::sort(meshIds.begin(), meshIds.end());
+
+		// One job per triangle primitive; jobIndices maps every primitive of every mesh to its job, if any.
+		std::vector<SimplifyJob> jobs;
+		std::vector<std::vector<size_t>> jobIndices(meshIds.size());
+		static const size_t NO_JOB = static_cast<size_t>(-1);
+
+		for (size_t m = 0; m < meshIds.size(); ++m) {
+			auto& primitives = doc->meshes[meshIds[m]]->primitives;
+			for (auto& primitive : primitives) {
+				auto position = primitive->attributes.find("POSITION");
+				if (GetListMode(primitive->mode) != Mesh::Primitive::TYPE_TRIANGLES || position == primitive->attributes.end()) {
+					jobIndices[m].push_back(NO_JOB);
+					continue;
+				}
+
+				SimplifyJob job;
+				job.primitive = primitive.get();
+				job.triangleCount = 0;
+				if (!GetAccessorData(*doc, position->second, &job.positionData, outErr)
+					|| !GetAccessorDecode(*doc, position->second, &job.positionOffset, &job.positionScale, outErr)) {
+					return false;
+				}
+
+				if (GetComponentCount(job.positionData.type) != 3) {
+					outErr = "The POSITION attribute of mesh '" + meshIds[m] + "' is not a VEC3.";
+					return false;
+				}
+
+				jobIndices[m].push_back(jobs.size());
+				jobs.push_back(job);
+			}
+		}
+
+		ParallelFor(jobs.size(), 1, [&](size_t begin, size_t end) {
+			for (size_t j = begin; j < end; ++j) {
+				RunSimplifyJob(*doc, options, &jobs[j]);
+			}
+		});
+
+		// Write the indices of every level of every primitive into a single new buffer.
+		BufferBuilder builder;
+		std::vector<size_t> firstView(jobs.size());
+		std::vector<Accessor::ComponentType> componentTypes;
+		std::vector<std::vector<unsigned char>> indexBytes;
+
+		for (size_t j = 0; j < jobs.size(); ++j) {
+			if (!jobs[j].error.empty()) {
+				outErr = jobs[j].error;
+				return false;
+			}
+
+			firstView[j] = builder.GetViewCount();
+			for (auto& lod : jobs[j].lods) {
+				uint32_t maxIndex = 0;
+				for (uint32_t index : lod) {
+					maxIndex = std::max(maxIndex, index);
+				}
+
+				componentTypes.push_back(GetSmallestIndexComponentType(maxIndex));
+				indexBytes.push_back(std::vector<unsigned char>());
+				WriteIndices(lod, componentTypes.back(), &indexBytes.back());
+				builder.AddView(indexBytes.back().data(), indexBytes.back().size(), BufferView::TARGET_ELEMENT_ARRAY_BUFFER);
+			}
+		}
+
+		std::vector<std::string> viewIds;
+		if (builder.GetViewCount()) {
+			viewIds = builder.Commit(doc, "simplified");
+		}
+
+		outReport->clear();
+		for (size_t m = 0; m < meshIds.size(); ++m) {
+			SimplifyReport report;
+			report.mesh = meshIds[m];
+			report.triangleCounts.assign(options.ratios.size() + 1, 0);
+
+			const Mesh& mesh = *doc->meshes[meshIds[m]];
+			for (size_t j : jobIndices[m]) {
+				if (j != NO_JOB) {
+					report.triangleCounts[0] += jobs[j].triangleCount;
+				}
+			}
+
+			for (size_t level = 0; level < options.ratios.size(); ++level) {
+				std::stringstream ss;
+				ss << meshIds[m] << "_lod" << level + 1;
+
+				std::unique_ptr<Mesh> lodMesh(new Mesh());
+				for (size_t p = 0; p < mesh.primitives.size(); ++p) {
+					std::unique_ptr<Mesh::Primitive> primitive(new Mesh::Primitive(*mesh.primitives[p]));
+					size_t j = jobIndices[m][p];
+					if (j != NO_JOB) {
+						const std::vector<uint32_t>& lod = jobs[j].lods[level];
+						Accessor indices;
+						indices.componentType = componentTypes[firstView[j] + level];
+						indices.type = Accessor::TYPE_SCALAR;
+
+						primitive->mode = Mesh::Primitive::TYPE_TRIANGLES;
+						primitive->indices = AddAccessor(
+							doc, ss.str() + "_indices", indices, viewIds[firstView[j] + level], static_cast<long long>(lod.size()));
+
+						report.triangleCounts[level + 1] += lod.size() / 3;
+					}
+
+					lodMesh->primitives.push_back(std::move(primitive));
+				}
+
+				std::string lodMeshId = MakeUniqueId(doc->meshes, ss.str());
+				doc->meshes[lodMeshId] = std::move(lodMesh);
+				report.lodMeshes.push_back(lodMeshId);
+			}
+
+			outReport->push_back(report);
+		}
+
+		return true;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,77 @@
+/*
+Copyright (c) 2016 Ruben Cashie
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation 
+files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, 
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software 
+is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES 
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE 
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef GLTF_BASTARD_SIMPLIFY_H
+#define GLTF_BASTARD_SIMPLIFY_H
+
+#include "glTFBastardAccessor.h"
+
+namespace glTFBastard {
+
+	// Simplifies a triangle list with quadric error metric edge collapses (Garland and Heckbert, "Surface
+	// Simplification Using Quadric Error Metrics"). Vertices only ever collapse onto a neighbouring vertex, so no
+	// attributes are interpolated and the result indexes the same vertices.
+	// Vertices that share their position with another vertex (attribute seams) and vertices on open borders are
+	// never moved, which keeps seams and silhouettes intact; weld exact duplicates first so they are not mistaken for seams.
+	// positions holds the x, y and z arrays of vertexCount positions. Stops at targetIndexCount indices or when no
+	// collapse stays within maxError, a distance relative to the extent of the mesh.
+	// outIndices must have room for indexCount indices; returns the number of indices written.
+	// outError, if not null, receives the largest relative error of the collapses that were made.
+	size_t SimplifyTriangles(
+		const uint32_t* indices,
+		size_t indexCount,
+		const float* const* positions,
+		size_t vertexCount,
+		size_t targetIndexCount,
+		float maxError,
+		uint32_t* outIndices,
+		float* outError);
+
+	struct SimplifyOptions {
+		// The triangle count of each level of detail relative to the original, in decreasing order.
+		std::vector<float> ratios;
+
+		// The largest error allowed relative to the extent of a primitive; levels stop early rather than exceed it.
+		float maxError;
+
+		SimplifyOptions() :
+			maxError(1.0f) {
+			ratios.push_back(0.5f);
+			ratios.push_back(0.25f);
+			ratios.push_back(0.125f);
+		}
+	};
+
+	// The levels of detail generated for one mesh.
+	struct SimplifyReport {
+		std::string mesh;
+
+		// The ids of the new meshes, one per ratio.
+		std::vector<std::string> lodMeshes;
+
+		// The triangle count of the original mesh followed by that of each level, summed over all primitives.
+		std::vector<size_t> triangleCounts;
+	};
+
+	// Generates a chain of levels of detail for every mesh in the document. Each level is added as a new mesh named
+	// after the original with an "_lod<n>" suffix whose triangle primitives get new indices accessors into the
+	// original vertices; other primitives are copied as is. Each level is simplified from the previous one.
+	// Primitives are simplified in parallel and the indices are written to a new buffer.
+	// The buffers of every triangle primitive must have been loaded.
+	bool SimplifyMeshes(glTF* doc, const SimplifyOptions& options, std::vector<SimplifyReport>* outReport, std::string& outErr);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,509 @@
+/*
+Copyright (c) 2016 Ruben Cashie
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation 
+files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, 
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software 
+is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES 
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE 
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include "glTFBastardAccessor.h"
+#include "glTFBastardConvert.h"
+#include "glTFBastardParallel.h"
+#include "glTFBastardQuantize.h"
+#include "glTFBastardSkinning.h"
+
+namespace glTFBastard {
+
+	// Palette entries and vertices computed by one task.
+	static const size_t PALETTE_GRAIN_SIZE = 1024;
+	static const size_t SKIN_GRAIN_SIZE = 4096;
+
+	// Finds the joints of a skin under the skeletons of a skinned node.
+	static bool ResolveJoints(
+		const FlatScene& scene,
+		const Node& node,
+		const SkinBinding& binding,
+		const Skin& skin,
+		std::vector<uint32_t>* outJoints,
+		std::string& outErr) {
+
+		std::vector<std::pair<uint32_t, uint32_t>> ranges;
+		for (const std::string& skeleton : node.skeletons) {
+			auto root = scene.indices.find(skeleton);
+			if (root == scene.indices.end()) {
+				outErr = "The skeleton '" + skeleton + "' of the node '" + binding.node + "' is not part of the scene.";
+				return false;
+			}
+
+			ranges.push_back(std::make_pair(root->second, scene.subtreeEnds[root->second]));
+		}
+
+		if (ranges.empty()) {
+			ranges.push_back(std::make_pair(0u, static_cast<uint32_t>(scene.GetCount())));
+		}
+
+		std::unordered_map<std::string, uint32_t> jointIndices;
+		for (const std::pair<uint32_t, uint32_t>& range : ranges) {
+			for (uint32_t i = range.first; i < range.second; ++i) {
+				if (!scene.nodes[i]->jointName.empty()) {
+					jointIndices.insert(std::make_pair(scene.nodes[i]->jointName, i));
+				}
+			}
+		}
+
+		outJoints->clear();
+		for (const std::string& jointName : skin.jointNames) {
+			auto joint = jointIndices.find(jointName);
+			if (joint == jointIndices.end()) {
+				outErr = "The joint '" + jointName + "' of the skin '" + binding.skin + "' is not under the skeletons of the node '"
+					+ binding.node + "'.";
+				return false;
+			}
+
+			outJoints->push_back(joint->second);
+		}
+
+		return true;
+	}
+
+	// Multiplies the inverse bind matrices of a skin with its bind shape matrix.
+	static bool ReadBindMatrices(const glTF& doc, const SkinBinding& binding, const Skin& skin, std::vector<float>* out, std::string& outErr) {
+		size_t jointCount = skin.jointNames.size();
+		out->resize(jointCount * 16);
+		if (skin.inverseBindMatrices.empty()) {
+			for (size_t j = 0; j < jointCount; ++j) {
+				memcpy(&(*out)[j * 16], skin.bindShapeMatrix, 16 * sizeof(float));
+			}
+
+			return true;
+		}
+
+		AccessorData data;
+		if (!GetAccessorData(doc, skin.inverseBindMatrices, &data, outErr)) {
+			return false;
+		}
+
+		if (!AccessorView<float, 16>::IsCompatible(data) || data.type != Accessor::TYPE_MAT4 || data.count < jointCount) {
+			outErr = "The inverseBindMatrices of the skin '" + binding.skin + "' are not FLOAT MAT4 with a matrix per joint.";
+			return false;
+		}
+
+		AccessorView<float, 16> view(data);
+		for (size_t j = 0; j < jointCount; ++j) {
+			AccessorView<float, 16>::Element inverseBind = view[j];
+			MultiplyMatrices(inverseBind.components, skin.bindShapeMatrix, &(*out)[j * 16]);
+		}
+
+		return true;
+	}
+
+	bool ResolveSkins(const glTF& doc, const FlatScene& scene, std::vector<SkinBinding>* out, std::string& outErr) {
+		out->clear();
+		for (uint32_t i = 0; i < scene.GetCount(); ++i) {
+			const Node& node = *scene.nodes[i];
+			if (node.skin.empty()) {
+				continue;
+			}
+
+			auto skin = doc.skins.find(node.skin);
+			if (skin == doc.skins.end()) {
+				outErr = "The node '" + scene.ids[i] + "' refers to the missing skin '" + node.skin + "'.";
+				return false;
+			}
+
+			SkinBinding binding;
+			binding.node = scene.ids[i];
+			binding.skin = node.skin;
+			binding.nodeIndex = i;
+			if (!ResolveJoints(scene, node, binding, *skin->second, &binding.joints, outErr)
+				|| !ReadBindMatrices(doc, binding, *skin->second, &binding.bindMatrices, outErr)) {
+				return false;
+			}
+
+			out->push_back(std::move(binding));
+		}
+
+		return true;
+	}
+
+	SkinPalettes::SkinPalettes() :
+		instanceCount(0) {
+	}
+
+	void SkinPalettes::Build(const std::vector<SkinBinding>& bindings) {
+		firstJoints.clear();
+		jointNodes.clear();
+		bindMatrices.clear();
+		palettes.clear();
+		instanceCount = 0;
+
+		for (const SkinBinding& binding : bindings) {
+			firstJoints.push_back(static_cast<uint32_t>(jointNodes.size()));
+			jointNodes.insert(jointNodes.end(), binding.joints.begin(), binding.joints.end());
+			bindMatrices.insert(bindMatrices.end(), binding.bindMatrices.begin(), binding.bindMatrices.end());
+		}
+	}
+
+	void SkinPalettes::Update(const float* const* worldMatrices, size_t updateInstanceCount) {
+		instanceCount = updateInstanceCount;
+		size_t jointCount = jointNodes.size();
+		palettes.resize(instanceCount * jointCount * 16);
+
+		ParallelFor(instanceCount * jointCount, PALETTE_GRAIN_SIZE, [&](size_t begin, size_t end) {
+			for (size_t entry = begin; entry < end; ++entry) {
+				size_t instance = entry / jointCount;
+				size_t joint = entry - instance * jointCount;
+				MultiplyMatricesVector(&worldMatrices[instance][jointNodes[joint] * 16], &bindMatrices[joint * 16], &palettes[entry * 16]);
+			}
+		});
+	}
+
+#if defined(GLTF_BASTARD_AVX2)
+	typedef __m256 SkinVector;
+	static const size_t SKIN_VECTOR_WIDTH = 8;
+
+	static inline SkinVector LoadVector(const float* values) {
+		return _mm256_loadu_ps(values);
+	}
+
+	static inline void StoreVector(float* out, SkinVector value) {
+		_mm256_storeu_ps(out, value);
+	}
+
+	static inline SkinVector SetVector(float value) {
+		return _mm256_set1_ps(value);
+	}
+
+	static inline SkinVector Add(SkinVector a, SkinVector b) {
+		return _mm256_add_ps(a, b);
+	}
+
+	static inline SkinVector Multiply(SkinVector a, SkinVector b) {
+		return _mm256_mul_ps(a, b);
+	}
+
+	static inline SkinVector Divide(SkinVector a, SkinVector b) {
+		return _mm256_div_ps(a, b);
+	}
+
+	static inline SkinVector Maximum(SkinVector a, SkinVector b) {
+		return _mm256_max_ps(a, b);
+	}
+
+	static inline SkinVector SquareRoot(SkinVector a) {
+		return _mm256_sqrt_ps(a);
+	}
+
+	// Gathers element k of the palette matrices of the joints of a vector of vertices.
+	static inline SkinVector GatherPalette(const float* palette, const uint32_t* joints, size_t k) {
+		__m256i offsets = _mm256_slli_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(joints)), 4);
+		return _mm256_i32gather_ps(palette + k, offsets, 4);
+	}
+#elif defined(GLTF_BASTARD_SSE2)
+	typedef __m128 SkinVector;
+	static const size_t SKIN_VECTOR_WIDTH = 4;
+
+	static inline SkinVector LoadVector(const float* values) {
+		return _mm_loadu_ps(values);
+	}
+
+	static inline void StoreVector(float* out, SkinVector value) {
+		_mm_storeu_ps(out, value);
+	}
+
+	static inline SkinVector SetVector(float value) {
+		return _mm_set1_ps(value);
+	}
+
+	static inline SkinVector Add(SkinVector a, SkinVector b) {
+		return _mm_add_ps(a, b);
+	}
+
+	static inline SkinVector Multiply(SkinVector a, SkinVector b) {
+		return _mm_mul_ps(a, b);
+	}
+
+	static inline SkinVector Divide(SkinVector a, SkinVector b) {
+		return _mm_div_ps(a, b);
+	}
+
+	static inline SkinVector Maximum(SkinVector a, SkinVector b) {
+		return _mm_max_ps(a, b);
+	}
+
+	static inline SkinVector SquareRoot(SkinVector a) {
+		return _mm_sqrt_ps(a);
+	}
+
+	static inline SkinVector GatherPalette(const float* palette, const uint32_t* joints, size_t k) {
+		return _mm_setr_ps(palette[joints[0] * 16 + k], palette[joints[1] * 16 + k], palette[joints[2] * 16 + k], palette[joints[3] * 16 + k]);
+	}
+#endif
+
+	// The smallest length that normals are divided by, so that zero normals stay zero.
+	static const float MIN_NORMAL_LENGTH = 1e-30f;
+
+	// Skins the vertices [begin, end) a vector at a time, then one at a time. Both blend the top three rows of the
+	// matrices in the same order, so they give the same results.
+	static void SkinVertexRange(
+		const float* const* positions,
+		const float* const* normals,
+		const uint32_t* const* joints,
+		const float* const* weights,
+		size_t begin,
+		size_t end,
+		const float* palette,
+		float* const* outPositions,
+		float* const* outNormals) {
+
+		size_t v = begin;
+#if defined(GLTF_BASTARD_SSE2)
+		SkinVector zero = SetVector(0.0f);
+		SkinVector one = SetVector(1.0f);
+		SkinVector minLength = SetVector(MIN_NORMAL_LENGTH);
+		for (; v + SKIN_VECTOR_WIDTH <= end; v += SKIN_VECTOR_WIDTH) {
+			// Element row + column * 3 of the blended matrix.
+			SkinVector blended[12];
+			for (size_t k = 0; k < 12; ++k) {
+				blended[k] = zero;
+			}
+
+			for (size_t influence = 0; influence < 4; ++influence) {
+				SkinVector weight = LoadVector(weights[influence] + v);
+				for (size_t column = 0; column < 4; ++column) {
+					for (size_t row = 0; row < 3; ++row) {
+						SkinVector element = GatherPalette(palette, joints[influence] + v, column * 4 + row);
+						blended[column * 3 + row] = Add(blended[column * 3 + row], Multiply(weight, element));
+					}
+				}
+			}
+
+			SkinVector x = LoadVector(positions[0] + v);
+			SkinVector y = LoadVector(positions[1] + v);
+			SkinVector z = LoadVector(positions[2] + v);
+			for (size_t row = 0; row < 3; ++row) {
+				SkinVector result = Add(Add(Add(Multiply(blended[row], x), Multiply(blended[3 + row], y)), Multiply(blended[6 + row], z)), blended[9 + row]);
+				StoreVector(outPositions[row] + v, result);
+			}
+
+			if (normals) {
+				x = LoadVector(normals[0] + v);
+				y = LoadVector(normals[1] + v);
+				z = LoadVector(normals[2] + v);
+
+				SkinVector result[3];
+				for (size_t row = 0; row < 3; ++row) {
+					result[row] = Add(Add(Multiply(blended[row], x), Multiply(blended[3 + row], y)), Multiply(blended[6 + row], z));
+				}
+
+				SkinVector lengthSquared = Add(Add(Multiply(result[0], result[0]), Multiply(result[1], result[1])), Multiply(result[2], result[2]));
+				SkinVector inverseLength = Divide(one, Maximum(SquareRoot(lengthSquared), minLength));
+				for (size_t row = 0; row < 3; ++row) {
+					StoreVector(outNormals[row] + v, Multiply(result[row], inverseLength));
+				}
+			}
+		}
+#endif
+
+		for (; v < end; ++v) {
+			float blended[12] = {};
+			for (size_t influence = 0; influence < 4; ++influence) {
+				float weight = weights[influence][v];
+				const float* matrix = palette + joints[influence][v] * 16;
+				for (size_t column = 0; column < 4; ++column) {
+					for (size_t row = 0; row < 3; ++row) {
+						blended[column * 3 + row] = blended[column * 3 + row] + weight * matrix[column * 4 + row];
+					}
+				}
+			}
+
+			float x = positions[0][v];
+			float y = positions[1][v];
+			float z = positions[2][v];
+			for (size_t row = 0; row < 3; ++row) {
+				outPositions[row][v] = blended[row] * x + blended[3 + row] * y + blended[6 + row] * z + blended[9 + row];
+			}
+
+			if (normals) {
+				x = normals[0][v];
+				y = normals[1][v];
+				z = normals[2][v];
+
+				float result[3];
+				for (size_t row = 0; row < 3; ++row) {
+					result[row] = blended[row] * x + blended[3 + row] * y + blended[6 + row] * z;
+				}
+
+				float lengthSquared = result[0] * result[0] + result[1] * result[1] + result[2] * result[2];
+				float inverseLength = 1.0f / std::max(std::sqrt(lengthSquared), MIN_NORMAL_LENGTH);
+				for (size_t row = 0; row < 3; ++row) {
+					outNormals[row][v] = result[row] * inverseLength;
+				}
+			}
+		}
+	}
+
+	void SkinVertices(
+		const float* const* positions,
+		const float* const* normals,
+		const uint32_t* const* joints,
+		const float* const* weights,
+		size_t vertexCount,
+		const float* palette,
+		float* const* outPositions,
+		float* const* outNormals) {
+
+		ParallelFor(vertexCount, SKIN_GRAIN_SIZE, [&](size_t begin, size_t end) {
+			SkinVertexRange(positions, normals, joints, weights, begin, end, palette, outPositions, outNormals);
+		});
+	}
+
+	// Resolves an attribute of a primitive and checks its type; optional attributes that are missing leave out->data null.
+	static bool GetAttributeData(
+		const glTF& doc,
+		const Mesh::Primitive& primitive,
+		const std::string& semantic,
+		Accessor::Type type,
+		bool required,
+		AccessorData* out,
+		std::string& outErr) {
+
+		auto attribute = primitive.attributes.find(semantic);
+		if (attribute == primitive.attributes.end()) {
+			if (required) {
+				outErr = "The primitive has no " + semantic + " attribute.";
+				return false;
+			}
+
+			return true;
+		}
+
+		if (!GetAccessorData(doc, attribute->second, out, outErr)) {
+			return false;
+		}
+
+		if (out->type != type) {
+			outErr = "The " + semantic + " accessor '" + attribute->second + "' has the wrong type.";
+			return false;
+		}
+
+		return true;
+	}
+
+	bool SkinPrimitive(
+		const glTF& doc,
+		const Mesh::Primitive& primitive,
+		const float* palette,
+		size_t jointCount,
+		SkinnedPrimitive* out,
+		std::string& outErr) {
+
+		AccessorData positionData;
+		AccessorData normalData;
+		AccessorData jointData;
+		AccessorData weightData;
+
+		// Quantized normals are octahedral pairs of normalized BYTE or SHORT components; see QuantizeAttributes.
+		bool octahedralNormals = false;
+		auto normal = primitive.attributes.find("NORMAL");
+		if (normal != primitive.attributes.end()) {
+			auto accessor = doc.accessors.find(normal->second);
+			octahedralNormals = accessor != doc.accessors.end() && accessor->second->type == Accessor::TYPE_VEC2
+				&& (accessor->second->componentType == Accessor::COMPONENT_TYPE_BYTE
+					|| accessor->second->componentType == Accessor::COMPONENT_TYPE_SHORT);
+		}
+
+		if (!GetAttributeData(doc, primitive, "POSITION", Accessor::TYPE_VEC3, true, &positionData, outErr)
+			|| !GetAttributeData(doc, primitive, "NORMAL", octahedralNormals ? Accessor::TYPE_VEC2 : Accessor::TYPE_VEC3, false, &normalData, outErr)
+			|| !GetAttributeData(doc, primitive, "JOINT", Accessor::TYPE_VEC4, true, &jointData, outErr)
+			|| !GetAttributeData(doc, primitive, "WEIGHT", Accessor::TYPE_VEC4, true, &weightData, outErr)) {
+			return false;
+		}
+
+		size_t count = positionData.count;
+		if ((normalData.data && normalData.count != count) || jointData.count != count || weightData.count != count) {
+			outErr = "The POSITION, NORMAL, JOINT and WEIGHT accessors of the primitive have different counts.";
+			return false;
+		}
+
+		for (const AccessorData* data : {&jointData, &weightData}) {
+			if (data->componentType != Accessor::COMPONENT_TYPE_UNSIGNED_BYTE
+				&& data->componentType != Accessor::COMPONENT_TYPE_UNSIGNED_SHORT
+				&& data->componentType != Accessor::COMPONENT_TYPE_FLOAT) {
+				outErr = "The JOINT and WEIGHT accessors of the primitive must be UNSIGNED_BYTE, UNSIGNED_SHORT or FLOAT.";
+				return false;
+			}
+		}
+
+		out->vertexCount = count;
+		float* positions[3];
+		float* normals[3];
+		for (size_t axis = 0; axis < 3; ++axis) {
+			out->positions[axis].resize(count);
+			out->normals[axis].resize(normalData.data ? count : 0);
+			positions[axis] = out->positions[axis].data();
+			normals[axis] = out->normals[axis].data();
+		}
+
+		std::vector<float> jointValues(count * 4);
+		std::vector<float> weightValues(count * 4);
+		float* jointComponents[4];
+		float* weightComponents[4];
+		for (size_t influence = 0; influence < 4; ++influence) {
+			jointComponents[influence] = &jointValues[influence * count];
+			weightComponents[influence] = &weightValues[influence * count];
+		}
+
+		std::vector<float> positionOffset;
+		std::vector<float> positionScale;
+		std::vector<float> octahedral(octahedralNormals ? count * 2 : 0);
+		float* octahedralComponents[2] = {octahedral.data(), octahedral.data() + octahedral.size() / 2};
+		if (!GetAccessorDecode(doc, primitive.attributes.at("POSITION"), &positionOffset, &positionScale, outErr)
+			|| !ConvertAccessorToSoA(positionData, false, positions, outErr)
+			|| (normalData.data && !octahedralNormals && !ConvertAccessorToSoA(normalData, false, normals, outErr))
+			|| (octahedralNormals && !ConvertAccessorToSoA(normalData, true, octahedralComponents, outErr))
+			|| !ConvertAccessorToSoA(jointData, false, jointComponents, outErr)
+			|| !ConvertAccessorToSoA(weightData, true, weightComponents, outErr)) {
+			return false;
+		}
+
+		DecodeComponents(positionOffset, positionScale, count, positions);
+		for (size_t i = 0; i < octahedral.size() / 2; ++i) {
+			float pair[2] = {octahedralComponents[0][i], octahedralComponents[1][i]};
+			float decoded[3];
+			DecodeOctahedral(pair, decoded);
+			for (size_t axis = 0; axis < 3; ++axis) {
+				normals[axis][i] = decoded[axis];
+			}
+		}
+
+		std::vector<uint32_t> jointIndices(count * 4);
+		const uint32_t* joints[4];
+		for (size_t i = 0; i < jointValues.size(); ++i) {
+			if (!(jointValues[i] >= 0.0f && jointValues[i] < static_cast<float>(jointCount))) {
+				outErr = "A JOINT of the primitive is not in the palette.";
+				return false;
+			}
+
+			jointIndices[i] = static_cast<uint32_t>(jointValues[i]);
+		}
+
+		for (size_t influence = 0; influence < 4; ++influence) {
+			joints[influence] = &jointIndices[influence * count];
+		}
+
+		// The vertices are deformed in place.
+		SkinVertices(positions, normalData.data ? normals : nullptr, joints, weightComponents, count, palette, positions, normals);
+		return true;
+	}
+}
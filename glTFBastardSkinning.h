@@ -0,0 +1,140 @@
+/*
+Copyright (c) 2016 Ruben Cashie
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation 
+files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, 
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software 
+is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES 
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE 
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef GLTF_BASTARD_SKINNING_H
+#define GLTF_BASTARD_SKINNING_H
+
+#include <cstdint>
+#include "glTFBastardSceneGraph.h"
+#include "glTFBastardSimd.h"
+
+namespace glTFBastard {
+
+	// A skinned node of a flattened scene with the joints of its skin resolved to scene indices.
+	struct SkinBinding {
+		std::string node;
+		std::string skin;
+		uint32_t nodeIndex;
+
+		// The scene index of each joint, in the order of the jointNames of the skin.
+		std::vector<uint32_t> joints;
+
+		// The inverse bind matrix of each joint multiplied with the bind shape matrix, 16 floats per joint.
+		std::vector<float> bindMatrices;
+
+		SkinBinding() :
+			nodeIndex(0) {
+		}
+	};
+
+	// Resolves the skin of every skinned node of a scene. The jointNames of a skin are matched against the jointName
+	// of the nodes under the skeletons of the skinned node, or of the whole scene if it lists none; the first match
+	// in depth first order wins. Fails if a skin, a skeleton or a joint is missing, or if the inverseBindMatrices are
+	// not FLOAT MAT4 with one matrix per joint. The buffers of every inverseBindMatrices accessor must have been loaded.
+	bool ResolveSkins(const glTF& doc, const FlatScene& scene, std::vector<SkinBinding>* out, std::string& outErr);
+
+	// The joint matrix palettes of a set of skin bindings: the world matrix of each joint multiplied with its inverse
+	// bind matrix and the bind shape matrix, which takes vertices in the space of the mesh to world space.
+	// The palettes of every binding are stored one after another, and those of each instance after the previous
+	// instance, in a buffer aligned to 64 bytes so that each matrix is on its own cache line.
+	class SkinPalettes {
+	public:
+		SkinPalettes();
+
+		// Flattens the joints of every binding into one table.
+		void Build(const std::vector<SkinBinding>& bindings);
+
+		// Computes the palettes of every binding for instanceCount copies of the scene the bindings were resolved
+		// in; instance i takes its world matrices from worldMatrices[i], 16 floats per scene node, as
+		// SceneTransforms keeps them. Joints are multiplied with SSE2 or AVX2 and spread across threads.
+		void Update(const float* const* worldMatrices, size_t instanceCount);
+
+		// Computes the palettes of a single instance.
+		void Update(const float* worldMatrices) {
+			Update(&worldMatrices, 1);
+		}
+
+		// The number of joints of every binding together, which is the number of matrices per instance.
+		size_t GetJointCount() const {
+			return jointNodes.size();
+		}
+
+		size_t GetInstanceCount() const {
+			return instanceCount;
+		}
+
+		// The first matrix of the palette of a binding for an instance.
+		const float* GetPalette(size_t instance, size_t binding) const {
+			return &palettes[(instance * jointNodes.size() + firstJoints[binding]) * 16];
+		}
+
+		const std::vector<float, CacheLineAllocator<float>>& GetPalettes() const {
+			return palettes;
+		}
+
+	private:
+		std::vector<uint32_t> firstJoints;
+		std::vector<uint32_t> jointNodes;
+		std::vector<float, CacheLineAllocator<float>> bindMatrices;
+		std::vector<float, CacheLineAllocator<float>> palettes;
+		size_t instanceCount;
+	};
+
+	// Deforms vertices with linear blend skinning: each vertex is transformed by the sum of the palette matrices of
+	// its four joints weighted by its four weights. Every array holds vertexCount values of one component, so
+	// positions and outPositions hold x, y and z arrays, normals and outNormals (either may be null) hold x, y and z
+	// arrays, and joints and weights hold four arrays each. Joints must index the palette, 16 floats per matrix.
+	// The outputs may be the inputs, which deforms the vertices in place.
+	// Normals are transformed by the blended matrix and normalized, which is exact for joints without non-uniform
+	// scale. Runs on several vertices at a time with SSE2 or AVX2, gathering the palette with AVX2, and spreads
+	// vertices across threads.
+	void SkinVertices(
+		const float* const* positions,
+		const float* const* normals,
+		const uint32_t* const* joints,
+		const float* const* weights,
+		size_t vertexCount,
+		const float* palette,
+		float* const* outPositions,
+		float* const* outNormals);
+
+	// The deformed vertices of a primitive.
+	struct SkinnedPrimitive {
+		size_t vertexCount;
+
+		// The x, y and z arrays of the positions and, if the primitive has them, of the normals.
+		std::vector<float> positions[3];
+		std::vector<float> normals[3];
+
+		SkinnedPrimitive() :
+			vertexCount(0) {
+		}
+	};
+
+	// Deforms the POSITION and NORMAL attributes of a primitive with its JOINT and WEIGHT attributes, which are VEC4
+	// of UNSIGNED_BYTE, UNSIGNED_SHORT or FLOAT; integer weights are normalized. Fails if an attribute is missing or
+	// has a different count, or if a joint is not below jointCount. Quantized POSITION and octahedral NORMAL attributes,
+	// as written by QuantizeAttributes, are decoded first. The buffers of the attributes must have been loaded.
+	bool SkinPrimitive(
+		const glTF& doc,
+		const Mesh::Primitive& primitive,
+		const float* palette,
+		size_t jointCount,
+		SkinnedPrimitive* out,
+		std::string& outErr);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,425 @@
+/*
+Copyright (c) 2016 Ruben Cashie
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation 
+files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, 
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software 
+is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES 
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE 
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <algorithm>
+#include <sstream>
+#include "glTFBastardTopology.h"
+#include "glTFBastardSimd.h"
+
+namespace glTFBastard {
+
+	// Returns the list mode that a primitive mode converts to.
+	Mesh::Primitive::Mode GetListMode(Mesh::Primitive::Mode mode) {
+		switch (mode) {
+			case Mesh::Primitive::TYPE_POINTS:
+				return Mesh::Primitive::TYPE_POINTS;
+			case Mesh::Primitive::TYPE_LINES:
+			case Mesh::Primitive::TYPE_LINE_LOOP:
+			case Mesh::Primitive::TYPE_LINE_STRIP:
+				return Mesh::Primitive::TYPE_LINES;
+			case Mesh::Primitive::TYPE_TRIANGLES:
+			case Mesh::Primitive::TYPE_TRIANGLE_STRIP:
+			case Mesh::Primitive::TYPE_TRIANGLE_FAN:
+				return Mesh::Primitive::TYPE_TRIANGLES;
+		}
+
+		return mode;
+	}
+
+	// Returns the smallest index component type that can hold the specified index.
+	Accessor::ComponentType GetSmallestIndexComponentType(uint32_t maxIndex) {
+		if (maxIndex <= 0xFF) {
+			return Accessor::COMPONENT_TYPE_UNSIGNED_BYTE;
+		}
+
+		if (maxIndex <= 0xFFFF) {
+			return Accessor::COMPONENT_TYPE_UNSIGNED_SHORT;
+		}
+
+		return Accessor::COMPONENT_TYPE_UNSIGNED_INT;
+	}
+
+	// Reads indices of any index component type into 32 bit indices.
+	// Tightly packed 8 and 16 bit indices are widened a vector at a time.
+	bool ReadIndices(const AccessorData& indices, std::vector<uint32_t>* out, std::string& outErr) {
+		size_t componentSize = GetComponentSize(indices.componentType);
+		if (indices.type != Accessor::TYPE_SCALAR
+			|| (indices.componentType != Accessor::COMPONENT_TYPE_UNSIGNED_BYTE
+				&& indices.componentType != Accessor::COMPONENT_TYPE_UNSIGNED_SHORT
+				&& indices.componentType != Accessor::COMPONENT_TYPE_UNSIGNED_INT)) {
+			outErr = "Indices must be unsigned integer scalars.";
+			return false;
+		}
+
+		size_t count = indices.count;
+		out->resize(count);
+		uint32_t* result = out->data();
+
+		size_t byteStride = indices.byteStride ? indices.byteStride : componentSize;
+		size_t i = 0;
+
+		if (byteStride == componentSize) {
+			if (indices.componentType == Accessor::COMPONENT_TYPE_UNSIGNED_INT) {
+				if (count) {
+					memcpy(result, indices.data, count * sizeof(uint32_t));
+				}
+
+				return true;
+			}
+
+#if defined(GLTF_BASTARD_SSE2)
+			const __m128i zero = _mm_setzero_si128();
+			if (indices.componentType == Accessor::COMPONENT_TYPE_UNSIGNED_BYTE) {
+				for (; i + 16 <= count; i += 16) {
+					__m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(indices.data + i));
+					__m128i low = _mm_unpacklo_epi8(bytes, zero);
+					__m128i high = _mm_unpackhi_epi8(bytes, zero);
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(result + i), _mm_unpacklo_epi16(low, zero));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(result + i + 4), _mm_unpackhi_epi16(low, zero));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(result + i + 8), _mm_unpacklo_epi16(high, zero));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(result + i + 12), _mm_unpackhi_epi16(high, zero));
+				}
+			}
+			else {
+				for (; i + 8 <= count; i += 8) {
+					__m128i shorts = _mm_loadu_si128(reinterpret_cast<const __m128i*>(indices.data + i * 2));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(result + i), _mm_unpacklo_epi16(shorts, zero));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(result + i + 4), _mm_unpackhi_epi16(shorts, zero));
+				}
+			}
+#endif
+		}
+
+		for (; i < count; ++i) {
+			const unsigned char* source = indices.data + i * byteStride;
+			switch (indices.componentType) {
+				case Accessor::COMPONENT_TYPE_UNSIGNED_BYTE: {
+					result[i] = *source;
+					break;
+				}
+				case Accessor::COMPONENT_TYPE_UNSIGNED_SHORT: {
+					uint16_t value;
+					memcpy(&value, source, sizeof(value));
+					result[i] = value;
+					break;
+				}
+				default: {
+					memcpy(&result[i], source, sizeof(uint32_t));
+					break;
+				}
+			}
+		}
+
+		return true;
+	}
+
+	// Fills indices with the sequence 0, 1, 2... for non-indexed primitives.
+	static void GenerateIndices(size_t count, std::vector<uint32_t>* out) {
+		out->resize(count);
+		uint32_t* result = out->data();
+		size_t i = 0;
+
+#if defined(GLTF_BASTARD_SSE2)
+		__m128i sequence = _mm_setr_epi32(0, 1, 2, 3);
+		const __m128i step = _mm_set1_epi32(4);
+		for (; i + 4 <= count; i += 4) {
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(result + i), sequence);
+			sequence = _mm_add_epi32(sequence, step);
+		}
+#endif
+
+		for (; i < count; ++i) {
+			result[i] = static_cast<uint32_t>(i);
+		}
+	}
+
+	// Expands the indices of a strip, loop or fan into a list. Lists are passed through untouched.
+	// Each loop writes a fixed pattern per iteration without branches so that the compiler can vectorize it.
+	static void ExpandToList(const std::vector<uint32_t>& indices, Mesh::Primitive::Mode mode, std::vector<uint32_t>* out) {
+		const uint32_t* source = indices.data();
+		size_t count = indices.size();
+
+		switch (mode) {
+			case Mesh::Primitive::TYPE_POINTS:
+			case Mesh::Primitive::TYPE_LINES:
+			case Mesh::Primitive::TYPE_TRIANGLES: {
+				// Drop any trailing partial primitive.
+				size_t verticesPerPrimitive = mode == Mesh::Primitive::TYPE_TRIANGLES ? 3 : mode == Mesh::Primitive::TYPE_LINES ? 2 : 1;
+				out->assign(source, source + count - count % verticesPerPrimitive);
+				break;
+			}
+			case Mesh::Primitive::TYPE_LINE_STRIP:
+			case Mesh::Primitive::TYPE_LINE_LOOP: {
+				if (count < 2) {
+					out->clear();
+					break;
+				}
+
+				size_t lineCount = count - 1;
+				bool closed = mode == Mesh::Primitive::TYPE_LINE_LOOP;
+				out->resize((lineCount + (closed ? 1 : 0)) * 2);
+
+				uint32_t* result = out->data();
+				for (size_t i = 0; i < lineCount; ++i) {
+					result[i * 2] = source[i];
+					result[i * 2 + 1] = source[i + 1];
+				}
+
+				if (closed) {
+					result[lineCount * 2] = source[count - 1];
+					result[lineCount * 2 + 1] = source[0];
+				}
+
+				break;
+			}
+			case Mesh::Primitive::TYPE_TRIANGLE_STRIP: {
+				if (count < 3) {
+					out->clear();
+					break;
+				}
+
+				// Odd triangles swap their first two vertices to keep the winding order consistent.
+				// Triangles are emitted in even/odd pairs to avoid a per-triangle parity branch.
+				size_t triangleCount = count - 2;
+				out->resize(triangleCount * 3);
+
+				uint32_t* result = out->data();
+				size_t pairCount = triangleCount / 2;
+				for (size_t pair = 0; pair < pairCount; ++pair) {
+					size_t i = pair * 2;
+					uint32_t* triangles = result + i * 3;
+					triangles[0] = source[i];
+					triangles[1] = source[i + 1];
+					triangles[2] = source[i + 2];
+					triangles[3] = source[i + 2];
+					triangles[4] = source[i + 1];
+					triangles[5] = source[i + 3];
+				}
+
+				if (triangleCount % 2) {
+					size_t i = triangleCount - 1;
+					result[i * 3] = source[i];
+					result[i * 3 + 1] = source[i + 1];
+					result[i * 3 + 2] = source[i + 2];
+				}
+
+				break;
+			}
+			case Mesh::Primitive::TYPE_TRIANGLE_FAN: {
+				if (count < 3) {
+					out->clear();
+					break;
+				}
+
+				size_t triangleCount = count - 2;
+				out->resize(triangleCount * 3);
+
+				uint32_t* result = out->data();
+				uint32_t center = source[0];
+				for (size_t i = 0; i < triangleCount; ++i) {
+					result[i * 3] = center;
+					result[i * 3 + 1] = source[i + 1];
+					result[i * 3 + 2] = source[i + 2];
+				}
+
+				break;
+			}
+		}
+	}
+
+	// Returns the largest index in the list.
+	static uint32_t GetMaxIndex(const std::vector<uint32_t>& indices) {
+		const uint32_t* source = indices.data();
+		size_t count = indices.size();
+		size_t i = 0;
+		uint32_t result = 0;
+
+#if defined(GLTF_BASTARD_SSE41)
+		__m128i maximum = _mm_setzero_si128();
+		for (; i + 4 <= count; i += 4) {
+			maximum = _mm_max_epu32(maximum, _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i)));
+		}
+
+		uint32_t lanes[4];
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), maximum);
+		result = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+#elif defined(GLTF_BASTARD_SSE2)
+		// SSE2 only has a signed comparison so both sides are biased into the signed range.
+		const __m128i bias = _mm_set1_epi32(static_cast<int>(0x80000000u));
+		__m128i maximum = bias;
+		for (; i + 4 <= count; i += 4) {
+			__m128i value = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i)), bias);
+			__m128i greater = _mm_cmpgt_epi32(value, maximum);
+			maximum = _mm_or_si128(_mm_and_si128(greater, value), _mm_andnot_si128(greater, maximum));
+		}
+
+		uint32_t lanes[4];
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), _mm_xor_si128(maximum, bias));
+		result = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+#endif
+
+		for (; i < count; ++i) {
+			result = std::max(result, source[i]);
+		}
+
+		return result;
+	}
+
+	// Writes 32 bit indices with the specified component type, which must be able to hold every index.
+	// Narrowing is done a vector at a time.
+	void WriteIndices(const std::vector<uint32_t>& indices, Accessor::ComponentType componentType, std::vector<unsigned char>* out) {
+		const uint32_t* source = indices.data();
+		size_t count = indices.size();
+		out->resize(count * GetComponentSize(componentType));
+
+		if (componentType == Accessor::COMPONENT_TYPE_UNSIGNED_INT) {
+			if (count) {
+				memcpy(out->data(), source, count * sizeof(uint32_t));
+			}
+
+			return;
+		}
+
+		size_t i = 0;
+		if (componentType == Accessor::COMPONENT_TYPE_UNSIGNED_SHORT) {
+			uint16_t* result = reinterpret_cast<uint16_t*>(out->data());
+
+#if defined(GLTF_BASTARD_SSE41)
+			for (; i + 8 <= count; i += 8) {
+				__m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+				__m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i + 4));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(result + i), _mm_packus_epi32(low, high));
+			}
+#elif defined(GLTF_BASTARD_SSE2)
+			// SSE2 only has a signed saturating pack; shift the values into the signed range and back.
+			const __m128i bias32 = _mm_set1_epi32(0x8000);
+			const __m128i bias16 = _mm_set1_epi16(static_cast<short>(0x8000));
+			for (; i + 8 <= count; i += 8) {
+				__m128i low = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i)), bias32);
+				__m128i high = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i + 4)), bias32);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(result + i), _mm_add_epi16(_mm_packs_epi32(low, high), bias16));
+			}
+#endif
+
+			for (; i < count; ++i) {
+				result[i] = static_cast<uint16_t>(source[i]);
+			}
+		}
+		else {
+			uint8_t* result = out->data();
+
+#if defined(GLTF_BASTARD_SSE2)
+			// Every index fits in a byte, so the signed 32 to 16 bit pack can not saturate.
+			for (; i + 16 <= count; i += 16) {
+				__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+				__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i + 4));
+				__m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i + 8));
+				__m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i + 12));
+				__m128i packed = _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(result + i), packed);
+			}
+#endif
+
+			for (; i < count; ++i) {
+				result[i] = static_cast<uint8_t>(source[i]);
+			}
+		}
+	}
+
+	// Converts indices of any primitive mode into a list.
+	bool ConvertToList(
+		const AccessorData* indices,
+		size_t vertexCount,
+		Mesh::Primitive::Mode mode,
+		Accessor::ComponentType outComponentType,
+		IndexList* out,
+		std::string& outErr) {
+
+		if (outComponentType != Accessor::COMPONENT_TYPE_UNSIGNED_BYTE
+			&& outComponentType != Accessor::COMPONENT_TYPE_UNSIGNED_SHORT
+			&& outComponentType != Accessor::COMPONENT_TYPE_UNSIGNED_INT) {
+			outErr = "Index lists must have an unsigned integer component type.";
+			return false;
+		}
+
+		std::vector<uint32_t> source;
+		if (indices) {
+			if (!ReadIndices(*indices, &source, outErr)) {
+				return false;
+			}
+		}
+		else {
+			GenerateIndices(vertexCount, &source);
+		}
+
+		std::vector<uint32_t> list;
+		ExpandToList(source, mode, &list);
+
+		if (!list.empty() && outComponentType != Accessor::COMPONENT_TYPE_UNSIGNED_INT) {
+			uint32_t maxIndex = GetMaxIndex(list);
+			uint32_t limit = outComponentType == Accessor::COMPONENT_TYPE_UNSIGNED_BYTE ? 0xFF : 0xFFFF;
+			if (maxIndex > limit) {
+				std::stringstream ss;
+				ss << "The index " << maxIndex << " does not fit in the requested index component type.";
+				outErr = ss.str();
+				return false;
+			}
+		}
+
+		WriteIndices(list, outComponentType, &out->data);
+		out->componentType = outComponentType;
+		out->mode = GetListMode(mode);
+		out->count = list.size();
+		return true;
+	}
+
+	// Converts the indices of a primitive into a list.
+	bool ConvertPrimitiveToList(
+		const glTF& doc,
+		const Mesh::Primitive& primitive,
+		Accessor::ComponentType outComponentType,
+		IndexList* out,
+		std::string& outErr) {
+
+		if (!primitive.indices.empty()) {
+			AccessorData indices;
+			if (!GetAccessorData(doc, primitive.indices, &indices, outErr)) {
+				return false;
+			}
+
+			return ConvertToList(&indices, 0, primitive.mode, outComponentType, out, outErr);
+		}
+
+		if (primitive.attributes.empty()) {
+			outErr = "A non-indexed primitive has no attributes to take its vertex count from.";
+			return false;
+		}
+
+		auto attribute = primitive.attributes.find("POSITION");
+		if (attribute == primitive.attributes.end()) {
+			attribute = primitive.attributes.begin();
+		}
+
+		auto accessor = doc.accessors.find(attribute->second);
+		if (accessor == doc.accessors.end()) {
+			outErr = "The accessor '" + attribute->second + "' does not exist.";
+			return false;
+		}
+
+		return ConvertToList(
+			nullptr, static_cast<size_t>(accessor->second->count), primitive.mode, outComponentType, out, outErr);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,73 @@
+/*
+Copyright (c) 2016 Ruben Cashie
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation 
+files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, 
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software 
+is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES 
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE 
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef GLTF_BASTARD_TOPOLOGY_H
+#define GLTF_BASTARD_TOPOLOGY_H
+
+#include "glTFBastardAccessor.h"
+
+namespace glTFBastard {
+
+	// A list of indices in one of the index component types.
+	struct IndexList {
+		Accessor::ComponentType componentType;
+		Mesh::Primitive::Mode mode;
+		size_t count;
+		std::vector<unsigned char> data;
+
+		IndexList() :
+			componentType(Accessor::COMPONENT_TYPE_UNSIGNED_SHORT),
+			mode(Mesh::Primitive::TYPE_TRIANGLES),
+			count(0) {
+		}
+	};
+
+	// Returns the list mode that a primitive mode converts to.
+	// Points stay points, line loops and strips become lines and triangle strips and fans become triangles.
+	Mesh::Primitive::Mode GetListMode(Mesh::Primitive::Mode mode);
+
+	// Returns the smallest index component type that can hold the specified index.
+	Accessor::ComponentType GetSmallestIndexComponentType(uint32_t maxIndex);
+
+	// Reads UNSIGNED_BYTE, UNSIGNED_SHORT or UNSIGNED_INT indices into 32 bit indices.
+	bool ReadIndices(const AccessorData& indices, std::vector<uint32_t>* out, std::string& outErr);
+
+	// Writes 32 bit indices as UNSIGNED_BYTE, UNSIGNED_SHORT or UNSIGNED_INT; every index must fit in the component type.
+	void WriteIndices(const std::vector<uint32_t>& indices, Accessor::ComponentType componentType, std::vector<unsigned char>* out);
+
+	// Converts indices of any primitive mode into a list of the mode returned by GetListMode.
+	// If indices is null the primitive is treated as non-indexed with vertexCount vertices and indices are generated.
+	// The result is written with the specified UNSIGNED_BYTE, UNSIGNED_SHORT or UNSIGNED_INT component type;
+	// fails if an index does not fit. Degenerate triangles in strips are kept.
+	bool ConvertToList(
+		const AccessorData* indices,
+		size_t vertexCount,
+		Mesh::Primitive::Mode mode,
+		Accessor::ComponentType outComponentType,
+		IndexList* out,
+		std::string& outErr);
+
+	// Converts the indices of a primitive into a list; see above.
+	// The vertex count of non-indexed primitives is taken from the POSITION attribute, or any attribute if there is none.
+	bool ConvertPrimitiveToList(
+		const glTF& doc,
+		const Mesh::Primitive& primitive,
+		Accessor::ComponentType outComponentType,
+		IndexList* out,
+		std::string& outErr);
+}
+
+#endif
\ No newline at end of file
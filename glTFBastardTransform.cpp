@@ -0,0 +1,414 @@
+/*
+Copyright (c) 2016 Ruben Cashie
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation 
+files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, 
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software 
+is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES 
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE 
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "glTFBastardTransform.h"
+#include "glTFBastardMath.h"
+#include "glTFBastardParallel.h"
+#include "glTFBastardSimd.h"
+
+namespace glTFBastard {
+
+	// The matrix index of nodes given as TRS.
+	static const uint32_t NO_MATRIX = 0xffffffff;
+
+	// The fewest nodes in a subtree whose world matrices are computed by one task; fewer would not pay for the
+	// synchronization.
+	static const size_t MIN_SUBTREE_SIZE = 4096;
+
+	static bool IsIdentity(const float* matrix) {
+		for (size_t i = 0; i < 16; ++i) {
+			if (matrix[i] != (i % 5 == 0 ? 1.0f : 0.0f)) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool SceneTransforms::Build(const glTF& doc, const std::string& sceneId, std::string& outErr) {
+		FlatScene scene;
+		if (!FlattenScene(doc, sceneId, &scene, outErr)) {
+			return false;
+		}
+
+		Build(scene);
+		return true;
+	}
+
+	void SceneTransforms::Build(const FlatScene& scene) {
+		size_t count = scene.GetCount();
+		parents = scene.parents;
+		subtreeEnds = scene.subtreeEnds;
+		dirty.assign((count + 63) / 64, 0);
+		statistics = TransformUpdateStatistics();
+
+		for (size_t axis = 0; axis < 3; ++axis) {
+			translations[axis].assign(count, 0.0f);
+			scales[axis].assign(count, 1.0f);
+		}
+
+		for (size_t axis = 0; axis < 4; ++axis) {
+			rotations[axis].assign(count, axis == 3 ? 1.0f : 0.0f);
+		}
+
+		matrixIndices.assign(count, NO_MATRIX);
+		matrices.clear();
+		worldMatrices.assign(count * 16, 0.0f);
+
+		for (size_t i = 0; i < count; ++i) {
+			const Node& node = *scene.nodes[i];
+			if (node.transformType == Node::TRANSFORM_TYPE_COMPOSITE) {
+				const Node::Composite& composite = node.transform.composite;
+				for (size_t axis = 0; axis < 3; ++axis) {
+					translations[axis][i] = composite.translation[axis];
+					scales[axis][i] = composite.scale[axis];
+				}
+
+				for (size_t axis = 0; axis < 4; ++axis) {
+					rotations[axis][i] = composite.rotation[axis];
+				}
+			}
+			else if (!IsIdentity(node.transform.matrix)) {
+				SetMatrix(static_cast<uint32_t>(i), node.transform.matrix);
+			}
+		}
+
+		// Subtrees small enough for one task are split off the top of the hierarchy; the nodes above them are
+		// shared by several tasks and are computed first.
+		size_t subtreeSize = std::max(count / (GetParallelThreadCount() * 4), MIN_SUBTREE_SIZE);
+		sharedNodes.clear();
+		subtrees.clear();
+		for (uint32_t i = 0; i < count;) {
+			if (scene.subtreeEnds[i] - i <= subtreeSize) {
+				// Neighbouring small subtrees are merged into one task.
+				if (!subtrees.empty() && subtrees.back().second == i && scene.subtreeEnds[i] - subtrees.back().first <= subtreeSize) {
+					subtrees.back().second = scene.subtreeEnds[i];
+				}
+				else {
+					subtrees.push_back(std::make_pair(i, scene.subtreeEnds[i]));
+				}
+
+				i = scene.subtreeEnds[i];
+			}
+			else {
+				sharedNodes.push_back(i);
+				++i;
+			}
+		}
+
+		MarkAllDirty();
+	}
+
+	void SceneTransforms::SwitchToComposite(uint32_t node) {
+		if (matrixIndices[node] != NO_MATRIX) {
+			matrixIndices[node] = NO_MATRIX;
+			for (size_t axis = 0; axis < 3; ++axis) {
+				translations[axis][node] = 0.0f;
+				scales[axis][node] = 1.0f;
+			}
+
+			for (size_t axis = 0; axis < 4; ++axis) {
+				rotations[axis][node] = axis == 3 ? 1.0f : 0.0f;
+			}
+		}
+	}
+
+	void SceneTransforms::SetTranslation(uint32_t node, const float* translation) {
+		MarkDirty(node);
+		SwitchToComposite(node);
+		for (size_t axis = 0; axis < 3; ++axis) {
+			translations[axis][node] = translation[axis];
+		}
+	}
+
+	void SceneTransforms::SetRotation(uint32_t node, const float* rotation) {
+		MarkDirty(node);
+		SwitchToComposite(node);
+		for (size_t axis = 0; axis < 4; ++axis) {
+			rotations[axis][node] = rotation[axis];
+		}
+	}
+
+	void SceneTransforms::SetScale(uint32_t node, const float* scale) {
+		MarkDirty(node);
+		SwitchToComposite(node);
+		for (size_t axis = 0; axis < 3; ++axis) {
+			scales[axis][node] = scale[axis];
+		}
+	}
+
+	void SceneTransforms::SetMatrix(uint32_t node, const float* matrix) {
+		MarkDirty(node);
+
+		// A node that switches back and forth reuses its slot.
+		if (matrixIndices[node] == NO_MATRIX) {
+			matrixIndices[node] = static_cast<uint32_t>(matrices.size() / 16);
+			matrices.resize(matrices.size() + 16);
+		}
+
+		memcpy(&matrices[matrixIndices[node] * 16], matrix, 16 * sizeof(float));
+	}
+
+#if defined(GLTF_BASTARD_AVX2)
+	typedef __m256 TransformVector;
+	static const size_t TRANSFORM_VECTOR_WIDTH = 8;
+
+	static inline TransformVector LoadVector(const float* values) {
+		return _mm256_loadu_ps(values);
+	}
+
+	static inline TransformVector SetVector(float value) {
+		return _mm256_set1_ps(value);
+	}
+
+	static inline TransformVector Add(TransformVector a, TransformVector b) {
+		return _mm256_add_ps(a, b);
+	}
+
+	static inline TransformVector Subtract(TransformVector a, TransformVector b) {
+		return _mm256_sub_ps(a, b);
+	}
+
+	static inline TransformVector Multiply(TransformVector a, TransformVector b) {
+		return _mm256_mul_ps(a, b);
+	}
+
+	// Transposes four vectors of components into one column of a matrix for each of eight nodes.
+	static inline void StoreColumns(TransformVector x, TransformVector y, TransformVector z, TransformVector w, float* matrices, size_t column) {
+		__m256 xy0 = _mm256_unpacklo_ps(x, y);
+		__m256 zw0 = _mm256_unpacklo_ps(z, w);
+		__m256 xy1 = _mm256_unpackhi_ps(x, y);
+		__m256 zw1 = _mm256_unpackhi_ps(z, w);
+
+		__m256 columns[4] = {
+			_mm256_shuffle_ps(xy0, zw0, 0x44),
+			_mm256_shuffle_ps(xy0, zw0, 0xee),
+			_mm256_shuffle_ps(xy1, zw1, 0x44),
+			_mm256_shuffle_ps(xy1, zw1, 0xee)
+		};
+
+		// Each 128 bit half holds the columns of four nodes; the low halves are nodes 0 to 3.
+		for (size_t lane = 0; lane < 4; ++lane) {
+			_mm_storeu_ps(matrices + lane * 16 + column * 4, _mm256_castps256_ps128(columns[lane]));
+			_mm_storeu_ps(matrices + (lane + 4) * 16 + column * 4, _mm256_extractf128_ps(columns[lane], 1));
+		}
+	}
+#elif defined(GLTF_BASTARD_SSE2)
+	typedef __m128 TransformVector;
+	static const size_t TRANSFORM_VECTOR_WIDTH = 4;
+
+	static inline TransformVector LoadVector(const float* values) {
+		return _mm_loadu_ps(values);
+	}
+
+	static inline TransformVector SetVector(float value) {
+		return _mm_set1_ps(value);
+	}
+
+	static inline TransformVector Add(TransformVector a, TransformVector b) {
+		return _mm_add_ps(a, b);
+	}
+
+	static inline TransformVector Subtract(TransformVector a, TransformVector b) {
+		return _mm_sub_ps(a, b);
+	}
+
+	static inline TransformVector Multiply(TransformVector a, TransformVector b) {
+		return _mm_mul_ps(a, b);
+	}
+
+	// Transposes four vectors of components into one column of a matrix for each of four nodes.
+	static inline void StoreColumns(TransformVector x, TransformVector y, TransformVector z, TransformVector w, float* matrices, size_t column) {
+		_MM_TRANSPOSE4_PS(x, y, z, w);
+		_mm_storeu_ps(matrices + column * 4, x);
+		_mm_storeu_ps(matrices + 16 + column * 4, y);
+		_mm_storeu_ps(matrices + 32 + column * 4, z);
+		_mm_storeu_ps(matrices + 48 + column * 4, w);
+	}
+#endif
+
+	// Composes the local matrices of [begin, end) into consecutive matrices.
+	void SceneTransforms::ComposeLocalMatrices(size_t begin, size_t end, float* outMatrices) const {
+		size_t i = begin;
+
+#if defined(GLTF_BASTARD_SSE2)
+		// The same arithmetic as ComposeMatrix, on a vector of nodes at a time.
+		TransformVector zero = SetVector(0.0f);
+		TransformVector one = SetVector(1.0f);
+		TransformVector two = SetVector(2.0f);
+		for (; i + TRANSFORM_VECTOR_WIDTH <= end; i += TRANSFORM_VECTOR_WIDTH) {
+			TransformVector x = LoadVector(&rotations[0][i]);
+			TransformVector y = LoadVector(&rotations[1][i]);
+			TransformVector z = LoadVector(&rotations[2][i]);
+			TransformVector w = LoadVector(&rotations[3][i]);
+
+			TransformVector xx = Multiply(x, x);
+			TransformVector yy = Multiply(y, y);
+			TransformVector zz = Multiply(z, z);
+			TransformVector xy = Multiply(x, y);
+			TransformVector xz = Multiply(x, z);
+			TransformVector yz = Multiply(y, z);
+			TransformVector xw = Multiply(x, w);
+			TransformVector yw = Multiply(y, w);
+			TransformVector zw = Multiply(z, w);
+
+			TransformVector sx = LoadVector(&scales[0][i]);
+			TransformVector sy = LoadVector(&scales[1][i]);
+			TransformVector sz = LoadVector(&scales[2][i]);
+
+			float* out = outMatrices + (i - begin) * 16;
+			StoreColumns(
+				Multiply(Subtract(one, Multiply(two, Add(yy, zz))), sx),
+				Multiply(Multiply(two, Add(xy, zw)), sx),
+				Multiply(Multiply(two, Subtract(xz, yw)), sx),
+				zero,
+				out,
+				0);
+
+			StoreColumns(
+				Multiply(Multiply(two, Subtract(xy, zw)), sy),
+				Multiply(Subtract(one, Multiply(two, Add(xx, zz))), sy),
+				Multiply(Multiply(two, Add(yz, xw)), sy),
+				zero,
+				out,
+				1);
+
+			StoreColumns(
+				Multiply(Multiply(two, Add(xz, yw)), sz),
+				Multiply(Multiply(two, Subtract(yz, xw)), sz),
+				Multiply(Subtract(one, Multiply(two, Add(xx, yy))), sz),
+				zero,
+				out,
+				2);
+
+			StoreColumns(
+				LoadVector(&translations[0][i]),
+				LoadVector(&translations[1][i]),
+				LoadVector(&translations[2][i]),
+				one,
+				out,
+				3);
+		}
+#endif
+
+		for (; i < end; ++i) {
+			float translation[3] = {translations[0][i], translations[1][i], translations[2][i]};
+			float rotation[4] = {rotations[0][i], rotations[1][i], rotations[2][i], rotations[3][i]};
+			float scale[3] = {scales[0][i], scales[1][i], scales[2][i]};
+			ComposeMatrix(translation, rotation, scale, outMatrices + (i - begin) * 16);
+		}
+
+		// Nodes given as matrices were composed from the identity above and are overwritten.
+		for (i = begin; i < end; ++i) {
+			if (matrixIndices[i] != NO_MATRIX) {
+				memcpy(outMatrices + (i - begin) * 16, &matrices[matrixIndices[i] * 16], 16 * sizeof(float));
+			}
+		}
+	}
+
+	// Local matrices are composed in blocks of this many nodes on the stack.
+	static const size_t LOCAL_BLOCK_SIZE = 32;
+
+	void SceneTransforms::ComputeWorldMatrices(size_t begin, size_t end) {
+		float locals[LOCAL_BLOCK_SIZE * 16];
+		for (size_t blockBegin = begin; blockBegin < end; blockBegin += LOCAL_BLOCK_SIZE) {
+			size_t blockEnd = std::min(blockBegin + LOCAL_BLOCK_SIZE, end);
+			ComposeLocalMatrices(blockBegin, blockEnd, locals);
+
+			for (size_t i = blockBegin; i < blockEnd; ++i) {
+				const float* local = &locals[(i - blockBegin) * 16];
+				uint32_t parent = parents[i];
+				if (parent == FLAT_SCENE_NO_PARENT) {
+					memcpy(&worldMatrices[i * 16], local, 16 * sizeof(float));
+				}
+				else {
+					MultiplyMatricesVector(&worldMatrices[parent * 16], local, &worldMatrices[i * 16]);
+				}
+			}
+		}
+	}
+
+	void SceneTransforms::MarkAllDirty() {
+		std::fill(dirty.begin(), dirty.end(), ~static_cast<uint64_t>(0));
+		if (GetCount() % 64) {
+			dirty.back() = (static_cast<uint64_t>(1) << (GetCount() % 64)) - 1;
+		}
+	}
+
+	void SceneTransforms::Update() {
+		// Dirty nodes within the subtree of another dirty node are recomputed with it, so the scan skips over the
+		// rest of every dirty subtree it finds.
+		statistics.dirtyNodeCount = 0;
+		statistics.recomputedNodeCount = 0;
+		dirtySubtrees.clear();
+
+		size_t count = GetCount();
+		for (size_t i = 0; i < count;) {
+			uint64_t word = dirty[i / 64] >> (i % 64);
+			if (!word) {
+				i = (i / 64 + 1) * 64;
+			}
+			else if (word & 1) {
+				dirtySubtrees.push_back(std::make_pair(static_cast<uint32_t>(i), subtreeEnds[i]));
+				statistics.recomputedNodeCount += subtreeEnds[i] - i;
+				i = subtreeEnds[i];
+			}
+			else {
+				++i;
+			}
+		}
+
+		for (uint64_t& word : dirty) {
+			for (uint64_t bits = word; bits; bits &= bits - 1) {
+				++statistics.dirtyNodeCount;
+			}
+
+			word = 0;
+		}
+
+		statistics.dirtySubtreeCount = dirtySubtrees.size();
+		statistics.totalRecomputedNodeCount += statistics.recomputedNodeCount;
+		++statistics.updateCount;
+
+		if (statistics.recomputedNodeCount * 2 > count) {
+			// Most of the hierarchy is dirty; recompute all of it, split up by subtree.
+			for (uint32_t node : sharedNodes) {
+				ComputeWorldMatrices(node, node + 1);
+			}
+
+			ParallelFor(subtrees.size(), 1, [this](size_t begin, size_t end) {
+				for (size_t s = begin; s < end; ++s) {
+					ComputeWorldMatrices(subtrees[s].first, subtrees[s].second);
+				}
+			});
+		}
+		else if (statistics.recomputedNodeCount >= MIN_SUBTREE_SIZE) {
+			// The ancestors of dirty subtrees are clean, so the subtrees are independent. Each task gets about
+			// MIN_SUBTREE_SIZE nodes.
+			size_t grainSize = std::max(dirtySubtrees.size() * MIN_SUBTREE_SIZE / statistics.recomputedNodeCount, static_cast<size_t>(1));
+			ParallelFor(dirtySubtrees.size(), grainSize, [this](size_t begin, size_t end) {
+				for (size_t s = begin; s < end; ++s) {
+					ComputeWorldMatrices(dirtySubtrees[s].first, dirtySubtrees[s].second);
+				}
+			});
+		}
+		else {
+			for (auto& subtree : dirtySubtrees) {
+				ComputeWorldMatrices(subtree.first, subtree.second);
+			}
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,128 @@
+/*
+Copyright (c) 2016 Ruben Cashie
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation 
+files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, 
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software 
+is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES 
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE 
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef GLTF_BASTARD_TRANSFORM_H
+#define GLTF_BASTARD_TRANSFORM_H
+
+#include "glTFBastardSceneGraph.h"
+
+namespace glTFBastard {
+
+	struct TransformUpdateStatistics {
+		size_t updateCount;
+
+		// Of the last update: the nodes whose transforms were set since the one before, the roots of the subtrees
+		// that were recomputed because of them, and the number of nodes in those subtrees.
+		size_t dirtyNodeCount;
+		size_t dirtySubtreeCount;
+		size_t recomputedNodeCount;
+
+		// The nodes recomputed by every update so far.
+		size_t totalRecomputedNodeCount;
+
+		TransformUpdateStatistics() :
+			updateCount(0),
+			dirtyNodeCount(0),
+			dirtySubtreeCount(0),
+			recomputedNodeCount(0),
+			totalRecomputedNodeCount(0) {
+		}
+	};
+
+	// The local and world transforms of a flattened scene.
+	// Translation, rotation and scale are kept as structure of arrays, one array per component, and are converted
+	// to matrices several nodes at a time with SSE2 or AVX2 when the library is compiled with them. Each block of
+	// local matrices is multiplied with the world matrices of its parents right away, in hierarchy order, so the
+	// only matrices written to memory are the world ones. Subtrees are spread across threads.
+	// Nodes given as a matrix keep it, unless it is the identity, until one of their TRS components is set.
+	// Setting a transform marks its node dirty in a bitset over the flattened hierarchy, and an update only
+	// recomputes the subtrees of dirty nodes.
+	// Matrices are 16 floats, column major.
+	class SceneTransforms {
+	public:
+		// Flattens a scene and reads the local transforms of its nodes.
+		bool Build(const glTF& doc, const std::string& sceneId, std::string& outErr);
+
+		// Reads the local transforms of the nodes of an already flattened scene.
+		void Build(const FlatScene& scene);
+
+		size_t GetCount() const {
+			return parents.size();
+		}
+
+		// Setting any component of a node that is given as a matrix switches it to TRS, starting from the identity.
+		void SetTranslation(uint32_t node, const float* translation);
+		void SetRotation(uint32_t node, const float* rotation);
+		void SetScale(uint32_t node, const float* scale);
+		void SetMatrix(uint32_t node, const float* matrix);
+
+		// Recomputes the world matrices of the subtrees of the nodes whose transforms were set since the last
+		// update. Every node is dirty after Build.
+		void Update();
+
+		// Marks every node dirty, so that the next update recomputes everything.
+		void MarkAllDirty();
+
+		const TransformUpdateStatistics& GetStatistics() const {
+			return statistics;
+		}
+
+		const float* GetWorldMatrix(uint32_t node) const {
+			return &worldMatrices[node * 16];
+		}
+
+		const std::vector<float>& GetWorldMatrices() const {
+			return worldMatrices;
+		}
+
+		const std::vector<uint32_t>& GetParents() const {
+			return parents;
+		}
+
+	private:
+		void MarkDirty(uint32_t node) {
+			dirty[node / 64] |= static_cast<uint64_t>(1) << (node % 64);
+		}
+
+		void SwitchToComposite(uint32_t node);
+		void ComposeLocalMatrices(size_t begin, size_t end, float* outMatrices) const;
+		void ComputeWorldMatrices(size_t begin, size_t end);
+
+		std::vector<uint32_t> parents;
+		std::vector<uint32_t> subtreeEnds;
+
+		std::vector<float> translations[3];
+		std::vector<float> rotations[4];
+		std::vector<float> scales[3];
+
+		// The index of each node's matrix within matrices, if it has one.
+		std::vector<uint32_t> matrixIndices;
+		std::vector<float> matrices;
+
+		std::vector<float> worldMatrices;
+
+		// Nodes above the subtrees that are handled by separate tasks, and those subtrees, as ranges.
+		std::vector<uint32_t> sharedNodes;
+		std::vector<std::pair<uint32_t, uint32_t>> subtrees;
+
+		// One bit per node.
+		std::vector<uint64_t> dirty;
+		std::vector<std::pair<uint32_t, uint32_t>> dirtySubtrees;
+		TransformUpdateStatistics statistics;
+	};
+}
+
+#endif
\ No newline at end of file
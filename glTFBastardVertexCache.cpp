@@ -0,0 +1,400 @@
+/*
+Copyright (c) 2016 Ruben Cashie
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation 
+files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, 
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software 
+is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES 
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE 
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <algorithm>
+#include "glTFBastardBounds.h"
+#include "glTFBastardBuilder.h"
+#include "glTFBastardParallel.h"
+#include "glTFBastardTopology.h"
+#include "glTFBastardVertexCache.h"
+
+namespace glTFBastard {
+
+	static const uint32_t INVALID_INDEX = 0xFFFFFFFF;
+
+	// Simulates a FIFO vertex cache of the specified size over a triangle list.
+	VertexCacheStatistics AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, size_t cacheSize) {
+		// A vertex is in the cache if fewer than cacheSize misses happened since it was last loaded.
+		std::vector<size_t> loadedAt(vertexCount, static_cast<size_t>(-1));
+		size_t misses = 0;
+		size_t referenced = 0;
+
+		for (size_t i = 0; i < indexCount; ++i) {
+			uint32_t vertex = indices[i];
+			if (loadedAt[vertex] == static_cast<size_t>(-1)) {
+				++referenced;
+			}
+			else if (misses - loadedAt[vertex] <= cacheSize) {
+				continue;
+			}
+
+			loadedAt[vertex] = misses++;
+		}
+
+		VertexCacheStatistics result;
+		size_t triangleCount = indexCount / 3;
+		result.acmr = triangleCount ? static_cast<float>(misses) / triangleCount : 0.0f;
+		result.atvr = referenced ? static_cast<float>(misses) / referenced : 0.0f;
+		return result;
+	}
+
+	// Reorders the triangles of a triangle list with Tipsify.
+	void OptimizeTriangleOrder(const uint32_t* indices, size_t indexCount, size_t vertexCount, size_t cacheSize, uint32_t* outIndices) {
+		size_t triangleCount = indexCount / 3;
+		size_t outCount = 0;
+
+		// The triangles that each vertex is part of, and how many of them have not been emitted yet.
+		std::vector<uint32_t> liveCount(vertexCount, 0);
+		for (size_t i = 0; i < triangleCount * 3; ++i) {
+			++liveCount[indices[i]];
+		}
+
+		std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+		for (size_t v = 0; v < vertexCount; ++v) {
+			adjacencyOffsets[v + 1] = adjacencyOffsets[v] + liveCount[v];
+		}
+
+		std::vector<uint32_t> adjacency(triangleCount * 3);
+		{
+			std::vector<uint32_t> cursor(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			for (size_t i = 0; i < triangleCount * 3; ++i) {
+				adjacency[cursor[indices[i]]++] = static_cast<uint32_t>(i / 3);
+			}
+		}
+
+		// Cache timestamps start far enough in the past for every vertex to miss.
+		std::vector<size_t> cacheTime(vertexCount, 0);
+		size_t time = cacheSize + 1;
+
+		std::vector<char> emitted(triangleCount, 0);
+		std::vector<uint32_t> deadEnds;
+		std::vector<uint32_t> candidates;
+		size_t scanCursor = 1;
+
+		long long fanning = vertexCount ? 0 : -1;
+		while (fanning >= 0) {
+			candidates.clear();
+
+			// Emit every remaining triangle around the fanning vertex.
+			for (uint32_t a = adjacencyOffsets[fanning]; a < adjacencyOffsets[fanning + 1]; ++a) {
+				uint32_t triangle = adjacency[a];
+				if (emitted[triangle]) {
+					continue;
+				}
+
+				for (size_t corner = 0; corner < 3; ++corner) {
+					uint32_t vertex = indices[triangle * 3 + corner];
+					outIndices[outCount++] = vertex;
+					deadEnds.push_back(vertex);
+					candidates.push_back(vertex);
+					--liveCount[vertex];
+
+					if (time - cacheTime[vertex] > cacheSize) {
+						cacheTime[vertex] = time++;
+					}
+				}
+
+				emitted[triangle] = 1;
+			}
+
+			// Pick the candidate that will still be in the cache when its remaining triangles are emitted
+			// and that has been in the cache the longest.
+			long long next = -1;
+			long long bestPriority = -1;
+			for (uint32_t vertex : candidates) {
+				if (!liveCount[vertex]) {
+					continue;
+				}
+
+				long long priority = 0;
+				if (time - cacheTime[vertex] + 2 * liveCount[vertex] <= cacheSize) {
+					priority = static_cast<long long>(time - cacheTime[vertex]);
+				}
+
+				if (priority > bestPriority) {
+					bestPriority = priority;
+					next = vertex;
+				}
+			}
+
+			// Otherwise back track through recently used vertices, then scan for any vertex with work left.
+			while (next < 0 && !deadEnds.empty()) {
+				uint32_t vertex = deadEnds.back();
+				deadEnds.pop_back();
+				if (liveCount[vertex]) {
+					next = vertex;
+				}
+			}
+
+			while (next < 0 && scanCursor < vertexCount) {
+				if (liveCount[scanCursor]) {
+					next = static_cast<long long>(scanCursor);
+				}
+
+				++scanCursor;
+			}
+
+			fanning = next;
+		}
+
+		// A trailing partial triangle is kept as is.
+		for (size_t i = triangleCount * 3; i < indexCount; ++i) {
+			outIndices[outCount++] = indices[i];
+		}
+	}
+
+	// Renumbers vertices in the order that the triangles first reference them.
+	void OptimizeVertexFetch(uint32_t* indices, size_t indexCount, size_t vertexCount, std::vector<uint32_t>* outRemap) {
+		std::vector<uint32_t> newIndices(vertexCount, INVALID_INDEX);
+		outRemap->clear();
+		outRemap->reserve(vertexCount);
+
+		for (size_t i = 0; i < indexCount; ++i) {
+			uint32_t& newIndex = newIndices[indices[i]];
+			if (newIndex == INVALID_INDEX) {
+				newIndex = static_cast<uint32_t>(outRemap->size());
+				outRemap->push_back(indices[i]);
+			}
+
+			indices[i] = newIndex;
+		}
+
+		for (size_t v = 0; v < vertexCount; ++v) {
+			if (newIndices[v] == INVALID_INDEX) {
+				outRemap->push_back(static_cast<uint32_t>(v));
+			}
+		}
+	}
+
+	// The work and results for a single primitive.
+	struct VertexCacheJob {
+		Mesh::Primitive* primitive;
+		AccessorData indexData;
+		std::vector<std::pair<std::string, AccessorData>> attributeData;
+		bool canReorderVertices;
+
+		VertexCacheReport report;
+		std::string error;
+		bool changed;
+		std::vector<uint32_t> indices;
+		std::vector<std::vector<unsigned char>> attributes;
+
+		VertexCacheJob() :
+			primitive(nullptr),
+			canReorderVertices(false),
+			changed(false) {
+		}
+	};
+
+	// Optimizes a single primitive without touching the document.
+	static void RunVertexCacheJob(const VertexCacheOptions& options, VertexCacheJob* job) {
+		if (!ReadIndices(job->indexData, &job->indices, job->error)) {
+			return;
+		}
+
+		size_t vertexCount = 0;
+		for (uint32_t index : job->indices) {
+			vertexCount = std::max<size_t>(vertexCount, index + 1);
+		}
+
+		for (auto& attribute : job->attributeData) {
+			if (attribute.second.count < vertexCount) {
+				job->error = "An index of mesh '" + job->report.mesh + "' is out of the range of attribute '" + attribute.first + "'.";
+				return;
+			}
+
+			if (attribute.second.count != job->attributeData[0].second.count) {
+				job->canReorderVertices = false;
+			}
+		}
+
+		if (!job->attributeData.empty()) {
+			vertexCount = job->attributeData[0].second.count;
+		}
+
+		size_t cacheSize = options.cacheSize;
+		job->report.before = AnalyzeVertexCache(job->indices.data(), job->indices.size(), vertexCount, cacheSize);
+
+		std::vector<uint32_t> optimized(job->indices.size());
+		OptimizeTriangleOrder(job->indices.data(), job->indices.size(), vertexCount, cacheSize, optimized.data());
+
+		VertexCacheStatistics after = AnalyzeVertexCache(optimized.data(), optimized.size(), vertexCount, cacheSize);
+		if (after.acmr < job->report.before.acmr) {
+			job->indices.swap(optimized);
+			job->report.after = after;
+			job->changed = true;
+		}
+		else {
+			job->report.after = job->report.before;
+		}
+
+		if (!options.reorderVertices || !job->canReorderVertices) {
+			return;
+		}
+
+		std::vector<uint32_t> remap;
+		OptimizeVertexFetch(job->indices.data(), job->indices.size(), vertexCount, &remap);
+
+		bool identity = true;
+		for (size_t v = 0; v < remap.size() && identity; ++v) {
+			identity = remap[v] == v;
+		}
+
+		if (identity) {
+			return;
+		}
+
+		job->attributes.resize(job->attributeData.size());
+		for (size_t a = 0; a < job->attributeData.size(); ++a) {
+			const AccessorData& source = job->attributeData[a].second;
+			size_t elementSize = GetComponentCount(source.type) * GetComponentSize(source.componentType);
+
+			std::vector<unsigned char>& reordered = job->attributes[a];
+			reordered.resize(vertexCount * elementSize);
+			for (size_t v = 0; v < vertexCount; ++v) {
+				memcpy(&reordered[v * elementSize], source.data + remap[v] * source.byteStride, elementSize);
+			}
+		}
+
+		job->report.verticesReordered = true;
+		job->changed = true;
+	}
+
+	// Reorders the triangles, and optionally the vertices, of every indexed TRIANGLES primitive in the document.
+	bool OptimizeVertexCache(glTF* doc, const VertexCacheOptions& options, std::vector<VertexCacheReport>* outReport, std::string& outErr) {
+		// Count how many primitives use each accessor; shared attributes can not be reordered for one primitive alone.
+		std::unordered_map<std::string, size_t> accessorUses;
+		for (auto& mesh : doc->meshes) {
+			for (auto& primitive : mesh.second->primitives) {
+				for (auto& attribute : primitive->attributes) {
+					++accessorUses[attribute.second];
+				}
+			}
+		}
+
+		// Resolve everything up front so that the jobs only read the document.
+		std::vector<std::string> meshIds;
+		for (auto& mesh : doc->meshes) {
+			meshIds.push_back(mesh.first);
+		}
+
+		std::sort(meshIds.begin(), meshIds.end());
+
+		std::vector<VertexCacheJob> jobs;
+		for (const std::string& meshId : meshIds) {
+			auto& primitives = doc->meshes[meshId]->primitives;
+			for (size_t p = 0; p < primitives.size(); ++p) {
+				Mesh::Primitive* primitive = primitives[p].get();
+				if (primitive->mode != Mesh::Primitive::TYPE_TRIANGLES || primitive->indices.empty()) {
+					continue;
+				}
+
+				VertexCacheJob job;
+				job.primitive = primitive;
+				job.report.mesh = meshId;
+				job.report.primitive = p;
+				job.canReorderVertices = true;
+
+				if (!GetAccessorData(*doc, primitive->indices, &job.indexData, outErr)) {
+					return false;
+				}
+
+				for (auto& attribute : primitive->attributes) {
+					AccessorData data;
+					if (!GetAccessorData(*doc, attribute.second, &data, outErr)) {
+						return false;
+					}
+
+					job.canReorderVertices = job.canReorderVertices && accessorUses[attribute.second] == 1;
+					job.attributeData.push_back(std::make_pair(attribute.first, data));
+				}
+
+				jobs.push_back(std::move(job));
+			}
+		}
+
+		ParallelFor(jobs.size(), 1, [&](size_t begin, size_t end) {
+			for (size_t j = begin; j < end; ++j) {
+				RunVertexCacheJob(options, &jobs[j]);
+			}
+		});
+
+		// Write the results into a single new buffer.
+		BufferBuilder builder;
+		std::vector<size_t> firstView(jobs.size());
+		std::vector<std::vector<unsigned char>> indexBytes(jobs.size());
+
+		for (size_t j = 0; j < jobs.size(); ++j) {
+			VertexCacheJob& job = jobs[j];
+			if (!job.error.empty()) {
+				outErr = job.error;
+				return false;
+			}
+
+			if (!job.changed) {
+				continue;
+			}
+
+			WriteIndices(job.indices, job.indexData.componentType, &indexBytes[j]);
+			firstView[j] = builder.AddView(indexBytes[j].data(), indexBytes[j].size(), BufferView::TARGET_ELEMENT_ARRAY_BUFFER);
+
+			for (auto& attribute : job.attributes) {
+				builder.AddView(attribute.data(), attribute.size(), BufferView::TARGET_ARRAY_BUFFER);
+			}
+		}
+
+		std::vector<std::string> viewIds;
+		if (builder.GetViewCount()) {
+			viewIds = builder.Commit(doc, "vertexCacheOptimized");
+		}
+
+		outReport->clear();
+		for (size_t j = 0; j < jobs.size(); ++j) {
+			VertexCacheJob& job = jobs[j];
+			outReport->push_back(job.report);
+			if (!job.changed) {
+				continue;
+			}
+
+			Mesh::Primitive* primitive = job.primitive;
+			const Accessor& indices = *doc->accessors[primitive->indices];
+			primitive->indices = AddAccessor(
+				doc, primitive->indices + "_optimized", indices, viewIds[firstView[j]], static_cast<long long>(job.indices.size()));
+
+			// Vertex fetch optimization renumbers the referenced vertices, so the copied index range is stale.
+			Accessor& optimizedIndices = *doc->accessors[primitive->indices];
+			if (!optimizedIndices.min.empty() || !optimizedIndices.max.empty()) {
+				AccessorData data;
+				if (!GetAccessorData(*doc, optimizedIndices, &data, outErr)
+					|| !ComputeAccessorMinMax(data, &optimizedIndices.min, &optimizedIndices.max, outErr)) {
+					return false;
+				}
+			}
+
+			for (size_t a = 0; a < job.attributes.size(); ++a) {
+				std::string& attributeId = primitive->attributes[job.attributeData[a].first];
+				const Accessor& attribute = *doc->accessors[attributeId];
+				std::string optimizedId = AddAccessor(
+					doc, attributeId + "_optimized", attribute, viewIds[firstView[j] + 1 + a], attribute.count);
+
+				CopyAccessorDecode(doc, attributeId, optimizedId);
+				attributeId = optimizedId;
+			}
+		}
+
+		return true;
+	}
+}
\ No newline at end of file
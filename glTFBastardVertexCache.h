@@ -0,0 +1,88 @@
+/*
+Copyright (c) 2016 Ruben Cashie
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation 
+files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, 
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software 
+is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES 
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE 
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef GLTF_BASTARD_VERTEX_CACHE_H
+#define GLTF_BASTARD_VERTEX_CACHE_H
+
+#include "glTFBastardAccessor.h"
+
+namespace glTFBastard {
+
+	// Post-transform vertex cache efficiency of a triangle list, measured with a FIFO cache.
+	struct VertexCacheStatistics {
+		// Average cache miss ratio; vertices transformed per triangle. 0.5 is the best possible, 3 the worst.
+		float acmr;
+
+		// Average transform to vertex ratio; vertices transformed per referenced vertex. 1 is the best possible.
+		float atvr;
+
+		VertexCacheStatistics() :
+			acmr(0.0f),
+			atvr(0.0f) {
+		}
+	};
+
+	// Simulates a FIFO vertex cache of the specified size over a triangle list.
+	VertexCacheStatistics AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, size_t cacheSize);
+
+	// Reorders the triangles of a triangle list for post-transform vertex cache locality with Tipsify
+	// (Sander, Nehab and Barczak, "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw").
+	// outIndices must have room for indexCount indices and may not alias indices.
+	void OptimizeTriangleOrder(const uint32_t* indices, size_t indexCount, size_t vertexCount, size_t cacheSize, uint32_t* outIndices);
+
+	// Renumbers vertices in the order that the triangles first reference them so that vertex fetches are sequential.
+	// The indices are rewritten in place. outRemap receives the old index of every new vertex; vertices that are
+	// not referenced keep their relative order after the referenced ones.
+	void OptimizeVertexFetch(uint32_t* indices, size_t indexCount, size_t vertexCount, std::vector<uint32_t>* outRemap);
+
+	struct VertexCacheOptions {
+		// The number of entries of the simulated FIFO cache that triangles are ordered for.
+		size_t cacheSize;
+
+		// Whether to also reorder the vertex attributes of each primitive to match its new triangle order.
+		bool reorderVertices;
+
+		VertexCacheOptions() :
+			cacheSize(16),
+			reorderVertices(true) {
+		}
+	};
+
+	// The effect of the optimization on one primitive.
+	struct VertexCacheReport {
+		std::string mesh;
+		size_t primitive;
+		VertexCacheStatistics before;
+		VertexCacheStatistics after;
+
+		// False when the vertices could not be reordered because an attribute accessor is shared with another primitive
+		// or the attributes have different counts.
+		bool verticesReordered;
+
+		VertexCacheReport() :
+			primitive(0),
+			verticesReordered(false) {
+		}
+	};
+
+	// Reorders the triangles, and optionally the vertices, of every indexed TRIANGLES primitive in the document.
+	// Primitives are optimized in parallel. The results are written to a new buffer; each optimized primitive gets
+	// new index and attribute accessors while the original accessors are left untouched.
+	// The buffers of every optimized primitive must have been loaded.
+	bool OptimizeVertexCache(glTF* doc, const VertexCacheOptions& options, std::vector<VertexCacheReport>* outReport, std::string& outErr);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,407 @@
+/*
+Copyright (c) 2016 Ruben Cashie
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation 
+files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, 
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software 
+is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES 
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE 
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include "glTFBastardBounds.h"
+#include "glTFBastardBuilder.h"
+#include "glTFBastardParallel.h"
+#include "glTFBastardTopology.h"
+#include "glTFBastardWeld.h"
+
+namespace glTFBastard {
+
+	const uint32_t WELD_UNUSED_VERTEX = 0xFFFFFFFF;
+
+	// Returns the number of key bytes a vertex attribute contributes.
+	static size_t GetKeySize(const AccessorData& attribute, float epsilon) {
+		size_t componentCount = GetComponentCount(attribute.type);
+		if (attribute.componentType == Accessor::COMPONENT_TYPE_FLOAT && epsilon > 0.0f) {
+			return componentCount * sizeof(double);
+		}
+
+		return componentCount * GetComponentSize(attribute.componentType);
+	}
+
+	// Writes the bytes that identify a vertex.
+	static void BuildVertexKey(const std::vector<AccessorData>& attributes, size_t vertex, float epsilon, unsigned char* out) {
+		for (const AccessorData& attribute : attributes) {
+			const unsigned char* element = attribute.data + vertex * attribute.byteStride;
+			size_t componentCount = GetComponentCount(attribute.type);
+
+			if (attribute.componentType == Accessor::COMPONENT_TYPE_FLOAT && epsilon > 0.0f) {
+				for (size_t c = 0; c < componentCount; ++c) {
+					float value;
+					memcpy(&value, element + c * sizeof(float), sizeof(float));
+
+					// Adding zero folds -0 into +0; non-finite values keep their bits.
+					double snapped = std::isfinite(value) ? std::floor(value / static_cast<double>(epsilon) + 0.5) + 0.0 : value;
+					memcpy(out, &snapped, sizeof(snapped));
+					out += sizeof(snapped);
+				}
+			}
+			else {
+				size_t size = componentCount * GetComponentSize(attribute.componentType);
+				memcpy(out, element, size);
+				out += size;
+			}
+		}
+	}
+
+	// FNV-1a.
+	static uint64_t HashKey(const unsigned char* key, size_t size) {
+		uint64_t hash = 14695981039346656037ULL;
+		for (size_t i = 0; i < size; ++i) {
+			hash = (hash ^ key[i]) * 1099511628211ULL;
+		}
+
+		return hash;
+	}
+
+	// Assigns the same new index to vertices whose attributes are all equal.
+	size_t GenerateVertexRemap(
+		const std::vector<AccessorData>& attributes,
+		const std::vector<uint32_t>& indices,
+		float epsilon,
+		std::vector<uint32_t>* outRemap) {
+
+		size_t vertexCount = attributes.empty() ? 0 : attributes[0].count;
+		outRemap->assign(vertexCount, WELD_UNUSED_VERTEX);
+
+		size_t keySize = 0;
+		for (const AccessorData& attribute : attributes) {
+			keySize += GetKeySize(attribute, epsilon);
+		}
+
+		// An open addressing table of new indices, at most half full; the keys of unique vertices are kept alongside.
+		size_t tableSize = 1;
+		while (tableSize < vertexCount * 2) {
+			tableSize *= 2;
+		}
+
+		std::vector<uint32_t> table(tableSize, WELD_UNUSED_VERTEX);
+		std::vector<unsigned char> uniqueKeys;
+		std::vector<unsigned char> key(keySize);
+		size_t uniqueCount = 0;
+
+		for (uint32_t vertex : indices) {
+			if ((*outRemap)[vertex] != WELD_UNUSED_VERTEX) {
+				continue;
+			}
+
+			BuildVertexKey(attributes, vertex, epsilon, key.data());
+
+			size_t slot = static_cast<size_t>(HashKey(key.data(), keySize)) & (tableSize - 1);
+			while (table[slot] != WELD_UNUSED_VERTEX
+				&& (keySize && memcmp(&uniqueKeys[table[slot] * keySize], key.data(), keySize) != 0)) {
+				slot = (slot + 1) & (tableSize - 1);
+			}
+
+			if (table[slot] == WELD_UNUSED_VERTEX) {
+				table[slot] = static_cast<uint32_t>(uniqueCount++);
+				uniqueKeys.insert(uniqueKeys.end(), key.begin(), key.end());
+			}
+
+			(*outRemap)[vertex] = table[slot];
+		}
+
+		return uniqueCount;
+	}
+
+	// A primitive that is welded as part of a group.
+	struct WeldPrimitive {
+		Mesh::Primitive* primitive;
+		WeldReport report;
+		bool indexed;
+		AccessorData indexData;
+		std::vector<uint32_t> indices;
+		Accessor::ComponentType componentType;
+	};
+
+	// The primitives that share the same attribute accessors, and the results of welding them.
+	struct WeldGroup {
+		std::vector<std::string> attributeIds;
+		std::vector<AccessorData> attributeData;
+		std::vector<WeldPrimitive> primitives;
+
+		std::string error;
+		bool changed;
+		size_t uniqueCount;
+		std::vector<std::vector<unsigned char>> attributes;
+
+		WeldGroup() :
+			changed(false),
+			uniqueCount(0) {
+		}
+	};
+
+	// Welds a group of primitives without touching the document.
+	static void RunWeldGroup(const WeldOptions& options, WeldGroup* group) {
+		size_t vertexCount = group->attributeData[0].count;
+		for (const AccessorData& attribute : group->attributeData) {
+			if (attribute.count != vertexCount) {
+				group->error = "The attributes of a primitive of mesh '" + group->primitives[0].report.mesh + "' have different counts.";
+				return;
+			}
+		}
+
+		// Weld the vertices referenced by all primitives of the group in one go.
+		std::vector<uint32_t> allIndices;
+		for (WeldPrimitive& weldPrimitive : group->primitives) {
+			if (weldPrimitive.indexed) {
+				if (!ReadIndices(weldPrimitive.indexData, &weldPrimitive.indices, group->error)) {
+					return;
+				}
+
+				for (uint32_t index : weldPrimitive.indices) {
+					if (index >= vertexCount) {
+						group->error = "An index of mesh '" + weldPrimitive.report.mesh + "' is out of the range of its attributes.";
+						return;
+					}
+				}
+			}
+			else {
+				weldPrimitive.indices.resize(vertexCount);
+				for (size_t v = 0; v < vertexCount; ++v) {
+					weldPrimitive.indices[v] = static_cast<uint32_t>(v);
+				}
+			}
+
+			allIndices.insert(allIndices.end(), weldPrimitive.indices.begin(), weldPrimitive.indices.end());
+		}
+
+		std::vector<uint32_t> remap;
+		group->uniqueCount = GenerateVertexRemap(group->attributeData, allIndices, options.epsilon, &remap);
+
+		bool identity = group->uniqueCount == vertexCount;
+		for (size_t v = 0; v < vertexCount && identity; ++v) {
+			identity = remap[v] == v;
+		}
+
+		for (WeldPrimitive& weldPrimitive : group->primitives) {
+			weldPrimitive.report.vertexCountBefore = vertexCount;
+			weldPrimitive.report.vertexCountAfter = group->uniqueCount;
+			identity = identity && weldPrimitive.indexed;
+		}
+
+		if (identity) {
+			return;
+		}
+
+		for (WeldPrimitive& weldPrimitive : group->primitives) {
+			uint32_t maxIndex = 0;
+			for (uint32_t& index : weldPrimitive.indices) {
+				index = remap[index];
+				maxIndex = std::max(maxIndex, index);
+			}
+
+			weldPrimitive.componentType = GetSmallestIndexComponentType(maxIndex);
+		}
+
+		// Copy the first vertex of every set of equal vertices.
+		std::vector<uint32_t> representatives(group->uniqueCount);
+		for (size_t v = vertexCount; v-- > 0;) {
+			if (remap[v] != WELD_UNUSED_VERTEX) {
+				representatives[remap[v]] = static_cast<uint32_t>(v);
+			}
+		}
+
+		group->attributes.resize(group->attributeData.size());
+		for (size_t a = 0; a < group->attributeData.size(); ++a) {
+			const AccessorData& source = group->attributeData[a];
+			size_t elementSize = GetComponentCount(source.type) * GetComponentSize(source.componentType);
+
+			std::vector<unsigned char>& welded = group->attributes[a];
+			welded.resize(group->uniqueCount * elementSize);
+			for (size_t v = 0; v < group->uniqueCount; ++v) {
+				memcpy(&welded[v * elementSize], source.data + representatives[v] * source.byteStride, elementSize);
+			}
+		}
+
+		group->changed = true;
+	}
+
+	// Recomputes the min/max of a new accessor if its original had them.
+	static bool UpdateWeldedMinMax(glTF* doc, const std::string& accessorId, std::string& outErr) {
+		Accessor& accessor = *doc->accessors[accessorId];
+		if (accessor.min.empty() && accessor.max.empty()) {
+			return true;
+		}
+
+		AccessorData data;
+		return GetAccessorData(*doc, accessor, &data, outErr)
+			&& ComputeAccessorMinMax(data, &accessor.min, &accessor.max, outErr);
+	}
+
+	// Merges duplicate vertices and drops unreferenced ones in every primitive of the document.
+	bool WeldVertices(glTF* doc, const WeldOptions& options, std::vector<WeldReport>* outReport, std::string& outErr) {
+		std::vector<std::string> meshIds;
+		for (auto& mesh : doc->meshes) {
+			meshIds.push_back(mesh.first);
+		}
+
+		std::sort(meshIds.begin(), meshIds.end());
+
+		// Group the primitives by their attribute accessors and resolve everything up front so that the groups
+		// only read the document.
+		std::vector<WeldGroup> groups;
+		std::unordered_map<std::string, size_t> groupIndices;
+
+		for (const std::string& meshId : meshIds) {
+			auto& primitives = doc->meshes[meshId]->primitives;
+			for (size_t p = 0; p < primitives.size(); ++p) {
+				Mesh::Primitive* primitive = primitives[p].get();
+				if (primitive->attributes.empty()) {
+					continue;
+				}
+
+				std::vector<std::pair<std::string, std::string>> attributes(primitive->attributes.begin(), primitive->attributes.end());
+				std::sort(attributes.begin(), attributes.end());
+
+				std::string groupKey;
+				for (auto& attribute : attributes) {
+					groupKey += attribute.first + '\n' + attribute.second + '\n';
+				}
+
+				auto groupIndex = groupIndices.find(groupKey);
+				if (groupIndex == groupIndices.end()) {
+					WeldGroup group;
+					for (auto& attribute : attributes) {
+						if (std::find(group.attributeIds.begin(), group.attributeIds.end(), attribute.second) != group.attributeIds.end()) {
+							continue;
+						}
+
+						AccessorData data;
+						if (!GetAccessorData(*doc, attribute.second, &data, outErr)) {
+							return false;
+						}
+
+						group.attributeIds.push_back(attribute.second);
+						group.attributeData.push_back(data);
+					}
+
+					groupIndex = groupIndices.insert(std::make_pair(groupKey, groups.size())).first;
+					groups.push_back(std::move(group));
+				}
+
+				WeldPrimitive weldPrimitive;
+				weldPrimitive.primitive = primitive;
+				weldPrimitive.report.mesh = meshId;
+				weldPrimitive.report.primitive = p;
+				weldPrimitive.indexed = !primitive->indices.empty();
+				weldPrimitive.componentType = Accessor::COMPONENT_TYPE_UNSIGNED_SHORT;
+
+				if (weldPrimitive.indexed && !GetAccessorData(*doc, primitive->indices, &weldPrimitive.indexData, outErr)) {
+					return false;
+				}
+
+				groups[groupIndex->second].primitives.push_back(std::move(weldPrimitive));
+			}
+		}
+
+		ParallelFor(groups.size(), 1, [&](size_t begin, size_t end) {
+			for (size_t g = begin; g < end; ++g) {
+				RunWeldGroup(options, &groups[g]);
+			}
+		});
+
+		// Write the results into a single new buffer: the attributes of each group followed by the indices of its primitives.
+		BufferBuilder builder;
+		std::vector<size_t> firstView(groups.size());
+
+		for (size_t g = 0; g < groups.size(); ++g) {
+			WeldGroup& group = groups[g];
+			if (!group.error.empty()) {
+				outErr = group.error;
+				return false;
+			}
+
+			if (!group.changed) {
+				continue;
+			}
+
+			firstView[g] = builder.GetViewCount();
+			for (auto& attribute : group.attributes) {
+				builder.AddView(attribute.data(), attribute.size(), BufferView::TARGET_ARRAY_BUFFER);
+			}
+
+			for (WeldPrimitive& weldPrimitive : group.primitives) {
+				std::vector<unsigned char> indexBytes;
+				WriteIndices(weldPrimitive.indices, weldPrimitive.componentType, &indexBytes);
+				builder.AddView(indexBytes.data(), indexBytes.size(), BufferView::TARGET_ELEMENT_ARRAY_BUFFER);
+			}
+		}
+
+		std::vector<std::string> viewIds;
+		if (builder.GetViewCount()) {
+			viewIds = builder.Commit(doc, "welded");
+		}
+
+		outReport->clear();
+		for (size_t g = 0; g < groups.size(); ++g) {
+			WeldGroup& group = groups[g];
+			if (!group.changed) {
+				for (WeldPrimitive& weldPrimitive : group.primitives) {
+					outReport->push_back(weldPrimitive.report);
+				}
+
+				continue;
+			}
+
+			std::vector<std::string> attributeIds(group.attributeIds.size());
+			for (size_t a = 0; a < group.attributeIds.size(); ++a) {
+				const Accessor& source = *doc->accessors[group.attributeIds[a]];
+				attributeIds[a] = AddAccessor(
+					doc, group.attributeIds[a] + "_welded", source, viewIds[firstView[g] + a], static_cast<long long>(group.uniqueCount));
+				CopyAccessorDecode(doc, group.attributeIds[a], attributeIds[a]);
+
+				if (!UpdateWeldedMinMax(doc, attributeIds[a], outErr)) {
+					return false;
+				}
+			}
+
+			for (size_t p = 0; p < group.primitives.size(); ++p) {
+				WeldPrimitive& weldPrimitive = group.primitives[p];
+				Mesh::Primitive* primitive = weldPrimitive.primitive;
+
+				for (auto& attribute : primitive->attributes) {
+					size_t a = std::find(group.attributeIds.begin(), group.attributeIds.end(), attribute.second) - group.attributeIds.begin();
+					attribute.second = attributeIds[a];
+				}
+
+				Accessor indices;
+				std::string indicesPrefix = attributeIds[0] + "_indices";
+				if (weldPrimitive.indexed) {
+					indices = *doc->accessors[primitive->indices];
+					indicesPrefix = primitive->indices + "_welded";
+				}
+
+				indices.componentType = weldPrimitive.componentType;
+				indices.type = Accessor::TYPE_SCALAR;
+
+				std::string viewId = viewIds[firstView[g] + group.attributeIds.size() + p];
+				primitive->indices = AddAccessor(doc, indicesPrefix, indices, viewId, static_cast<long long>(weldPrimitive.indices.size()));
+				if (!UpdateWeldedMinMax(doc, primitive->indices, outErr)) {
+					return false;
+				}
+
+				outReport->push_back(weldPrimitive.report);
+			}
+		}
+
+		return true;
+	}
+}
\ No newline at end of file
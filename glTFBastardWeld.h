@@ -0,0 +1,71 @@
+/*
+Copyright (c) 2016 Ruben Cashie
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation 
+files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, 
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software 
+is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES 
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE 
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef GLTF_BASTARD_WELD_H
+#define GLTF_BASTARD_WELD_H
+
+#include "glTFBastardAccessor.h"
+
+namespace glTFBastard {
+
+	// Marks vertices in a remap that are not referenced by any index.
+	extern const uint32_t WELD_UNUSED_VERTEX;
+
+	// Assigns the same new index to vertices whose attributes are all equal. New indices are handed out in the
+	// order that the indices first reference the vertices, so the welded vertices are also in fetch order.
+	// Float components are compared after snapping them to a grid of the specified epsilon; integer components
+	// and all components with an epsilon of zero are compared bit for bit.
+	// outRemap receives the new index of every vertex, or WELD_UNUSED_VERTEX. Returns the number of unique vertices.
+	size_t GenerateVertexRemap(
+		const std::vector<AccessorData>& attributes,
+		const std::vector<uint32_t>& indices,
+		float epsilon,
+		std::vector<uint32_t>* outRemap);
+
+	struct WeldOptions {
+		// The distance below which float components are considered equal; zero only welds exact duplicates.
+		float epsilon;
+
+		WeldOptions() :
+			epsilon(0.0f) {
+		}
+	};
+
+	// The effect of welding on one primitive.
+	struct WeldReport {
+		std::string mesh;
+		size_t primitive;
+		size_t vertexCountBefore;
+		size_t vertexCountAfter;
+
+		WeldReport() :
+			primitive(0),
+			vertexCountBefore(0),
+			vertexCountAfter(0) {
+		}
+	};
+
+	// Merges duplicate vertices and drops unreferenced ones in every primitive of the document.
+	// Primitives that use exactly the same attribute accessors are welded together and keep sharing their new
+	// attributes. Each primitive gets a remapped indices accessor with the smallest component type that fits;
+	// non-indexed primitives become indexed, which needs OES_element_index_uint past 65536 vertices.
+	// Groups are welded in parallel and the results are written to a new buffer; the original accessors are left
+	// untouched, and the min/max of new accessors are recomputed if their originals had them.
+	// The buffers of every primitive must have been loaded.
+	bool WeldVertices(glTF* doc, const WeldOptions& options, std::vector<WeldReport>* outReport, std::string& outErr);
+}
+
+#endif
\ No newline at end of file